@@ -0,0 +1,188 @@
+#include <benchmark/benchmark.h>
+#include "concurrent_map.hpp"
+#include "read_mostly_map.hpp"
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Compares ConcurrentMap against the previous node-based, unpadded layout, and
+// ReadMostlyMap where the pattern is read-mostly, on the access patterns of
+// AuthService::tokens_ and the user/account indices.
+
+namespace {
+
+// The map as it was before the flat shards: fixed shard count, one
+// std::unordered_map per shard, shards packed next to each other.
+template<typename K, typename V, size_t Shards = 16>
+class NodeMap {
+public:
+    std::optional<V> get(const K& key) const {
+        auto& s = shard_for(key);
+        std::shared_lock lk(s.mu);
+        auto it = s.data.find(key);
+        return it != s.data.end() ? std::optional<V>(it->second) : std::nullopt;
+    }
+
+    void put(const K& key, const V& value) {
+        auto& s = shard_for(key);
+        std::unique_lock lk(s.mu);
+        s.data.insert_or_assign(key, value);
+    }
+
+    bool erase(const K& key) {
+        auto& s = shard_for(key);
+        std::unique_lock lk(s.mu);
+        return s.data.erase(key) > 0;
+    }
+
+    template<typename Factory>
+    V get_or_create(const K& key, Factory&& factory) {
+        auto& s = shard_for(key);
+        {
+            std::shared_lock lk(s.mu);
+            auto it = s.data.find(key);
+            if (it != s.data.end()) return it->second;
+        }
+        std::unique_lock lk(s.mu);
+        auto [it, inserted] = s.data.try_emplace(key);
+        if (inserted) it->second = factory();
+        return it->second;
+    }
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mu;
+        std::unordered_map<K, V> data;
+    };
+
+    mutable std::array<Shard, Shards> shards_{};
+
+    Shard& shard_for(const K& key) const {
+        return shards_[std::hash<K>{}(key) % Shards];
+    }
+};
+
+constexpr std::size_t kTokens = 10000;
+constexpr std::size_t kAccounts = 100000;
+constexpr std::size_t kUsers = 10000;
+
+std::string make_token(std::mt19937_64& rng) {
+    static const char hex[] = "0123456789abcdef";
+    std::string token(32, '0');
+    for (auto& c : token) c = hex[rng() & 15];
+    return token;
+}
+
+const std::vector<std::string>& tokens() {
+    static const auto all = [] {
+        std::mt19937_64 rng{1};
+        std::vector<std::string> out;
+        for (std::size_t i = 0; i < kTokens; ++i) out.push_back(make_token(rng));
+        return out;
+    }();
+    return all;
+}
+
+template<typename Map>
+Map& token_map() {
+    static Map map;
+    static const bool filled = [] {
+        for (std::size_t i = 0; i < kTokens; ++i) map.put(tokens()[i], i + 1);
+        return true;
+    }();
+    (void)filled;
+    return map;
+}
+
+template<typename Map>
+Map& account_map() {
+    static Map map;
+    static const bool filled = [] {
+        for (uint64_t id = 0; id < kAccounts; ++id) map.put(100001 + id, id);
+        return true;
+    }();
+    (void)filled;
+    return map;
+}
+
+template<typename Map>
+Map& user_map() {
+    static Map map;
+    static const bool filled = [] {
+        for (uint64_t id = 1; id <= kUsers; ++id) map.put(id, std::make_shared<int>(0));
+        return true;
+    }();
+    (void)filled;
+    return map;
+}
+
+// Session validation on every request, with an occasional login/logout.
+template<typename Map>
+void BM_Tokens(benchmark::State& state) {
+    auto& map = token_map<Map>();
+    std::mt19937_64 rng(state.thread_index() + 7);
+    const auto own = make_token(rng) + std::to_string(state.thread_index());
+    uint64_t n = 0;
+    for (auto _ : state) {
+        if ((++n & 63) == 0) {
+            map.put(own, n);
+            map.erase(own);
+        }
+        benchmark::DoNotOptimize(map.get(tokens()[rng() % kTokens]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Account id → record resolution, read only.
+template<typename Map>
+void BM_AccountIndex(benchmark::State& state) {
+    auto& map = account_map<Map>();
+    std::mt19937_64 rng(state.thread_index() + 11);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(map.get(100001 + rng() % kAccounts));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// User id → shared per-user state: lookups plus get_or_create on account opening.
+template<typename Map>
+void BM_Users(benchmark::State& state) {
+    auto& map = user_map<Map>();
+    std::mt19937_64 rng(state.thread_index() + 13);
+    uint64_t n = 0;
+    for (auto _ : state) {
+        const uint64_t id = 1 + rng() % kUsers;
+        if ((++n & 15) == 0)
+            benchmark::DoNotOptimize(map.get_or_create(id, [] { return std::make_shared<int>(0); }));
+        else
+            benchmark::DoNotOptimize(map.get(id));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+using NodeTokens = NodeMap<std::string, uint64_t>;
+using FlatTokens = ConcurrentMap<std::string, uint64_t>;
+using EpochTokens = ReadMostlyMap<std::string, uint64_t>;
+using NodeAccounts = NodeMap<uint64_t, uint64_t>;
+using FlatAccounts = ConcurrentMap<uint64_t, uint64_t>;
+using EpochAccounts = ReadMostlyMap<uint64_t, uint64_t>;
+using NodeUsers = NodeMap<uint64_t, std::shared_ptr<int>>;
+using FlatUsers = ConcurrentMap<uint64_t, std::shared_ptr<int>>;
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Tokens, NodeTokens)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Tokens, FlatTokens)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Tokens, EpochTokens)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AccountIndex, NodeAccounts)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AccountIndex, FlatAccounts)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AccountIndex, EpochAccounts)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Users, NodeUsers)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Users, FlatUsers)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include "order_book.hpp"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// OrderBook with up to a million resting orders: the place/cancel churn of a
+// deep book, an aggressive order walking several makers, and the per-tick
+// sweep against the simulated market. Prices are in ticks around 10000.
+
+namespace {
+
+constexpr int64_t kMid = 10000;
+constexpr int64_t kBand = 1000;  // levels per side
+
+// `orders` resting orders spread over kBand levels per side, none crossing.
+std::vector<OrderHandle> fill_book(OrderBook& book, std::size_t orders, std::mt19937_64& rng) {
+    std::vector<BookFill> fills;
+    std::vector<OrderHandle> handles;
+    handles.reserve(orders);
+    book.reserve(orders);
+    std::uniform_int_distribution<int64_t> offset(1, kBand);
+    for (std::size_t i = 0; i < orders; ++i) {
+        const Side side = i % 2 ? Side::Buy : Side::Sell;
+        const int64_t price = side == Side::Buy ? kMid - offset(rng) : kMid + offset(rng);
+        handles.push_back(book.add(side, price, 10, i, fills));
+    }
+    return handles;
+}
+
+void BM_PlaceCancel(benchmark::State& state) {
+    std::mt19937_64 rng(42);
+    OrderBook book;
+    auto handles = fill_book(book, static_cast<std::size_t>(state.range(0)), rng);
+    std::vector<BookFill> fills;
+    std::uniform_int_distribution<int64_t> offset(1, kBand);
+    std::uniform_int_distribution<std::size_t> pick(0, handles.size() - 1);
+    uint64_t tag = handles.size();
+    for (auto _ : state) {
+        // Cancel a random resting order and put a fresh one in its place.
+        auto& h = handles[pick(rng)];
+        const Side side = book.find(h)->side;
+        book.cancel(h);
+        const int64_t price = side == Side::Buy ? kMid - offset(rng) : kMid + offset(rng);
+        h = book.add(side, price, 10, ++tag, fills);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_PlaceCancel)->Arg(1 << 10)->Arg(1 << 20);
+
+void BM_AggressiveOrder(benchmark::State& state) {
+    std::mt19937_64 rng(42);
+    OrderBook book;
+    fill_book(book, static_cast<std::size_t>(state.range(0)), rng);
+    std::vector<BookFill> fills;
+    uint64_t tag = 1ull << 40;
+    int64_t matched = 0;
+    for (auto _ : state) {
+        // Lift 35 shares off the best asks, then restore the depth taken.
+        fills.clear();
+        book.add(Side::Buy, kMid + kBand, 35, ++tag, fills);
+        const std::size_t n = fills.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            if (fills[i].maker_left == 0) book.add(Side::Sell, fills[i].price, 10, ++tag, fills);
+        }
+        matched += static_cast<int64_t>(n);
+    }
+    state.SetItemsProcessed(matched);
+}
+BENCHMARK(BM_AggressiveOrder)->Arg(1 << 10)->Arg(1 << 20);
+
+void BM_TickSweep(benchmark::State& state) {
+    std::mt19937_64 rng(42);
+    OrderBook book;
+    fill_book(book, static_cast<std::size_t>(state.range(0)), rng);
+    std::vector<BookFill> fills;
+    uint64_t tag = 1ull << 40;
+    int64_t swept = 0;
+    for (auto _ : state) {
+        // The quote dips two ticks into the bids; requeue what it filled so
+        // the next tick sees the same book.
+        fills.clear();
+        const int64_t best = *book.best_bid();
+        book.sweep(best - 1, fills);
+        swept += static_cast<int64_t>(fills.size());
+        const std::size_t n = fills.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            const int64_t price = best - (i % 2);
+            book.add(Side::Buy, price, 10, ++tag, fills);
+        }
+    }
+    state.SetItemsProcessed(swept);
+}
+BENCHMARK(BM_TickSweep)->Arg(1 << 10)->Arg(1 << 20);
+
+}  // namespace
+
+BENCHMARK_MAIN();
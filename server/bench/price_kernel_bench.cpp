@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+#include "price_engine.hpp"
+#include "price_kernel.hpp"
+#include <algorithm>
+#include <vector>
+
+// Cost of one random-walk tick over N instruments. The per_instrument
+// counter is seconds per instrument per tick, printed with SI prefixes.
+// Also the per-tick cross-rate matrix build and the rate lookup it serves.
+
+namespace {
+
+template<bool Vectorized>
+void BM_RandomWalk(benchmark::State& state) {
+    const auto n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> prices(n, 100.0);
+    std::vector<double> amplitude(n, 0.03);
+    WalkRng rng(1);
+    if (Vectorized) {
+        if (!detail::random_walk_step_avx2(prices.data(), amplitude.data(), n, rng)) {
+            state.SkipWithError("no AVX2 on this CPU");
+            return;
+        }
+    }
+    for (auto _ : state) {
+        if (Vectorized)
+            detail::random_walk_step_avx2(prices.data(), amplitude.data(), n, rng);
+        else
+            detail::random_walk_step_scalar(prices.data(), amplitude.data(), n, rng);
+        // Re-anchor now and then so long runs stay in normal double range.
+        if (prices[0] > 1e6 || prices[0] < 1e-6) std::fill(prices.begin(), prices.end(), 100.0);
+        benchmark::DoNotOptimize(prices.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["per_instrument"] = benchmark::Counter(
+        static_cast<double>(n) * static_cast<double>(state.iterations()),
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// Rebuilding the N×N matrix once per FX tick.
+void BM_FillCrossRates(benchmark::State& state) {
+    MarketSnapshot snapshot;
+    for (int64_t i = 0; i < state.range(0); ++i) snapshot.usd_rates.push_back(1.0 + 0.37 * i);
+    for (auto _ : state) {
+        snapshot.fill_cross_rates();
+        benchmark::DoNotOptimize(snapshot.cross.data());
+    }
+}
+
+// What buys, sells and get_exchange_rates pay per conversion.
+void BM_GetRate(benchmark::State& state) {
+    PriceEngine prices;
+    uint32_t i = 0;
+    for (auto _ : state) {
+        ++i;
+        benchmark::DoNotOptimize(prices.get_rate(static_cast<Currency>(i % 3), static_cast<Currency>((i / 3) % 3)));
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_FillCrossRates)->Name("FillCrossRates")->Arg(3)->Arg(16)->Arg(64);
+BENCHMARK(BM_GetRate)->Name("GetRate");
+BENCHMARK_TEMPLATE(BM_RandomWalk, false)->Name("RandomWalk/scalar")->RangeMultiplier(10)->Range(1000, 100000);
+BENCHMARK_TEMPLATE(BM_RandomWalk, true)->Name("RandomWalk/avx2")->RangeMultiplier(10)->Range(1000, 100000);
+
+BENCHMARK_MAIN();
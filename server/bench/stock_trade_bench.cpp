@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include "stock_service.hpp"
+#include "trade_sequencer.hpp"
+#include "universe.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Market buy/sell round trips, one user per thread. BM_BuySell spreads the
+// trades over the symbols; the Rush benchmarks put every thread on one
+// symbol, through the lock-based StockService directly and through a
+// TradeSequencer, asynchronously and with the caller waiting on each trade.
+
+namespace {
+
+constexpr int kSymbols = 8;
+
+Universe flat_universe() {
+    Universe u;
+    u.currencies = {{"USD", 1.0, 0.0}};
+    for (int i = 0; i < kSymbols; ++i) u.instruments.push_back({"S" + std::to_string(i), 100.0, 0.0});
+    return u;
+}
+
+struct Market {
+    BankService bank;
+    PriceEngine prices{flat_universe()};
+    StockService stock{bank, prices};
+    TradeSequencer sequencer{stock, prices};
+
+    Market() { sequencer.start(); }
+};
+
+// Shared by every run; each thread opens a fresh account per run.
+Market& market_instance() {
+    static Market m;
+    return m;
+}
+
+uint64_t open_account(Market& market, benchmark::State& state) {
+    const uint64_t user = static_cast<uint64_t>(state.thread_index()) + 1;
+    const uint64_t account = market.bank.create_account(user, Currency::USD);
+    market.bank.deposit(user, account, 1e12);
+    return account;
+}
+
+void BM_BuySell(benchmark::State& state) {
+    Market& market = market_instance();
+    const uint64_t user = static_cast<uint64_t>(state.thread_index()) + 1;
+    const uint64_t account = open_account(market, state);
+    SymbolId symbol = 0;
+    for (auto _ : state) {
+        market.stock.buy(user, symbol, 1, account);
+        market.stock.sell(user, symbol, 1, account);
+        symbol = (symbol + 1) % kSymbols;
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_BuySell)->Threads(1)->Threads(4)->UseRealTime();
+
+void BM_RushLocked(benchmark::State& state) {
+    Market& market = market_instance();
+    const uint64_t user = static_cast<uint64_t>(state.thread_index()) + 1;
+    const uint64_t account = open_account(market, state);
+    for (auto _ : state) {
+        market.stock.buy(user, SymbolId{0}, 1, account);
+        market.stock.sell(user, SymbolId{0}, 1, account);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_RushLocked)->Threads(1)->Threads(4)->UseRealTime();
+
+void BM_RushSequenced(benchmark::State& state) {
+    Market& market = market_instance();
+    const uint64_t user = static_cast<uint64_t>(state.thread_index()) + 1;
+    const uint64_t account = open_account(market, state);
+    std::atomic<int64_t> executed{0};
+    auto count = [&executed](const TradeOutcome&) { executed.fetch_add(1, std::memory_order_relaxed); };
+    int64_t submitted = 0;
+    for (auto _ : state) {
+        for (bool is_buy : {true, false}) {
+            while (!market.sequencer.submit({user, account, 0, 1, is_buy}, count)) std::this_thread::yield();
+            ++submitted;
+        }
+    }
+    // The timed region ends only once every queued trade has executed.
+    while (executed.load(std::memory_order_relaxed) < submitted) std::this_thread::yield();
+    state.SetItemsProcessed(submitted);
+}
+BENCHMARK(BM_RushSequenced)->Threads(1)->Threads(4)->UseRealTime();
+
+void BM_RushSequencedWaiting(benchmark::State& state) {
+    Market& market = market_instance();
+    const uint64_t user = static_cast<uint64_t>(state.thread_index()) + 1;
+    const uint64_t account = open_account(market, state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(market.sequencer.execute({user, account, 0, 1, true}));
+        benchmark::DoNotOptimize(market.sequencer.execute({user, account, 0, 1, false}));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_RushSequencedWaiting)->Threads(1)->Threads(4)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
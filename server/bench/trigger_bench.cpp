@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+#include "trigger_service.hpp"
+#include "universe.hpp"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Cost of a PriceEngine tick with TriggerService listening, by number of
+// armed triggers that the tick does not cross, and of arming and cancelling
+// with a million armed.
+
+namespace {
+
+constexpr int kSymbols = 8;
+
+Universe quiet_universe() {
+    Universe u;
+    u.currencies = {{"USD", 1.0, 0.0}};
+    for (int i = 0; i < kSymbols; ++i) u.instruments.push_back({"S" + std::to_string(i), 100.0, 0.0001});
+    return u;
+}
+
+struct Fixture {
+    BankService bank;
+    PriceEngine prices;
+    StockService stock;
+    TriggerService triggers;
+    uint64_t account;
+    std::vector<uint64_t> ids;
+
+    explicit Fixture(std::size_t armed)
+        : prices(quiet_universe(), [] { SimulationConfig c; c.seed = 1; return c; }()),
+          stock(bank, prices),
+          triggers(bank, stock, prices),
+          account(bank.create_account(1, Currency::USD)) {
+        std::mt19937_64 rng(7);
+        std::uniform_real_distribution<double> below(10.0, 50.0), above(200.0, 1000.0);
+        ids.reserve(armed);
+        for (std::size_t i = 0; i < armed; ++i) {
+            const auto symbol = static_cast<SymbolId>(i % kSymbols);
+            const bool stop = i % 2;
+            ids.push_back(*triggers.arm(1, symbol, stop ? TriggerKind::StopLoss : TriggerKind::TakeProfit,
+                                        stop ? below(rng) : above(rng), 1, account));
+        }
+    }
+};
+
+void BM_TickWithArmedTriggers(benchmark::State& state) {
+    Fixture f(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) benchmark::DoNotOptimize(f.prices.step());
+    state.counters["armed"] = static_cast<double>(f.triggers.armed());
+}
+BENCHMARK(BM_TickWithArmedTriggers)->Arg(0)->Arg(1 << 10)->Arg(1 << 20);
+
+void BM_ArmCancel(benchmark::State& state) {
+    Fixture f(static_cast<std::size_t>(state.range(0)));
+    std::mt19937_64 rng(11);
+    std::uniform_int_distribution<std::size_t> pick(0, f.ids.size() - 1);
+    std::uniform_real_distribution<double> below(10.0, 50.0);
+    for (auto _ : state) {
+        auto& id = f.ids[pick(rng)];
+        f.triggers.cancel(1, id);
+        id = *f.triggers.arm(1, static_cast<SymbolId>(id % kSymbols), TriggerKind::StopLoss, below(rng), 1, f.account);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_ArmCancel)->Arg(1 << 20);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -5,8 +5,8 @@
 #include <functional>
 
 // TODO: заменить на SHA-256 или лучше, с солью
-std::string AuthService::hash(const std::string& s) {
-    auto h = std::hash<std::string>{}(s);
+std::string AuthService::hash(std::string_view s) {
+    auto h = std::hash<std::string_view>{}(s);
     std::ostringstream oss;
     oss << std::hex << std::setfill('0') << std::setw(16) << h;
     return oss.str();
@@ -22,22 +22,30 @@ std::string AuthService::gen_token() {
 std::optional<uint64_t> AuthService::register_user(const std::string& username, const std::string& password) {
     User u{next_id_++, username, hash(password)};
     if (!users_.try_insert(username, u)) return std::nullopt;
+    names_.put(u.id, username);
     return u.id;
 }
 
-std::optional<std::string> AuthService::login(const std::string& username, const std::string& password) {
-    auto user = users_.get(username);
-    if (!user || user->password_hash != hash(password))
-        return std::nullopt;
+std::optional<std::string> AuthService::login(std::string_view username, std::string_view password) {
+    const auto password_hash = hash(password);
+    std::optional<uint64_t> id;
+    users_.visit(username, [&](const User& user) {
+        if (user.password_hash == password_hash) id = user.id;
+    });
+    if (!id) return std::nullopt;
     auto token = gen_token();
-    tokens_.put(token, user->id);
+    tokens_.put(token, *id);
     return token;
 }
 
-bool AuthService::logout(const std::string& token) {
+bool AuthService::logout(std::string_view token) {
     return tokens_.erase(token);
 }
 
-std::optional<uint64_t> AuthService::validate(const std::string& token) const {
+std::optional<uint64_t> AuthService::validate(std::string_view token) const {
     return tokens_.get(token);
 }
+
+std::optional<std::string> AuthService::username(uint64_t user_id) const {
+    return names_.get(user_id);
+}
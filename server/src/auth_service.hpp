@@ -1,30 +1,35 @@
 #pragma once
 #include "models.hpp"
 #include "concurrent_map.hpp"
+#include "read_mostly_map.hpp"
 #include <optional>
 #include <atomic>
+#include <string_view>
 
 class IAuthService {
 public:
     virtual ~IAuthService() = default;
     virtual std::optional<uint64_t> register_user(const std::string& username, const std::string& password) = 0;
-    virtual std::optional<std::string> login(const std::string& username, const std::string& password) = 0;
-    virtual bool logout(const std::string& token) = 0;
-    virtual std::optional<uint64_t> validate(const std::string& token) const = 0;
+    virtual std::optional<std::string> login(std::string_view username, std::string_view password) = 0;
+    virtual bool logout(std::string_view token) = 0;
+    virtual std::optional<uint64_t> validate(std::string_view token) const = 0;
+    virtual std::optional<std::string> username(uint64_t user_id) const = 0;
 };
 
 class AuthService : public IAuthService {
 public:
     std::optional<uint64_t> register_user(const std::string& username, const std::string& password) override;
-    std::optional<std::string> login(const std::string& username, const std::string& password) override;
-    bool logout(const std::string& token) override;
-    std::optional<uint64_t> validate(const std::string& token) const override;
+    std::optional<std::string> login(std::string_view username, std::string_view password) override;
+    bool logout(std::string_view token) override;
+    std::optional<uint64_t> validate(std::string_view token) const override;
+    std::optional<std::string> username(uint64_t user_id) const override;
 
 private:
-    static std::string hash(const std::string& s);
+    static std::string hash(std::string_view s);
     static std::string gen_token();
 
     ConcurrentMap<std::string, User> users_;
-    ConcurrentMap<std::string, uint64_t> tokens_;
+    ConcurrentMap<uint64_t, std::string> names_;
+    ReadMostlyMap<std::string, uint64_t> tokens_;  // read on every request, written on login/logout
     std::atomic<uint64_t> next_id_{1};
 };
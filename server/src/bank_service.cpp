@@ -1,34 +1,342 @@
 #include "bank_service.hpp"
 #include <cmath>
+#include <algorithm>
+#include <unordered_map>
 #include <mutex>
+#include <thread>
 
-void BankService::record(Account& acc, OpType type, double amount, const std::string& counterparty) {
-    acc.history.push_back({
-        std::chrono::system_clock::now(), type, amount, acc.balance, counterparty
-    });
+void AccountRecord::publish() { write(true); }
+
+void AccountRecord::close() { write(false); }
+
+void AccountRecord::write(bool open) {
+    const uint64_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    balance_.store(account.balance, std::memory_order_relaxed);
+    open_.store(open, std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+}
+
+std::optional<AccountSummary> AccountRecord::read() const {
+    for (;;) {
+        const uint64_t before = seq_.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        const double balance = balance_.load(std::memory_order_relaxed);
+        const bool open = open_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != before) continue;
+
+        if (!open) return std::nullopt;
+        return AccountSummary{account.id, account.user_id, account.currency, balance, before / 2};
+    }
+}
+
+HotCredits& AccountRecord::enable_hot_credits() {
+    auto* hot = hot_.load(std::memory_order_relaxed);
+    if (!hot) {
+        hot = new HotCredits;
+        hot_.store(hot, std::memory_order_release);
+    }
+    return *hot;
+}
+
+namespace {
+
+// Stable small integer per thread, used to pick a shard.
+std::size_t thread_slot() {
+    static std::atomic<std::size_t> next_slot{0};
+    thread_local const std::size_t slot = next_slot++;
+    return slot;
+}
+
+void atomic_add(std::atomic<double>& target, double delta) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {}
+}
+
+}  // namespace
+
+LedgerTotals::Shard& LedgerTotals::local() {
+    return shards_[thread_slot() % kShards];
+}
+
+void LedgerTotals::begin() {
+    local().begun.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LedgerTotals::add(Currency currency, double delta) {
+    atomic_add(local().totals[static_cast<std::size_t>(currency)], delta);
+}
+
+void LedgerTotals::end() {
+    local().ended.fetch_add(1, std::memory_order_release);
+}
+
+LedgerTotals::Snapshot LedgerTotals::snapshot() const {
+    Snapshot out;
+    uint64_t ended = 0;
+    for (const auto& shard : shards_)
+        ended += shard.ended.load(std::memory_order_acquire);
+    for (const auto& shard : shards_)
+        for (std::size_t c = 0; c < currency_count(); ++c)
+            out.totals[c] += shard.totals[c].load(std::memory_order_acquire);
+    for (const auto& shard : shards_)
+        out.ops += shard.begun.load(std::memory_order_acquire);
+    out.quiescent = out.ops == ended;
+    return out;
+}
+
+DailyRollup::Shard& DailyRollup::local() {
+    return shards_[thread_slot() % kShards];
+}
+
+void DailyRollup::add(TimePoint when, Currency currency, OpType type, double amount) {
+    const int64_t day = std::chrono::duration_cast<std::chrono::hours>(when.time_since_epoch()).count() / 24;
+    const std::size_t index = static_cast<std::size_t>(currency) * kOpTypes + static_cast<std::size_t>(type);
+    auto& shard = local();
+    std::lock_guard lk(shard.mu);
+    if (day != shard.last_day) {
+        shard.last_row = &shard.days[day];
+        shard.last_day = day;
+    }
+    auto& row = *shard.last_row;
+    if (row.size() <= index) row.resize(currency_count() * kOpTypes);
+    row[index].count++;
+    row[index].volume += amount;
+}
+
+void DailyRollup::merge_into(std::map<Key, OpTotals>& out) const {
+    for (const auto& shard : shards_) {
+        std::lock_guard lk(shard.mu);
+        for (const auto& [day, row] : shard.days) {
+            for (std::size_t i = 0; i < row.size(); ++i) {
+                if (!row[i].count) continue;
+                auto& into = out[{day, static_cast<Currency>(i / kOpTypes), static_cast<OpType>(i % kOpTypes)}];
+                into.count += row[i].count;
+                into.volume += row[i].volume;
+            }
+        }
+    }
+}
+
+bool HotCredits::push(HistoryEntry entry) {
+    auto& shard = shards_[thread_slot() % kShards];
+    std::lock_guard lk(shard.mu);
+    if (sealed_) return false;
+    shard.amount.store(shard.amount.load(std::memory_order_relaxed) + entry.amount, std::memory_order_relaxed);
+    shard.entries.push_back(std::move(entry));
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<HistoryEntry> HotCredits::drain() {
+    std::vector<HistoryEntry> out;
+    for (auto& shard : shards_) {
+        std::lock_guard lk(shard.mu);
+        if (shard.entries.empty()) continue;
+        out.insert(out.end(), std::make_move_iterator(shard.entries.begin()),
+                   std::make_move_iterator(shard.entries.end()));
+        shard.entries.clear();
+        shard.amount.store(0.0, std::memory_order_relaxed);
+    }
+    pending_.fetch_sub(out.size(), std::memory_order_relaxed);
+    return out;
+}
+
+std::vector<HistoryEntry> HotCredits::pending_entries() const {
+    std::vector<HistoryEntry> out;
+    for (const auto& shard : shards_) {
+        std::lock_guard lk(shard.mu);
+        out.insert(out.end(), shard.entries.begin(), shard.entries.end());
+    }
+    return out;
+}
+
+double HotCredits::pending_amount() const {
+    double sum = 0.0;
+    for (const auto& shard : shards_) sum += shard.amount.load(std::memory_order_relaxed);
+    return sum;
+}
+
+void HotCredits::begin_fold() {
+    folds_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+UserAccounts::~UserAccounts() {
+    auto* rec = records.load(std::memory_order_relaxed);
+    while (rec) {
+        auto* next = rec->next.load(std::memory_order_relaxed);
+        delete rec;
+        rec = next;
+    }
+}
+
+namespace {
+
+template<typename F>
+void for_each_record(const UserAccounts& ud, F&& f) {
+    for (auto* rec = ud.records.load(std::memory_order_acquire); rec;
+         rec = rec->next.load(std::memory_order_acquire))
+        f(*rec);
+}
+
+}  // namespace
+
+AccountRecord* BankService::find(uint64_t account_id) const {
+    if (account_id < kFirstAccountId) return nullptr;
+    return accounts_.get(account_id - kFirstAccountId);
+}
+
+AccountRecord* BankService::find_owned(uint64_t user_id, uint64_t account_id) const {
+    auto* rec = find(account_id);
+    return rec && rec->account.user_id == user_id ? rec : nullptr;
+}
+
+void BankService::post(AccountRecord& rec, HistoryEntry entry) const {
+    const double delta = signed_amount(entry.type, entry.amount);
+    rec.account.balance += delta;
+    entry.balance_after = rec.account.balance;
+    rec.account.history.push_back(std::move(entry));
+    rec.owner->totals[static_cast<std::size_t>(rec.account.currency)] += delta;
+    ledger_.add(rec.account.currency, delta);
+}
+
+void BankService::write_off(AccountRecord& rec) const {
+    ledger_.begin();
+    rec.owner->totals[static_cast<std::size_t>(rec.account.currency)] -= rec.account.balance;
+    ledger_.add(rec.account.currency, -rec.account.balance);
+    rec.account.balance = 0.0;
+    rec.publish();
+    ledger_.end();
+}
+
+void BankService::record(AccountRecord& rec, OpType type, double amount, std::string_view counterparty,
+                         SymbolId symbol) {
+    const auto now = std::chrono::system_clock::now();
+    daily_.add(now, rec.account.currency, type, amount);
+    ledger_.begin();
+    post(rec, {now, type, amount, 0.0, std::string(counterparty), symbol});
+    rec.publish();
+    ledger_.end();
+}
+
+void BankService::apply_credits(AccountRecord& rec, std::vector<HistoryEntry>& credits) const {
+    std::sort(credits.begin(), credits.end(),
+              [](const HistoryEntry& a, const HistoryEntry& b) { return a.timestamp < b.timestamp; });
+    ledger_.begin();
+    for (auto& entry : credits)
+        post(rec, std::move(entry));
+    rec.publish();
+    ledger_.end();
+}
+
+void BankService::fold_credits(AccountRecord& rec) const {
+    auto* hot = rec.hot_credits();
+    if (!hot || hot->pending() == 0) return;
+    hot->begin_fold();
+    auto credits = hot->drain();
+    if (!credits.empty()) apply_credits(rec, credits);
+    hot->end_fold();
+}
+
+std::optional<AccountSummary> BankService::read_with_credits(const AccountRecord& rec) const {
+    const auto* hot = rec.hot_credits();
+    if (!hot) return rec.read();
+    for (;;) {
+        const uint64_t before = hot->folds();
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        const double pending = hot->pending_amount();
+        auto summary = rec.read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (hot->folds() != before) continue;
+        if (summary) summary->balance += pending;
+        return summary;
+    }
+}
+
+Account BankService::account_with_credits(const AccountRecord& rec) const {
+    Account account = rec.account;
+    const auto* hot = rec.hot_credits();
+    if (!hot || hot->pending() == 0) return account;
+    // No fold can run under the shared lock, so the buffer holds exactly the
+    // credits missing from the history; append them as a fold would.
+    auto credits = hot->pending_entries();
+    std::sort(credits.begin(), credits.end(),
+              [](const HistoryEntry& a, const HistoryEntry& b) { return a.timestamp < b.timestamp; });
+    for (auto& entry : credits) {
+        account.balance += signed_amount(entry.type, entry.amount);
+        entry.balance_after = account.balance;
+        account.history.push_back(std::move(entry));
+    }
+    return account;
+}
+
+bool BankService::set_hot_account(uint64_t account_id, bool enabled) {
+    auto* rec = find(account_id);
+    if (!rec) return false;
+    std::unique_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return false;
+    if (enabled) {
+        rec->enable_hot_credits().enabled.store(true, std::memory_order_relaxed);
+    } else if (auto* hot = rec->hot_credits()) {
+        hot->enabled.store(false, std::memory_order_relaxed);
+        fold_credits(*rec);
+    }
+    return true;
 }
 
 uint64_t BankService::create_account(uint64_t user_id, Currency currency) {
-    uint64_t id = next_id_++;
+    // Take an id only while the table has a slot for it, so a full bank
+    // neither burns ids nor leaves a linked record it cannot look up.
+    uint64_t id = next_id_.load(std::memory_order_relaxed);
+    do {
+        if (id - kFirstAccountId >= decltype(accounts_)::kCapacity) return kNoAccount;
+    } while (!next_id_.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
     auto ud = users_.get_or_create(user_id, [] { return std::make_shared<UserAccounts>(); });
-    account_index_.put(id, user_id);
     std::unique_lock lk(ud->mu);
-    ud->accounts[id] = Account{id, user_id, currency, 0.0, {}};
+    auto owned = std::make_unique<AccountRecord>(Account{id, user_id, currency, 0.0, {}}, ud.get());
+    owned->publish();
+    // The slot goes first: if its chunk cannot be allocated, nothing refers
+    // to the record yet. Until it is linked, callers find it but block on mu.
+    accounts_.put(id - kFirstAccountId, owned.get());
+    auto* rec = owned.release();
+    if (ud->tail) {
+        ud->tail->next.store(rec, std::memory_order_release);
+    } else {
+        ud->records.store(rec, std::memory_order_release);
+    }
+    ud->tail = rec;
     return id;
 }
 
 bool BankService::close_account(uint64_t user_id, uint64_t account_id) {
-    auto owner = account_index_.get(account_id);
-    if (!owner || *owner != user_id) return false;
-    auto ud_opt = users_.get(user_id);
-    if (!ud_opt) return false;
-    auto& ud = *ud_opt;
-    std::unique_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end()) return false;
-    if (std::abs(it->second.balance) > 1e-9) return false;
-    ud->accounts.erase(it);
-    account_index_.erase(account_id);
+    auto* rec = find_owned(user_id, account_id);
+    if (!rec) return false;
+    std::unique_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return false;
+    if (auto* hot = rec->hot_credits()) {
+        // Seal the buffer so no credit can land after the zero-balance check.
+        hot->begin_fold();
+        bool empty = hot->seal_if([&](std::vector<HistoryEntry>& credits) {
+            apply_credits(*rec, credits);
+            return std::abs(rec->account.balance) <= 1e-9;
+        });
+        hot->end_fold();
+        if (!empty) return false;
+    }
+    if (std::abs(rec->account.balance) > 1e-9) return false;
+    // The ledger totals must stop counting money that no open account holds.
+    if (rec->account.balance != 0.0) write_off(*rec);
+    rec->close();
+    accounts_.put(account_id - kFirstAccountId, nullptr);
     return true;
 }
 
@@ -38,129 +346,301 @@ std::vector<Account> BankService::get_accounts(uint64_t user_id) const {
     auto& ud = *ud_opt;
     std::shared_lock lk(ud->mu);
     std::vector<Account> result;
-    for (auto& [_, acc] : ud->accounts)
-        result.push_back(acc);
+    for_each_record(*ud, [&](const AccountRecord& rec) {
+        if (rec.is_open()) result.push_back(account_with_credits(rec));
+    });
     return result;
 }
 
 std::optional<Account> BankService::get_account(uint64_t account_id) const {
-    auto owner = account_index_.get(account_id);
-    if (!owner) return std::nullopt;
-    auto ud_opt = users_.get(*owner);
-    if (!ud_opt) return std::nullopt;
-    auto& ud = *ud_opt;
-    std::shared_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end()) return std::nullopt;
-    return it->second;
+    auto* rec = find(account_id);
+    if (!rec) return std::nullopt;
+    std::shared_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return std::nullopt;
+    return account_with_credits(*rec);
+}
+
+std::vector<AccountSummary> BankService::get_account_summaries(uint64_t user_id) const {
+    std::vector<AccountSummary> result;
+    users_.visit(user_id, [&](const std::shared_ptr<UserAccounts>& ud) {
+        for_each_record(*ud, [&](const AccountRecord& rec) {
+            if (auto summary = read_with_credits(rec)) result.push_back(*summary);
+        });
+    });
+    return result;
+}
+
+std::optional<AccountSummary> BankService::get_account_summary(uint64_t account_id) const {
+    auto* rec = find(account_id);
+    if (!rec) return std::nullopt;
+    return read_with_credits(*rec);
 }
 
 std::vector<HistoryEntry> BankService::get_history(uint64_t account_id) const {
-    auto owner = account_index_.get(account_id);
-    if (!owner) return {};
-    auto ud_opt = users_.get(*owner);
-    if (!ud_opt) return {};
-    auto& ud = *ud_opt;
-    std::shared_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end()) return {};
-    return it->second.history;
+    auto* rec = find(account_id);
+    if (!rec) return {};
+    std::shared_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return {};
+    if (!rec->hot_credits()) return rec->account.history;
+    return account_with_credits(*rec).history;
+}
+
+BankReport BankService::build_report(std::size_t workers) const {
+    constexpr uint64_t kBlock = 1024;
+    const uint64_t end = next_id_.load() - kFirstAccountId;
+    if (workers == 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<std::size_t>(1, std::min<std::size_t>(workers, (end + kBlock - 1) / kBlock));
+
+    // Workers claim blocks of the dense id space and sum the published
+    // balances privately; the daily volumes come from the rollup.
+    std::atomic<uint64_t> next_block{0};
+    std::vector<BankReport> partial(workers);
+    auto scan = [&](BankReport& out) {
+        for (;;) {
+            const uint64_t begin = next_block.fetch_add(kBlock);
+            if (begin >= end) return;
+            for (uint64_t i = begin; i < std::min(begin + kBlock, end); ++i) {
+                auto* rec = accounts_.get(i);
+                if (!rec) continue;
+                auto summary = read_with_credits(*rec);
+                if (!summary) continue;
+
+                out.accounts++;
+                auto& totals = out.by_currency[summary->currency];
+                totals.accounts++;
+                totals.balance += summary->balance;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w)
+        threads.emplace_back(scan, std::ref(partial[w]));
+    scan(partial[0]);
+    for (auto& t : threads) t.join();
+
+    BankReport report = std::move(partial[0]);
+    for (std::size_t w = 1; w < workers; ++w) {
+        report.accounts += partial[w].accounts;
+        for (const auto& [currency, totals] : partial[w].by_currency) {
+            auto& into = report.by_currency[currency];
+            into.accounts += totals.accounts;
+            into.balance += totals.balance;
+        }
+    }
+    daily_.merge_into(report.daily);
+    report.as_of = std::chrono::system_clock::now();
+    return report;
 }
 
 std::optional<double> BankService::deposit(uint64_t user_id, uint64_t account_id, double amount) {
     if (amount <= 0) return std::nullopt;
-    auto ud_opt = users_.get(user_id);
-    if (!ud_opt) return std::nullopt;
-    auto& ud = *ud_opt;
-    std::unique_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end() || it->second.user_id != user_id) return std::nullopt;
-    it->second.balance += amount;
-    record(it->second, OpType::Deposit, amount);
-    return it->second.balance;
+    auto* rec = find_owned(user_id, account_id);
+    if (!rec) return std::nullopt;
+    std::unique_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return std::nullopt;
+    fold_credits(*rec);
+    record(*rec, OpType::Deposit, amount);
+    return rec->account.balance;
 }
 
 std::optional<double> BankService::withdraw(uint64_t user_id, uint64_t account_id, double amount) {
     if (amount <= 0) return std::nullopt;
-    auto ud_opt = users_.get(user_id);
-    if (!ud_opt) return std::nullopt;
-    auto& ud = *ud_opt;
-    std::unique_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end() || it->second.user_id != user_id) return std::nullopt;
-    if (it->second.balance < amount) return std::nullopt;
-    it->second.balance -= amount;
-    record(it->second, OpType::Withdraw, amount);
-    return it->second.balance;
+    auto* rec = find_owned(user_id, account_id);
+    if (!rec) return std::nullopt;
+    std::unique_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return std::nullopt;
+    fold_credits(*rec);
+    if (rec->account.balance < amount) return std::nullopt;
+    record(*rec, OpType::Withdraw, amount);
+    return rec->account.balance;
 }
 
 std::optional<TransferResult> BankService::transfer(
     uint64_t user_id, uint64_t from_id, uint64_t to_id, double amount, double rate) {
     if (amount <= 0 || rate <= 0 || from_id == to_id) return std::nullopt;
 
-    auto from_owner = account_index_.get(from_id);
-    auto to_owner = account_index_.get(to_id);
-    if (!from_owner || !to_owner || *from_owner != user_id) return std::nullopt;
+    auto* from = find_owned(user_id, from_id);
+    auto* to = find(to_id);
+    if (!from || !to) return std::nullopt;
 
-    auto from_ud_opt = users_.get(*from_owner);
-    auto to_ud_opt = users_.get(*to_owner);
-    if (!from_ud_opt || !to_ud_opt) return std::nullopt;
-    auto& from_ud = *from_ud_opt;
-    auto& to_ud = *to_ud_opt;
+    if (from->owner != to->owner) {
+        auto* hot = to->hot_credits();
+        if (hot && hot->enabled.load(std::memory_order_relaxed))
+            return transfer_to_hot(*from, *to, amount, rate);
+    }
 
     auto do_transfer = [&]() -> std::optional<TransferResult> {
-        auto from_it = from_ud->accounts.find(from_id);
-        auto to_it = to_ud->accounts.find(to_id);
-        if (from_it == from_ud->accounts.end() || to_it == to_ud->accounts.end())
-            return std::nullopt;
-        if (from_it->second.balance < amount) return std::nullopt;
+        if (!from->is_open() || !to->is_open()) return std::nullopt;
+        fold_credits(*from);
+        fold_credits(*to);
+        if (from->account.balance < amount) return std::nullopt;
 
         double converted = amount * rate;
-        from_it->second.balance -= amount;
-        to_it->second.balance += converted;
-
-        record(from_it->second, OpType::TransferOut, amount,
+        record(*from, OpType::TransferOut, amount,
                "-> account " + std::to_string(to_id));
-        record(to_it->second, OpType::TransferIn, converted,
+        record(*to, OpType::TransferIn, converted,
                "<- account " + std::to_string(from_id));
 
-        return TransferResult{from_it->second.balance, to_it->second.balance, converted};
+        return TransferResult{from->account.balance, to->account.balance, converted};
     };
 
-    if (*from_owner == *to_owner) {
-        std::unique_lock lk(from_ud->mu);
+    if (from->owner == to->owner) {
+        std::unique_lock lk(from->owner->mu);
         return do_transfer();
     } else {
-        std::scoped_lock lk(from_ud->mu, to_ud->mu);
+        std::scoped_lock lk(from->owner->mu, to->owner->mu);
         return do_transfer();
     }
 }
 
-std::optional<double> BankService::debit_for_stock(uint64_t user_id, uint64_t account_id,
-                                                    double amount, const std::string& ticker) {
-    if (amount <= 0) return std::nullopt;
-    auto ud_opt = users_.get(user_id);
-    if (!ud_opt) return std::nullopt;
-    auto& ud = *ud_opt;
-    std::unique_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end() || it->second.user_id != user_id) return std::nullopt;
-    if (it->second.balance < amount) return std::nullopt;
-    it->second.balance -= amount;
-    record(it->second, OpType::BuyStock, amount, ticker);
-    return it->second.balance;
+std::optional<TransferResult> BankService::transfer_to_hot(
+    AccountRecord& from, AccountRecord& to, double amount, double rate) {
+    const double converted = amount * rate;
+    std::optional<TransferResult> result;
+    {
+        std::unique_lock lk(from.owner->mu);
+        if (!from.is_open()) return std::nullopt;
+        fold_credits(from);
+        if (from.account.balance < amount) return std::nullopt;
+
+        // Buffer the credit first: a sealed (closing) account refuses it and
+        // the debit below never happens.
+        HistoryEntry credit{std::chrono::system_clock::now(), OpType::TransferIn, converted, 0.0,
+                            "<- account " + std::to_string(from.account.id)};
+        const auto when = credit.timestamp;
+        if (!to.hot_credits()->push(std::move(credit))) return std::nullopt;
+        // Rolled up now; folding it into the history later does not count it again.
+        daily_.add(when, to.account.currency, OpType::TransferIn, converted);
+
+        record(from, OpType::TransferOut, amount,
+               "-> account " + std::to_string(to.account.id));
+        result = TransferResult{from.account.balance, 0.0, converted};
+    }
+
+    // Fold opportunistically once enough credits pile up; never wait for the lock.
+    if (to.hot_credits()->pending() >= kHotFoldThreshold) {
+        std::unique_lock lk(to.owner->mu, std::try_to_lock);
+        if (lk) fold_credits(to);
+    }
+    // The credit may still sit in the buffer; count it and any others.
+    if (auto summary = read_with_credits(to)) result->to_balance = summary->balance;
+    return result;
+}
+
+std::optional<std::vector<TransferResult>> BankService::transfer_batch(
+    uint64_t user_id, const std::vector<TransferLeg>& legs, const RateFn& rate) {
+    if (legs.empty()) return std::nullopt;
+
+    // Resolve each leg through the handle table before taking any lock and
+    // give every distinct account a dense slot for the dry run below.
+    std::vector<AccountRecord*> records;
+    std::unordered_map<uint64_t, std::size_t> record_slot;
+    record_slot.reserve(legs.size() + 1);
+    auto resolve = [&](uint64_t account_id) -> std::optional<std::size_t> {
+        auto it = record_slot.find(account_id);
+        if (it != record_slot.end()) return it->second;
+        auto* rec = find(account_id);
+        if (!rec) return std::nullopt;
+        records.push_back(rec);
+        record_slot.emplace(account_id, records.size() - 1);
+        return records.size() - 1;
+    };
+
+    struct Resolved { std::size_t from; std::size_t to; double rate; };
+    std::vector<Resolved> resolved;
+    resolved.reserve(legs.size());
+    for (const auto& leg : legs) {
+        if (leg.amount <= 0 || leg.from_id == leg.to_id) return std::nullopt;
+        auto from = resolve(leg.from_id);
+        auto to = resolve(leg.to_id);
+        if (!from || !to || records[*from]->account.user_id != user_id) return std::nullopt;
+        double r = rate ? rate(records[*from]->account.currency, records[*to]->account.currency) : 1.0;
+        if (r <= 0) return std::nullopt;
+        resolved.push_back({*from, *to, r});
+    }
+
+    // Global lock order: ascending user id.
+    std::vector<std::pair<uint64_t, UserAccounts*>> owners;
+    owners.reserve(records.size());
+    for (auto* rec : records)
+        owners.emplace_back(rec->account.user_id, rec->owner);
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(owners.size());
+    for (auto& [_, ud] : owners)
+        locks.emplace_back(ud->mu);
+
+    // Dry run on scratch balances so a failing leg leaves nothing applied.
+    std::vector<double> scratch;
+    scratch.reserve(records.size());
+    for (auto* rec : records) {
+        if (!rec->is_open()) return std::nullopt;
+        fold_credits(*rec);
+        scratch.push_back(rec->account.balance);
+    }
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        double& from_balance = scratch[resolved[i].from];
+        if (from_balance < legs[i].amount) return std::nullopt;
+        from_balance -= legs[i].amount;
+        scratch[resolved[i].to] += legs[i].amount * resolved[i].rate;
+    }
+
+    std::vector<TransferResult> results;
+    results.reserve(legs.size());
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        auto& from = *records[resolved[i].from];
+        auto& to = *records[resolved[i].to];
+        double converted = legs[i].amount * resolved[i].rate;
+        record(from, OpType::TransferOut, legs[i].amount,
+               "-> account " + std::to_string(legs[i].to_id));
+        record(to, OpType::TransferIn, converted,
+               "<- account " + std::to_string(legs[i].from_id));
+
+        results.push_back({from.account.balance, to.account.balance, converted});
+    }
+    return results;
 }
 
-std::optional<double> BankService::credit_for_stock(uint64_t user_id, uint64_t account_id,
-                                                     double amount, const std::string& ticker) {
+std::optional<double> BankService::settle_stock(uint64_t user_id, uint64_t account_id, bool is_buy,
+                                                 double amount, SymbolId symbol,
+                                                 const std::function<bool()>& apply) {
     if (amount <= 0) return std::nullopt;
-    auto ud_opt = users_.get(user_id);
-    if (!ud_opt) return std::nullopt;
-    auto& ud = *ud_opt;
-    std::unique_lock lk(ud->mu);
-    auto it = ud->accounts.find(account_id);
-    if (it == ud->accounts.end() || it->second.user_id != user_id) return std::nullopt;
-    it->second.balance += amount;
-    record(it->second, OpType::SellStock, amount, ticker);
-    return it->second.balance;
+    auto* rec = find_owned(user_id, account_id);
+    if (!rec) return std::nullopt;
+    std::unique_lock lk(rec->owner->mu);
+    if (!rec->is_open()) return std::nullopt;
+    fold_credits(*rec);
+    if (is_buy && rec->account.balance < amount) return std::nullopt;
+    if (!apply()) return std::nullopt;
+    record(*rec, is_buy ? OpType::BuyStock : OpType::SellStock, amount, {}, symbol);
+    return rec->account.balance;
+}
+
+StockSettlement BankService::settle_stock_pair(const StockLeg& buyer, const StockLeg& seller, SymbolId symbol,
+                                               const std::function<bool()>& apply) {
+    auto* from = find_owned(buyer.user_id, buyer.account_id);
+    auto* to = find_owned(seller.user_id, seller.account_id);
+    if (!from || buyer.amount <= 0) return {SettleParty::Buyer};
+    if (!to || seller.amount <= 0) return {SettleParty::Seller};
+
+    auto settle = [&]() -> StockSettlement {
+        if (!from->is_open()) return {SettleParty::Buyer};
+        if (!to->is_open()) return {SettleParty::Seller};
+        fold_credits(*from);
+        fold_credits(*to);
+        if (from->account.balance < buyer.amount) return {SettleParty::Buyer};
+        if (!apply()) return {SettleParty::Seller};
+        record(*from, OpType::BuyStock, buyer.amount, {}, symbol);
+        record(*to, OpType::SellStock, seller.amount, {}, symbol);
+        return {SettleParty::None, from->account.balance, to->account.balance};
+    };
+
+    if (from->owner == to->owner) {
+        std::unique_lock lk(from->owner->mu);
+        return settle();
+    }
+    std::scoped_lock lk(from->owner->mu, to->owner->mu);
+    return settle();
 }
@@ -1,11 +1,21 @@
 #pragma once
 #include "models.hpp"
 #include "concurrent_map.hpp"
+#include "handle_table.hpp"
 #include <vector>
+#include <array>
+#include <mutex>
 #include <shared_mutex>
 #include <optional>
 #include <atomic>
 #include <memory>
+#include <functional>
+#include <map>
+#include <string_view>
+#include <tuple>
+
+// Account ids start above zero, so 0 never names an account.
+constexpr uint64_t kNoAccount = 0;
 
 struct TransferResult {
     double from_balance;
@@ -13,55 +23,318 @@ struct TransferResult {
     double converted_amount;
 };
 
+struct TransferLeg {
+    uint64_t from_id;
+    uint64_t to_id;
+    double amount;
+};
+
+// One side of a stock trade between two users; `amount` is in the account's currency.
+struct StockLeg {
+    uint64_t user_id;
+    uint64_t account_id;
+    double amount;
+};
+
+enum class SettleParty : uint8_t { None, Buyer, Seller };
+
+// Outcome of settle_stock_pair; on failure `failed` names the party at fault.
+struct StockSettlement {
+    SettleParty failed = SettleParty::None;
+    double buyer_balance = 0.0;
+    double seller_balance = 0.0;
+
+    bool ok() const { return failed == SettleParty::None; }
+};
+
+struct CurrencyTotals {
+    uint64_t accounts = 0;
+    double balance = 0.0;
+};
+
+struct OpTotals {
+    uint64_t count = 0;
+    double volume = 0.0;
+};
+
+// Bank-wide aggregates. Balances are the open accounts' published ones and
+// the daily volumes come from a running rollup, so building a report costs
+// one pass over the accounts however long their history. It is not a global
+// snapshot: trading keeps running while it scans.
+struct BankReport {
+    TimePoint as_of;
+    uint64_t accounts = 0;
+    std::map<Currency, CurrencyTotals> by_currency;
+    // (day since epoch UTC, currency, op type) → totals, closed accounts included
+    std::map<std::tuple<int64_t, Currency, OpType>, OpTotals> daily;
+};
+
+// Cross-currency rate for a leg; an empty function means every rate is 1.0.
+using RateFn = std::function<double(Currency from, Currency to)>;
+
 class IBankService {
 public:
     virtual ~IBankService() = default;
+    // kNoAccount once the bank has handed out every account id it can hold.
     virtual uint64_t create_account(uint64_t user_id, Currency currency) = 0;
     virtual bool close_account(uint64_t user_id, uint64_t account_id) = 0;
     virtual std::vector<Account> get_accounts(uint64_t user_id) const = 0;
     virtual std::optional<Account> get_account(uint64_t account_id) const = 0;
+    virtual std::vector<AccountSummary> get_account_summaries(uint64_t user_id) const = 0;
+    virtual std::optional<AccountSummary> get_account_summary(uint64_t account_id) const = 0;
 
     virtual std::optional<double> deposit(uint64_t user_id, uint64_t account_id, double amount) = 0;
     virtual std::optional<double> withdraw(uint64_t user_id, uint64_t account_id, double amount) = 0;
     virtual std::optional<TransferResult> transfer(uint64_t user_id, uint64_t from_id,
                                                    uint64_t to_id, double amount, double rate = 1.0) = 0;
+    // All legs apply or none do; per-leg results are in input order.
+    virtual std::optional<std::vector<TransferResult>> transfer_batch(
+        uint64_t user_id, const std::vector<TransferLeg>& legs, const RateFn& rate = {}) = 0;
 
-    virtual std::optional<double> debit_for_stock(uint64_t user_id, uint64_t account_id,
-                                                   double amount, const std::string& ticker) = 0;
-    virtual std::optional<double> credit_for_stock(uint64_t user_id, uint64_t account_id,
-                                                    double amount, const std::string& ticker) = 0;
+    // Settles one side of a stock trade in a single critical section: with
+    // the account owner locked, a buy checks the balance covers `amount`,
+    // then `apply` updates the position; the cash moves only if it returns
+    // true. `apply` must not call back into the bank. Returns the new balance.
+    virtual std::optional<double> settle_stock(uint64_t user_id, uint64_t account_id, bool is_buy,
+                                               double amount, SymbolId symbol,
+                                               const std::function<bool()>& apply) = 0;
+
+    // Settles both sides of a trade between two users the same way, with
+    // both owners locked: the buyer's balance must cover its amount and
+    // `apply` moves the shares, returning false if the seller lacks them.
+    // Either both accounts move or neither does.
+    virtual StockSettlement settle_stock_pair(const StockLeg& buyer, const StockLeg& seller, SymbolId symbol,
+                                              const std::function<bool()>& apply) = 0;
 
     virtual std::vector<HistoryEntry> get_history(uint64_t account_id) const = 0;
+
+    // Scans every account on `workers` threads (0 = hardware concurrency).
+    virtual BankReport build_report(std::size_t workers = 0) const = 0;
+};
+
+// Credit buffer for an opt-in hot account. Creditors append to a per-thread
+// shard without touching the owner's mu; the owner folds the shards into the
+// balance and history under mu before any debit. Reads count the buffered
+// credits in without folding them.
+class HotCredits {
+public:
+    static constexpr std::size_t kShards = 8;
+
+    bool push(HistoryEntry entry);  // false once sealed by close_account
+    std::vector<HistoryEntry> drain();
+    std::vector<HistoryEntry> pending_entries() const;  // copies, leaving them buffered
+    std::size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+    double pending_amount() const;  // sum over the shards, without locking them
+
+    // The owner brackets every drain-and-apply with these, under mu, so a
+    // lock-free reader can tell whether a fold moved credits from the
+    // shards into the balance while it looked at both. Odd while folding.
+    void begin_fold();
+    void end_fold() { folds_.fetch_add(1, std::memory_order_release); }
+    uint64_t folds() const { return folds_.load(std::memory_order_acquire); }
+
+    // Drains with every shard held and seals the buffer if `apply` accepts.
+    template<typename Apply>
+    bool seal_if(Apply&& apply) {
+        std::array<std::unique_lock<std::mutex>, kShards> locks;
+        for (std::size_t i = 0; i < kShards; ++i)
+            locks[i] = std::unique_lock(shards_[i].mu);
+        std::vector<HistoryEntry> drained;
+        for (auto& shard : shards_) {
+            drained.insert(drained.end(), shard.entries.begin(), shard.entries.end());
+            shard.entries.clear();
+            shard.amount.store(0.0, std::memory_order_relaxed);
+        }
+        pending_.store(0, std::memory_order_relaxed);
+        sealed_ = apply(drained);
+        return sealed_;
+    }
+
+    std::atomic<bool> enabled{true};
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mu;
+        std::vector<HistoryEntry> entries;
+        std::atomic<double> amount{0.0};  // written under mu
+    };
+
+    std::array<Shard, kShards> shards_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<uint64_t> folds_{0};
+    bool sealed_ = false;  // guarded by every shard mutex
+};
+
+// Running per-currency sum of every posted amount, sharded per thread so
+// posting never bounces a shared cache line. begin()/end() bracket each
+// mutation so snapshot() can tell whether it caught the ledger at rest.
+class LedgerTotals {
+public:
+    static constexpr std::size_t kShards = 16;
+
+    struct Snapshot {
+        std::array<double, kMaxCurrencies> totals{};
+        uint64_t ops = 0;
+        bool quiescent = false;
+    };
+
+    void begin();
+    void add(Currency currency, double delta);
+    void end();
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> begun{0};
+        std::atomic<uint64_t> ended{0};
+        std::array<std::atomic<double>, kMaxCurrencies> totals{};
+    };
+
+    Shard& local();
+
+    std::array<Shard, kShards> shards_;
+};
+
+// Per-day operation counts and volumes by currency and type, added to as
+// operations are recorded so a report never walks history, and never
+// taken back, so closed accounts keep their past volume. Sharded per
+// thread like LedgerTotals; each shard remembers the day it last touched,
+// which is nearly always today.
+class DailyRollup {
+public:
+    static constexpr std::size_t kShards = 16;
+    using Key = std::tuple<int64_t, Currency, OpType>;  // (day since epoch UTC, currency, type)
+
+    void add(TimePoint when, Currency currency, OpType type, double amount);
+    void merge_into(std::map<Key, OpTotals>& out) const;
+
+private:
+    static constexpr std::size_t kOpTypes = static_cast<std::size_t>(OpType::SellStock) + 1;
+
+    struct alignas(64) Shard {
+        mutable std::mutex mu;
+        std::map<int64_t, std::vector<OpTotals>> days;  // row index: currency * kOpTypes + type
+        int64_t last_day = INT64_MIN;
+        std::vector<OpTotals>* last_row = nullptr;
+    };
+
+    Shard& local();
+
+    std::array<Shard, kShards> shards_;
+};
+
+struct UserAccounts;
+
+// Account state plus a seqlock-published copy of its balance and metadata.
+// `account` is guarded by owner->mu; summary readers only touch the atomics
+// and never write shared memory.
+struct AccountRecord {
+    AccountRecord(Account acc, UserAccounts* owner_) : account(std::move(acc)), owner(owner_) {}
+    AccountRecord(const AccountRecord&) = delete;
+    AccountRecord& operator=(const AccountRecord&) = delete;
+    ~AccountRecord() { delete hot_.load(std::memory_order_relaxed); }
+
+    Account account;
+    UserAccounts* const owner;
+    std::atomic<AccountRecord*> next{nullptr};
+
+    // Writers hold owner->mu exclusively.
+    void publish();
+    void close();
+    std::optional<AccountSummary> read() const;
+    bool is_open() const { return open_.load(std::memory_order_relaxed); }
+
+    // Created once and kept for the record's lifetime; see HotCredits.
+    HotCredits* hot_credits() const { return hot_.load(std::memory_order_acquire); }
+    HotCredits& enable_hot_credits();
+
+private:
+    void write(bool open);
+
+    std::atomic<HotCredits*> hot_{nullptr};
+
+    std::atomic<uint64_t> seq_{0};  // odd while a publish is in progress
+    std::atomic<double> balance_{0.0};
+    std::atomic<bool> open_{true};
 };
 
 struct UserAccounts {
+    UserAccounts() = default;
+    UserAccounts(const UserAccounts&) = delete;
+    UserAccounts& operator=(const UserAccounts&) = delete;
+    ~UserAccounts();
+
     mutable std::shared_mutex mu;
-    std::unordered_map<uint64_t, Account> accounts;
+    // Append-only list in creation order; owns every record, closed ones included.
+    std::atomic<AccountRecord*> records{nullptr};
+    AccountRecord* tail = nullptr;  // guarded by mu
+    // Running sum of the open accounts' balances by currency, kept by post()
+    // under mu, so the auditor can check an owner without stopping the bank.
+    std::array<double, kMaxCurrencies> totals{};
 };
 
 class BankService : public IBankService {
+    friend class LedgerAuditor;
+
 public:
     uint64_t create_account(uint64_t user_id, Currency currency) override;
     bool close_account(uint64_t user_id, uint64_t account_id) override;
     std::vector<Account> get_accounts(uint64_t user_id) const override;
     std::optional<Account> get_account(uint64_t account_id) const override;
+    std::vector<AccountSummary> get_account_summaries(uint64_t user_id) const override;
+    std::optional<AccountSummary> get_account_summary(uint64_t account_id) const override;
 
     std::optional<double> deposit(uint64_t user_id, uint64_t account_id, double amount) override;
     std::optional<double> withdraw(uint64_t user_id, uint64_t account_id, double amount) override;
     std::optional<TransferResult> transfer(uint64_t user_id, uint64_t from_id,
                                            uint64_t to_id, double amount, double rate = 1.0) override;
+    std::optional<std::vector<TransferResult>> transfer_batch(
+        uint64_t user_id, const std::vector<TransferLeg>& legs, const RateFn& rate = {}) override;
 
-    std::optional<double> debit_for_stock(uint64_t user_id, uint64_t account_id,
-                                           double amount, const std::string& ticker) override;
-    std::optional<double> credit_for_stock(uint64_t user_id, uint64_t account_id,
-                                            double amount, const std::string& ticker) override;
+    std::optional<double> settle_stock(uint64_t user_id, uint64_t account_id, bool is_buy,
+                                       double amount, SymbolId symbol,
+                                       const std::function<bool()>& apply) override;
+    StockSettlement settle_stock_pair(const StockLeg& buyer, const StockLeg& seller, SymbolId symbol,
+                                      const std::function<bool()>& apply) override;
 
     std::vector<HistoryEntry> get_history(uint64_t account_id) const override;
 
+    BankReport build_report(std::size_t workers = 0) const override;
+
+    // Opt-in hot-account mode: incoming transfers are buffered per thread and
+    // folded into the balance on the next debit of the account; reads count
+    // them in meanwhile.
+    bool set_hot_account(uint64_t account_id, bool enabled);
+
+    static constexpr std::size_t kHotFoldThreshold = 256;
+    static constexpr uint64_t kFirstAccountId = 100001;
+
 private:
-    static void record(Account& acc, OpType type, double amount, const std::string& counterparty = "");
+    // Single-step account lookup; the record may have been closed since.
+    AccountRecord* find(uint64_t account_id) const;
+    AccountRecord* find_owned(uint64_t user_id, uint64_t account_id) const;
+
+    // Every balance change goes through post(); caller holds rec.owner->mu
+    // exclusively and brackets it with ledger_.begin()/end().
+    void post(AccountRecord& rec, HistoryEntry entry) const;
+    // Zeroes a closing account's rounding residual out of the balance and
+    // the totals. It is no operation of the user's, so no history entry.
+    void write_off(AccountRecord& rec) const;
+    void record(AccountRecord& rec, OpType type, double amount, std::string_view counterparty = {},
+                SymbolId symbol = kNoSymbol);
+
+    void apply_credits(AccountRecord& rec, std::vector<HistoryEntry>& credits) const;
+    void fold_credits(AccountRecord& rec) const;  // caller holds rec.owner->mu exclusively
+    // Published summary with buffered credits added, without taking owner->mu.
+    std::optional<AccountSummary> read_with_credits(const AccountRecord& rec) const;
+    // The account as a fold would leave it; caller holds rec.owner->mu shared.
+    Account account_with_credits(const AccountRecord& rec) const;
+    std::optional<TransferResult> transfer_to_hot(AccountRecord& from, AccountRecord& to,
+                                                  double amount, double rate);
 
     ConcurrentMap<uint64_t, std::shared_ptr<UserAccounts>> users_;
-    ConcurrentMap<uint64_t, uint64_t> account_index_;  // account_id → user_id
-    std::atomic<uint64_t> next_id_{100001};
+    HandleTable<AccountRecord> accounts_;  // indexed by account_id - kFirstAccountId
+    std::atomic<uint64_t> next_id_{kFirstAccountId};
+    mutable LedgerTotals ledger_;
+    DailyRollup daily_;
 };
@@ -0,0 +1,114 @@
+#include "candle_store.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+std::optional<CandleInterval> candle_interval_from_string(std::string_view s) {
+    if (s == "1s") return CandleInterval::S1;
+    if (s == "1m") return CandleInterval::M1;
+    if (s == "5m") return CandleInterval::M5;
+    if (s == "1h") return CandleInterval::H1;
+    return std::nullopt;
+}
+
+CandleStore::CandleStore(std::size_t symbols, std::size_t capacity)
+    : symbols_(symbols),
+      capacity_(std::max<std::size_t>(1, capacity)),
+      series_(new Series[symbols * kCandleIntervals]) {}
+
+CandleStore::Ring* CandleStore::grow(Series& s, uint64_t count) {
+    Ring* ring = s.ring.load(std::memory_order_relaxed);
+    if (ring && (count < ring->size || ring->size == capacity_)) return ring;
+    // The ring has never wrapped yet, so each bar keeps its slot.
+    const std::size_t size = ring ? std::min(capacity_, ring->size * 2) : std::min(capacity_, kFirstRing);
+    auto& fresh = s.rings.emplace_back(std::make_unique<Ring>(size));
+    for (uint64_t index = 0; index < count; ++index) {
+        const auto& from = ring->bars[index];
+        auto& to = fresh->bars[index];
+        to.start.store(from.start.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.open.store(from.open.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.high.store(from.high.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.low.store(from.low.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.close.store(from.close.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    allocated_.fetch_add(size, std::memory_order_relaxed);
+    s.ring.store(fresh.get(), std::memory_order_release);
+    return fresh.get();
+}
+
+void CandleStore::update(const std::vector<double>& quotes, TimePoint time) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    const std::size_t n = std::min(symbols_, quotes.size());
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        const double price = quotes[symbol];
+        for (std::size_t i = 0; i < kCandleIntervals; ++i) {
+            const auto interval = static_cast<CandleInterval>(i);
+            const int64_t bucket = now - now % kCandleSeconds[i];
+            auto& s = series(symbol, interval);
+            Ring* ring = s.ring.load(std::memory_order_relaxed);
+            const uint64_t count = s.count.load(std::memory_order_relaxed);
+            const uint64_t seq = s.seq.load(std::memory_order_relaxed);
+            s.seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            Bar* last = count ? &ring->bars[(count - 1) % ring->size] : nullptr;
+            // A clock that steps back (a replayed file, NTP) folds into the open bar.
+            if (last && bucket <= last->start.load(std::memory_order_relaxed)) {
+                if (price > last->high.load(std::memory_order_relaxed)) last->high.store(price, std::memory_order_relaxed);
+                if (price < last->low.load(std::memory_order_relaxed)) last->low.store(price, std::memory_order_relaxed);
+                last->close.store(price, std::memory_order_relaxed);
+            } else {
+                ring = grow(s, count);
+                auto& bar = ring->bars[count % ring->size];
+                bar.start.store(bucket, std::memory_order_relaxed);
+                bar.open.store(price, std::memory_order_relaxed);
+                bar.high.store(price, std::memory_order_relaxed);
+                bar.low.store(price, std::memory_order_relaxed);
+                bar.close.store(price, std::memory_order_relaxed);
+                s.count.store(count + 1, std::memory_order_relaxed);
+            }
+            s.seq.store(seq + 2, std::memory_order_release);
+        }
+    }
+}
+
+std::vector<Candle> CandleStore::range(SymbolId symbol, CandleInterval interval,
+                                       int64_t from, int64_t to, std::size_t limit) const {
+    std::vector<Candle> out;
+    if (symbol >= symbols_ || limit == 0 || from > to) return out;
+    const auto& s = series(symbol, interval);
+    out.reserve(std::min(limit, capacity_));
+    for (;;) {
+        const uint64_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        out.clear();
+        const Ring* ring = s.ring.load(std::memory_order_acquire);
+        const uint64_t count = ring ? s.count.load(std::memory_order_relaxed) : 0;
+        const std::size_t size = ring ? ring->size : 1;
+        const uint64_t oldest = count > size ? count - size : 0;
+        auto start_at = [&](uint64_t index) { return ring->bars[index % size].start.load(std::memory_order_relaxed); };
+        // Bars are in start order, so both ends are binary searches.
+        auto first_not_before = [&](int64_t t, bool inclusive) {
+            uint64_t lo = oldest, hi = count;
+            while (lo < hi) {
+                const uint64_t mid = lo + (hi - lo) / 2;
+                if (inclusive ? start_at(mid) <= t : start_at(mid) < t) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        };
+        const uint64_t end = first_not_before(to, true);
+        const uint64_t begin = std::max(first_not_before(from, false), end > limit ? end - limit : 0);
+        for (uint64_t index = begin; index < end; ++index) {
+            const auto& bar = ring->bars[index % size];
+            out.push_back({bar.start.load(std::memory_order_relaxed), bar.open.load(std::memory_order_relaxed),
+                           bar.high.load(std::memory_order_relaxed), bar.low.load(std::memory_order_relaxed),
+                           bar.close.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) == seq) return out;
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "models.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+enum class CandleInterval : uint8_t { S1, M1, M5, H1 };
+
+constexpr std::size_t kCandleIntervals = 4;
+constexpr std::array<int64_t, kCandleIntervals> kCandleSeconds = {1, 60, 300, 3600};
+
+std::optional<CandleInterval> candle_interval_from_string(std::string_view s);
+
+struct Candle {
+    int64_t start = 0;  // epoch seconds, a multiple of the interval
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+};
+
+// OHLC bars per symbol and interval, each series a ring of the most recent
+// bars. A ring starts small on the series' first bar and doubles as bars
+// open until it reaches the capacity, so slow intervals and idle symbols
+// hold little memory. One thread feeds ticks; readers copy bars out under a
+// per-series seqlock and never block the writer. Intervals without a tick
+// have no bar.
+class CandleStore {
+public:
+    static constexpr std::size_t kDefaultCapacity = 256;
+    static constexpr std::size_t kFirstRing = 8;
+
+    explicit CandleStore(std::size_t symbols, std::size_t capacity = kDefaultCapacity);
+
+    CandleStore(const CandleStore&) = delete;
+    CandleStore& operator=(const CandleStore&) = delete;
+
+    // Folds one tick into every interval; `quotes` is indexed by SymbolId.
+    // Single writer.
+    void update(const std::vector<double>& quotes, TimePoint time);
+
+    // Bars with from <= start <= to, oldest first, at most the `limit` most
+    // recent of them. O(log capacity + bars returned).
+    std::vector<Candle> range(SymbolId symbol, CandleInterval interval,
+                              int64_t from, int64_t to, std::size_t limit) const;
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t allocated_bars() const { return allocated_.load(std::memory_order_relaxed); }
+
+private:
+    // Fields are atomics so a reader racing the writer is well defined; the
+    // sequence number tells it to retry.
+    struct Bar {
+        std::atomic<int64_t> start{0};
+        std::atomic<double> open{0.0};
+        std::atomic<double> high{0.0};
+        std::atomic<double> low{0.0};
+        std::atomic<double> close{0.0};
+    };
+
+    struct Ring {
+        explicit Ring(std::size_t n) : size(n), bars(new Bar[n]) {}
+        const std::size_t size;
+        std::unique_ptr<Bar[]> bars;
+    };
+
+    struct alignas(64) Series {
+        std::atomic<uint64_t> seq{0};    // odd while the writer is inside
+        std::atomic<uint64_t> count{0};  // bars ever opened; the newest is at (count - 1) % ring size
+        std::atomic<Ring*> ring{nullptr};
+        // Every ring the series has had; outgrown ones stay until the store
+        // goes, since a reader may still be copying out of them. Writer only.
+        std::vector<std::unique_ptr<Ring>> rings;
+    };
+
+    Series& series(SymbolId symbol, CandleInterval interval) const {
+        return series_[symbol * kCandleIntervals + static_cast<std::size_t>(interval)];
+    }
+    // Returns a ring with room for one more bar without dropping one still
+    // under the capacity; called inside the writer's odd sequence.
+    Ring* grow(Series& s, uint64_t count);
+
+    const std::size_t symbols_;
+    const std::size_t capacity_;
+    std::unique_ptr<Series[]> series_;
+    std::atomic<std::size_t> allocated_{0};
+};
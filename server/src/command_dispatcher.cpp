@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <limits>
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace {
 
@@ -20,6 +22,17 @@ bool extract_required(const nlohmann::json& request, const char* key, T& out) {
     }
 }
 
+// Borrows a string field from the request instead of copying it; the view
+// lives as long as `request`.
+bool extract_view(const nlohmann::json& request, const char* key, std::string_view& out) {
+    auto it = request.find(key);
+    if (it == request.end() || !it->is_string()) {
+        return false;
+    }
+    out = it->get_ref<const std::string&>();
+    return true;
+}
+
 bool extract_optional_epoch_seconds(const nlohmann::json& request, const char* key,
                                     std::optional<int64_t>& out) {
     if (!request.contains(key)) {
@@ -51,14 +64,33 @@ bool extract_optional_epoch_seconds(const nlohmann::json& request, const char* k
     return false;
 }
 
+// Whole epoch seconds as a TimePoint, clamped to the clock's range.
+TimePoint saturating_seconds(int64_t seconds) {
+    using std::chrono::duration_cast;
+    constexpr auto kMax = duration_cast<std::chrono::seconds>(TimePoint::duration::max()).count();
+    constexpr auto kMin = duration_cast<std::chrono::seconds>(TimePoint::duration::min()).count();
+    if (seconds >= kMax) return TimePoint::max();
+    if (seconds <= kMin) return TimePoint::min();
+    return TimePoint(std::chrono::seconds(seconds));
+}
+
 }  // namespace
 
-CommandDispatcher::CommandDispatcher(IAuthService& auth, IBankService& bank, IStockService& stock, PriceEngine& prices)
-    : auth_(auth), bank_(bank), stock_(stock), prices_(prices) {}
+CommandDispatcher::CommandDispatcher(IAuthService& auth, IBankService& bank, IStockService& stock, PriceEngine& prices,
+                                     OrderService* orders, TriggerService* triggers, TradeSequencer* sequencer)
+    : auth_(auth), bank_(bank), stock_(stock), prices_(prices), orders_(orders), triggers_(triggers),
+      sequencer_(sequencer) {
+    if (orders_) {
+        orders_->on_event([this](const OrderEvent& event) { notify(event); });
+    }
+    if (triggers_) {
+        triggers_->on_fire([this](const TriggerEvent& event) { notify(event); });
+    }
+}
 
 nlohmann::json CommandDispatcher::handle_message(const nlohmann::json& request) const {
-    std::string type;
-    if (!extract_required(request, "type", type)) {
+    std::string_view type;
+    if (!extract_view(request, "type", type)) {
         return error_response("Missing field: type");
     }
 
@@ -71,13 +103,20 @@ nlohmann::json CommandDispatcher::handle_message(const nlohmann::json& request)
     if (type == "deposit") return handle_deposit(request);
     if (type == "withdraw") return handle_withdraw(request);
     if (type == "transfer") return handle_transfer(request);
+    if (type == "batch_transfer") return handle_batch_transfer(request);
     if (type == "get_history") return handle_get_history(request);
     if (type == "get_quotes") return handle_get_quotes(request);
+    if (type == "get_candles") return handle_get_candles(request);
     if (type == "get_exchange_rates") return handle_get_exchange_rates(request);
     if (type == "buy_stock") return handle_buy_stock(request);
     if (type == "sell_stock") return handle_sell_stock(request);
     if (type == "get_portfolio") return handle_get_portfolio(request);
     if (type == "get_trades") return handle_get_trades(request);
+    if (type == "place_order") return handle_place_order(request);
+    if (type == "cancel_order") return handle_cancel_order(request);
+    if (type == "amend_order") return handle_amend_order(request);
+    if (type == "set_trigger") return handle_set_trigger(request);
+    if (type == "cancel_trigger") return handle_cancel_trigger(request);
 
     return error_response("Unknown command type");
 }
@@ -100,10 +139,10 @@ nlohmann::json CommandDispatcher::handle_register(const nlohmann::json& request)
 }
 
 nlohmann::json CommandDispatcher::handle_login(const nlohmann::json& request) const {
-    std::string username;
-    std::string password;
-    if (!extract_required(request, "username", username) ||
-        !extract_required(request, "password", password)) {
+    std::string_view username;
+    std::string_view password;
+    if (!extract_view(request, "username", username) ||
+        !extract_view(request, "password", password)) {
         return error_response("Missing field: username/password");
     }
 
@@ -117,14 +156,18 @@ nlohmann::json CommandDispatcher::handle_login(const nlohmann::json& request) co
 }
 
 nlohmann::json CommandDispatcher::handle_logout(const nlohmann::json& request) const {
-    std::string token;
-    if (!extract_required(request, "token", token)) {
+    std::string_view token;
+    if (!extract_view(request, "token", token)) {
         return error_response("Missing field: token");
     }
 
+    const auto user_id = auth_.validate(token);
     if (!auth_.logout(token)) {
         return error_response("Invalid token");
     }
+    // Every session logged in with the token stops receiving pushes, on
+    // this connection or any other.
+    if (user_id) sessions_.revoke(*user_id, token);
 
     return {{"status", "ok"}};
 }
@@ -138,9 +181,10 @@ nlohmann::json CommandDispatcher::handle_create_account(const nlohmann::json& re
         return error_response("Missing field: currency");
     }
     auto currency = currency_from_string(currency_str);
-    if (!currency) return error_response("Invalid currency");
+    if (!currency || !prices_.quotes_currency(*currency)) return error_response("Invalid currency");
 
     auto account_id = bank_.create_account(*user_id, *currency);
+    if (account_id == kNoAccount) return error_response("Account limit reached");
     return {
         {"status", "ok"},
         {"account_id", account_id}
@@ -151,7 +195,7 @@ nlohmann::json CommandDispatcher::handle_get_accounts(const nlohmann::json& requ
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    auto accounts = bank_.get_accounts(*user_id);
+    auto accounts = bank_.get_account_summaries(*user_id);
     nlohmann::json arr = nlohmann::json::array();
     for (const auto& account : accounts) {
         arr.push_back({
@@ -240,8 +284,8 @@ nlohmann::json CommandDispatcher::handle_transfer(const nlohmann::json& request)
         return error_response("Missing field: from_account/to_account/amount");
     }
 
-    auto from = bank_.get_account(from_account);
-    auto to = bank_.get_account(to_account);
+    auto from = bank_.get_account_summary(from_account);
+    auto to = bank_.get_account_summary(to_account);
     if (!from || !to) {
         return error_response("Account not found");
     }
@@ -251,6 +295,7 @@ nlohmann::json CommandDispatcher::handle_transfer(const nlohmann::json& request)
     if (!transfer_result) {
         return error_response("Transfer failed");
     }
+    notify_transfer(*user_id, *to, transfer_result->converted_amount);
 
     return {
         {"status", "ok"},
@@ -260,6 +305,55 @@ nlohmann::json CommandDispatcher::handle_transfer(const nlohmann::json& request)
     };
 }
 
+nlohmann::json CommandDispatcher::handle_batch_transfer(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+
+    if (!request.contains("legs") || !request.at("legs").is_array() || request.at("legs").empty()) {
+        return error_response("Missing field: legs");
+    }
+
+    std::vector<TransferLeg> legs;
+    legs.reserve(request.at("legs").size());
+    for (const auto& item : request.at("legs")) {
+        TransferLeg leg{};
+        if (!item.is_object() ||
+            !extract_required(item, "from_account", leg.from_id) ||
+            !extract_required(item, "to_account", leg.to_id) ||
+            !extract_required(item, "amount", leg.amount)) {
+            return error_response("Invalid leg: from_account/to_account/amount");
+        }
+        legs.push_back(leg);
+    }
+
+    auto results = bank_.transfer_batch(*user_id, legs, [this](Currency from, Currency to) {
+        return prices_.get_rate(from, to);
+    });
+    if (!results) {
+        return error_response("Batch transfer failed");
+    }
+
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (auto to = bank_.get_account_summary(legs[i].to_id)) {
+            notify_transfer(*user_id, *to, (*results)[i].converted_amount);
+        }
+    }
+
+    nlohmann::json out = nlohmann::json::array();
+    for (const auto& r : *results) {
+        out.push_back({
+            {"from_balance", r.from_balance},
+            {"to_balance", r.to_balance},
+            {"converted_amount", r.converted_amount}
+        });
+    }
+
+    return {
+        {"status", "ok"},
+        {"results", out}
+    };
+}
+
 nlohmann::json CommandDispatcher::handle_get_history(const nlohmann::json& request) const {
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
@@ -269,7 +363,7 @@ nlohmann::json CommandDispatcher::handle_get_history(const nlohmann::json& reque
         return error_response("Missing field: account_id");
     }
 
-    auto account = bank_.get_account(account_id);
+    auto account = bank_.get_account_summary(account_id);
     if (!account || account->user_id != *user_id) {
         return error_response("Account not found");
     }
@@ -328,7 +422,7 @@ nlohmann::json CommandDispatcher::handle_get_history(const nlohmann::json& reque
             {"op_type", to_string(entry.type)},
             {"amount", entry.amount},
             {"balance_after", entry.balance_after},
-            {"counterparty", entry.counterparty}
+            {"counterparty", entry.symbol != kNoSymbol ? prices_.symbols().name(entry.symbol) : entry.counterparty}
         });
     }
 
@@ -342,11 +436,10 @@ nlohmann::json CommandDispatcher::handle_get_quotes(const nlohmann::json& reques
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    auto quotes = prices_.get_all_quotes();
     nlohmann::json arr = nlohmann::json::array();
-    for (const auto& [ticker, price] : quotes) {
+    prices_.for_each_quote([&](const std::string& ticker, double price) {
         arr.push_back({{"ticker", ticker}, {"price", price}});
-    }
+    });
 
     return {
         {"status", "ok"},
@@ -354,20 +447,67 @@ nlohmann::json CommandDispatcher::handle_get_quotes(const nlohmann::json& reques
     };
 }
 
+nlohmann::json CommandDispatcher::handle_get_candles(const nlohmann::json& request) const {
+    constexpr std::size_t kDefaultLimit = 100;
+
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+
+    std::string_view ticker, interval_str;
+    if (!extract_view(request, "ticker", ticker)) return error_response("Missing field: ticker");
+    if (!extract_view(request, "interval", interval_str)) return error_response("Missing field: interval");
+    auto symbol = prices_.symbols().find(ticker);
+    if (!symbol) return error_response("Unknown ticker");
+    auto interval = candle_interval_from_string(interval_str);
+    if (!interval) return error_response("Invalid interval");
+
+    std::optional<int64_t> from, to;
+    if (!extract_optional_epoch_seconds(request, "from", from) ||
+        !extract_optional_epoch_seconds(request, "to", to)) {
+        return error_response("Invalid field: from/to");
+    }
+    std::size_t limit = kDefaultLimit;
+    if (request.contains("limit") && (!extract_required(request, "limit", limit) || limit == 0)) {
+        return error_response("Invalid field: limit");
+    }
+
+    const auto candles = prices_.candles().range(*symbol, *interval, from.value_or(INT64_MIN),
+                                                 to.value_or(INT64_MAX), limit);
+    nlohmann::json out = nlohmann::json::array();
+    for (const auto& c : candles) {
+        out.push_back({
+            {"timestamp", c.start},
+            {"open", c.open},
+            {"high", c.high},
+            {"low", c.low},
+            {"close", c.close}
+        });
+    }
+
+    return {
+        {"status", "ok"},
+        {"candles", out}
+    };
+}
+
 nlohmann::json CommandDispatcher::handle_get_exchange_rates(const nlohmann::json& request) const {
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
+    // Every ordered pair of quoted currencies, all from one tick.
+    nlohmann::json rates = nlohmann::json::object();
+    prices_.read([&](const MarketSnapshot& s) {
+        for (std::size_t from = 0; from < s.usd_rates.size(); ++from) {
+            for (std::size_t to = 0; to < s.usd_rates.size(); ++to) {
+                const double rate = s.rate(static_cast<Currency>(from), static_cast<Currency>(to));
+                if (from == to || rate == 0.0) continue;
+                rates[to_string(static_cast<Currency>(from)) + '_' + to_string(static_cast<Currency>(to))] = rate;
+            }
+        }
+    });
     return {
         {"status", "ok"},
-        {"rates", {
-            {"USD_RUB", prices_.get_rate(Currency::USD, Currency::RUB)},
-            {"EUR_RUB", prices_.get_rate(Currency::EUR, Currency::RUB)},
-            {"USD_EUR", prices_.get_rate(Currency::USD, Currency::EUR)},
-            {"RUB_USD", prices_.get_rate(Currency::RUB, Currency::USD)},
-            {"RUB_EUR", prices_.get_rate(Currency::RUB, Currency::EUR)},
-            {"EUR_USD", prices_.get_rate(Currency::EUR, Currency::USD)}
-        }}
+        {"rates", std::move(rates)}
     };
 }
 
@@ -375,16 +515,23 @@ nlohmann::json CommandDispatcher::handle_buy_stock(const nlohmann::json& request
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    std::string ticker;
+    std::string_view ticker;
     int quantity;
     uint64_t account_id;
-    if (!extract_required(request, "ticker", ticker) ||
+    if (!extract_view(request, "ticker", ticker) ||
         !extract_required(request, "quantity", quantity) ||
         !extract_required(request, "account_id", account_id)) {
         return error_response("Missing field: ticker/quantity/account_id");
     }
 
-    auto result = stock_.buy(*user_id, ticker, quantity, account_id);
+    std::optional<BuyResult> result;
+    if (auto symbol = prices_.symbols().find(ticker)) {
+        if (!sequencer_) {
+            result = stock_.buy(*user_id, *symbol, quantity, account_id);
+        } else if (auto out = sequencer_->execute({*user_id, account_id, *symbol, quantity, true})) {
+            result = out->bought;
+        }
+    }
     if (!result) {
         return error_response("Buy failed");
     }
@@ -401,16 +548,23 @@ nlohmann::json CommandDispatcher::handle_sell_stock(const nlohmann::json& reques
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    std::string ticker;
+    std::string_view ticker;
     int quantity;
     uint64_t account_id;
-    if (!extract_required(request, "ticker", ticker) ||
+    if (!extract_view(request, "ticker", ticker) ||
         !extract_required(request, "quantity", quantity) ||
         !extract_required(request, "account_id", account_id)) {
         return error_response("Missing field: ticker/quantity/account_id");
     }
 
-    auto result = stock_.sell(*user_id, ticker, quantity, account_id);
+    std::optional<SellResult> result;
+    if (auto symbol = prices_.symbols().find(ticker)) {
+        if (!sequencer_) {
+            result = stock_.sell(*user_id, *symbol, quantity, account_id);
+        } else if (auto out = sequencer_->execute({*user_id, account_id, *symbol, quantity, false})) {
+            result = out->sold;
+        }
+    }
     if (!result) {
         return error_response("Sell failed");
     }
@@ -427,48 +581,301 @@ nlohmann::json CommandDispatcher::handle_get_portfolio(const nlohmann::json& req
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    auto positions = stock_.get_portfolio(*user_id);
+    // Valuations are kept current by StockService; nothing is priced here.
+    const auto portfolio = stock_.get_portfolio_snapshot(*user_id);
     nlohmann::json out = nlohmann::json::array();
-    for (const auto& pos : positions) {
-        const double current = prices_.get_quote(pos.ticker);
-        const double pnl = (current - pos.avg_price) * static_cast<double>(pos.quantity);
+    for (const auto& pos : portfolio.positions) {
         out.push_back({
-            {"ticker", pos.ticker},
+            {"ticker", prices_.symbols().name(pos.symbol)},
             {"quantity", pos.quantity},
             {"avg_price", pos.avg_price},
-            {"current_price", current},
-            {"pnl", pnl}
+            {"current_price", pos.mark},
+            {"market_value", pos.market_value},
+            {"pnl", pos.unrealized_pnl}
         });
     }
 
     return {
         {"status", "ok"},
-        {"positions", out}
+        {"positions", out},
+        {"totals", {
+            {"market_value", portfolio.totals.market_value},
+            {"cost_basis", portfolio.totals.cost_basis},
+            {"pnl", portfolio.totals.unrealized_pnl}
+        }},
+        {"version", portfolio.version},
+        {"tick", portfolio.tick}
     };
 }
 
 nlohmann::json CommandDispatcher::handle_get_trades(const nlohmann::json& request) const {
+    constexpr std::size_t kDefaultLimit = 100;
+    constexpr std::size_t kMaxLimit = 1000;
+
     auto user_id = user_id_from_token(request);
     if (!user_id) return unauthorized();
 
-    auto trades = stock_.get_trades(*user_id);
+    // Pages of kDefaultLimit unless the client asks for a size, or for the
+    // whole matching history with "all": true.
+    TradeQuery query;
+    query.limit = kDefaultLimit;
+    bool all = false;
+    if (request.contains("all") && !extract_required(request, "all", all)) {
+        return error_response("Invalid field: all");
+    }
+    if (request.contains("limit") &&
+        (all || !extract_required(request, "limit", query.limit) || query.limit == 0 || query.limit > kMaxLimit)) {
+        return error_response("Invalid field: limit");
+    }
+    if (all) query.limit = std::numeric_limits<std::size_t>::max();
+    if (request.contains("cursor")) {
+        uint64_t cursor;
+        if (!extract_required(request, "cursor", cursor)) return error_response("Invalid field: cursor");
+        query.before = cursor;
+    }
+    std::string_view ticker, side;
+    if (request.contains("ticker")) {
+        if (!extract_view(request, "ticker", ticker)) return error_response("Invalid field: ticker");
+        query.symbol = prices_.symbols().find(ticker);
+        if (!query.symbol) return error_response("Unknown ticker");
+    }
+    if (request.contains("side")) {
+        auto parsed = extract_view(request, "side", side) ? side_from_string(side) : std::nullopt;
+        if (!parsed) return error_response("Invalid field: side");
+        query.is_buy = *parsed == Side::Buy;
+    }
+    std::optional<int64_t> from_date, to_date;
+    if (!extract_optional_epoch_seconds(request, "from_date", from_date) ||
+        !extract_optional_epoch_seconds(request, "to_date", to_date)) {
+        return error_response("Invalid field: from_date/to_date");
+    }
+    if (from_date && to_date && *from_date > *to_date) {
+        return error_response("Invalid date range");
+    }
+    // Dates are whole seconds and to_date is inclusive; out-of-range dates
+    // clamp to the clock's range.
+    if (from_date) query.from = saturating_seconds(*from_date);
+    if (to_date && *to_date < INT64_MAX) query.until = saturating_seconds(*to_date + 1);
+
+    const auto page = stock_.get_trades(*user_id, query);
     nlohmann::json out = nlohmann::json::array();
-    for (const auto& trade : trades) {
+    for (const auto& trade : page.trades) {
         const auto ts = std::chrono::duration_cast<std::chrono::seconds>(
             trade.timestamp.time_since_epoch()).count();
         out.push_back({
             {"timestamp", ts},
-            {"ticker", trade.ticker},
+            {"ticker", prices_.symbols().name(trade.symbol)},
             {"side", trade.is_buy ? "buy" : "sell"},
             {"quantity", trade.quantity},
-            {"price", trade.price}
+            {"price", trade.price},
+            {"tick", trade.tick}
         });
     }
 
     return {
         {"status", "ok"},
-        {"trades", out}
+        {"trades", out},
+        {"next_cursor", page.next_cursor ? nlohmann::json(*page.next_cursor) : nlohmann::json()}
+    };
+}
+
+nlohmann::json CommandDispatcher::handle_place_order(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+    if (!orders_) return error_response("Order book disabled");
+
+    std::string_view ticker;
+    std::string_view side_str;
+    double price;
+    int quantity;
+    uint64_t account_id;
+    if (!extract_view(request, "ticker", ticker) ||
+        !extract_view(request, "side", side_str) ||
+        !extract_required(request, "price", price) ||
+        !extract_required(request, "quantity", quantity) ||
+        !extract_required(request, "account_id", account_id)) {
+        return error_response("Missing field: ticker/side/price/quantity/account_id");
+    }
+    auto side = side_from_string(side_str);
+    if (!side) return error_response("Invalid side");
+
+    std::optional<PlaceResult> result;
+    if (auto symbol = prices_.symbols().find(ticker)) {
+        result = orders_->place(*user_id, *symbol, *side, price, quantity, account_id);
+    }
+    if (!result) {
+        return error_response("Order rejected");
+    }
+
+    return {
+        {"status", "ok"},
+        {"order_id", result->order_id},
+        {"filled", result->filled},
+        {"remaining", result->remaining}
+    };
+}
+
+nlohmann::json CommandDispatcher::handle_cancel_order(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+    if (!orders_) return error_response("Order book disabled");
+
+    uint64_t order_id;
+    if (!extract_required(request, "order_id", order_id)) {
+        return error_response("Missing field: order_id");
+    }
+
+    if (!orders_->cancel(*user_id, order_id)) {
+        return error_response("Order not found");
+    }
+
+    return {{"status", "ok"}};
+}
+
+nlohmann::json CommandDispatcher::handle_amend_order(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+    if (!orders_) return error_response("Order book disabled");
+
+    uint64_t order_id;
+    if (!extract_required(request, "order_id", order_id)) {
+        return error_response("Missing field: order_id");
+    }
+    auto current = orders_->find(*user_id, order_id);
+    if (!current) {
+        return error_response("Order not found");
+    }
+
+    // Whichever of price/quantity is omitted keeps its current value.
+    double price = current->price;
+    int quantity = current->remaining;
+    if ((request.contains("price") && !extract_required(request, "price", price)) ||
+        (request.contains("quantity") && !extract_required(request, "quantity", quantity))) {
+        return error_response("Invalid field: price/quantity");
+    }
+
+    auto result = orders_->amend(*user_id, order_id, price, quantity);
+    if (!result) {
+        return error_response("Amend failed");
+    }
+
+    return {
+        {"status", "ok"},
+        {"order_id", result->order_id},
+        {"filled", result->filled},
+        {"remaining", result->remaining}
+    };
+}
+
+nlohmann::json CommandDispatcher::handle_set_trigger(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+    if (!triggers_) return error_response("Triggers disabled");
+
+    std::string_view ticker;
+    std::string_view kind_str;
+    double trigger_price;
+    int quantity;
+    uint64_t account_id;
+    if (!extract_view(request, "ticker", ticker) ||
+        !extract_view(request, "kind", kind_str) ||
+        !extract_required(request, "trigger_price", trigger_price) ||
+        !extract_required(request, "quantity", quantity) ||
+        !extract_required(request, "account_id", account_id)) {
+        return error_response("Missing field: ticker/kind/trigger_price/quantity/account_id");
+    }
+    auto kind = trigger_kind_from_string(kind_str);
+    if (!kind) return error_response("Invalid kind");
+
+    std::optional<uint64_t> trigger_id;
+    if (auto symbol = prices_.symbols().find(ticker)) {
+        trigger_id = triggers_->arm(*user_id, *symbol, *kind, trigger_price, quantity, account_id);
+    }
+    if (!trigger_id) {
+        return error_response("Trigger rejected");
+    }
+
+    return {
+        {"status", "ok"},
+        {"trigger_id", *trigger_id}
+    };
+}
+
+nlohmann::json CommandDispatcher::handle_cancel_trigger(const nlohmann::json& request) const {
+    auto user_id = user_id_from_token(request);
+    if (!user_id) return unauthorized();
+    if (!triggers_) return error_response("Triggers disabled");
+
+    uint64_t trigger_id;
+    if (!extract_required(request, "trigger_id", trigger_id)) {
+        return error_response("Missing field: trigger_id");
+    }
+
+    if (!triggers_->cancel(*user_id, trigger_id)) {
+        return error_response("Trigger not found");
+    }
+
+    return {{"status", "ok"}};
+}
+
+void CommandDispatcher::notify(const OrderEvent& event) const {
+    if (event.kind == OrderEvent::Kind::Fill) {
+        sessions_.push(event.user_id, {
+            {"type", "notification"},
+            {"event", "order_fill"},
+            {"order_id", event.order_id},
+            {"ticker", prices_.symbols().name(event.symbol)},
+            {"side", to_string(event.side)},
+            {"price", event.price},
+            {"quantity", event.quantity},
+            {"remaining", event.remaining}
+        });
+        return;
+    }
+    sessions_.push(event.user_id, {
+        {"type", "notification"},
+        {"event", "order_rejected"},
+        {"order_id", event.order_id},
+        {"ticker", prices_.symbols().name(event.symbol)},
+        {"side", to_string(event.side)},
+        {"cancelled", event.quantity}
+    });
+}
+
+void CommandDispatcher::notify_transfer(uint64_t from_user, const AccountSummary& to, double amount) const {
+    // Runs after the bank has committed and released its locks; pushing only
+    // posts to the recipient's strands, so a slow reader never holds up the sender.
+    if (to.user_id == from_user || sessions_.sessions(to.user_id) == 0) return;
+    sessions_.push(to.user_id, {
+        {"type", "notification"},
+        {"event", "incoming_transfer"},
+        {"from_user", auth_.username(from_user).value_or("")},
+        {"amount", amount},
+        {"currency", to_string(to.currency)},
+        {"account_id", to.id}
+    });
+}
+
+void CommandDispatcher::notify(const TriggerEvent& event) const {
+    nlohmann::json push = {
+        {"type", "notification"},
+        {"event", "trigger_fired"},
+        {"trigger_id", event.trigger_id},
+        {"ticker", prices_.symbols().name(event.symbol)},
+        {"kind", to_string(event.kind)},
+        {"trigger_price", event.trigger_price},
+        {"quantity", event.quantity}
     };
+    if (event.sale) {
+        push["status"] = "ok";
+        push["price"] = event.sale->price;
+        push["total_revenue"] = event.sale->total_revenue;
+        push["new_balance"] = event.sale->new_balance;
+    } else {
+        push["status"] = "error";
+        push["message"] = "Sell failed";
+    }
+    sessions_.push(event.user_id, push);
 }
 
 nlohmann::json CommandDispatcher::unauthorized() const {
@@ -483,8 +890,8 @@ nlohmann::json CommandDispatcher::error_response(const std::string& message) con
 }
 
 std::optional<uint64_t> CommandDispatcher::user_id_from_token(const nlohmann::json& request) const {
-    std::string token;
-    if (!extract_required(request, "token", token)) {
+    std::string_view token;
+    if (!extract_view(request, "token", token)) {
         return std::nullopt;
     }
 
@@ -2,17 +2,30 @@
 
 #include "auth_service.hpp"
 #include "bank_service.hpp"
+#include "order_service.hpp"
 #include "price_engine.hpp"
+#include "session_registry.hpp"
 #include "stock_service.hpp"
+#include "trade_sequencer.hpp"
+#include "trigger_service.hpp"
 
 #include <nlohmann/json.hpp>
 
 class CommandDispatcher {
 public:
-    CommandDispatcher(IAuthService& auth, IBankService& bank, IStockService& stock, PriceEngine& prices);
+    // Without an OrderService or TriggerService the order or trigger
+    // commands answer with an error. With a TradeSequencer, buy_stock and
+    // sell_stock execute through it and wait for the outcome.
+    CommandDispatcher(IAuthService& auth, IBankService& bank, IStockService& stock, PriceEngine& prices,
+                      OrderService* orders = nullptr, TriggerService* triggers = nullptr,
+                      TradeSequencer* sequencer = nullptr);
 
     nlohmann::json handle_message(const nlohmann::json& request) const;
 
+    std::optional<uint64_t> authenticate(std::string_view token) const { return auth_.validate(token); }
+    // Sessions bind here on login; notifications fan out through it.
+    SessionRegistry& sessions() const { return sessions_; }
+
 private:
     nlohmann::json handle_register(const nlohmann::json& request) const;
     nlohmann::json handle_login(const nlohmann::json& request) const;
@@ -24,15 +37,29 @@ private:
     nlohmann::json handle_deposit(const nlohmann::json& request) const;
     nlohmann::json handle_withdraw(const nlohmann::json& request) const;
     nlohmann::json handle_transfer(const nlohmann::json& request) const;
+    nlohmann::json handle_batch_transfer(const nlohmann::json& request) const;
     nlohmann::json handle_get_history(const nlohmann::json& request) const;
 
     nlohmann::json handle_get_quotes(const nlohmann::json& request) const;
+    nlohmann::json handle_get_candles(const nlohmann::json& request) const;
     nlohmann::json handle_get_exchange_rates(const nlohmann::json& request) const;
     nlohmann::json handle_buy_stock(const nlohmann::json& request) const;
     nlohmann::json handle_sell_stock(const nlohmann::json& request) const;
     nlohmann::json handle_get_portfolio(const nlohmann::json& request) const;
     nlohmann::json handle_get_trades(const nlohmann::json& request) const;
 
+    nlohmann::json handle_place_order(const nlohmann::json& request) const;
+    nlohmann::json handle_cancel_order(const nlohmann::json& request) const;
+    nlohmann::json handle_amend_order(const nlohmann::json& request) const;
+
+    nlohmann::json handle_set_trigger(const nlohmann::json& request) const;
+    nlohmann::json handle_cancel_trigger(const nlohmann::json& request) const;
+
+    void notify(const OrderEvent& event) const;
+    void notify(const TriggerEvent& event) const;
+    // Tells the owner of `to` that `amount` of its currency arrived from `from_user`.
+    void notify_transfer(uint64_t from_user, const AccountSummary& to, double amount) const;
+
     nlohmann::json unauthorized() const;
     nlohmann::json error_response(const std::string& message) const;
 
@@ -42,4 +69,8 @@ private:
     IBankService& bank_;
     IStockService& stock_;
     PriceEngine& prices_;
+    OrderService* orders_;
+    TriggerService* triggers_;
+    TradeSequencer* sequencer_;
+    mutable SessionRegistry sessions_;
 };
@@ -1,65 +1,245 @@
 #pragma once
-#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
-#include <unordered_map>
 #include <optional>
 #include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
-template<typename K, typename V, size_t Shards = 16>
+namespace detail {
+
+// std::hash is the identity for integers; spread the bits before they pick
+// a shard and a slot (MurmurHash3 finalizer).
+inline uint64_t mix_hash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h ? h : 1;  // 0 marks an empty slot
+}
+
+// Lookups on string-keyed maps take std::string_view, so a caller holding a
+// view into a request never builds a std::string just to probe. The standard
+// guarantees both hashers agree on equal contents.
+template<typename K>
+struct Lookup {
+    using type = const K&;
+    using hasher = std::hash<K>;
+};
+
+template<>
+struct Lookup<std::string> {
+    using type = std::string_view;
+    using hasher = std::hash<std::string_view>;
+};
+
+template<typename K>
+using lookup_t = typename Lookup<K>::type;
+
+template<typename K>
+uint64_t hash_key(lookup_t<K> key) {
+    return mix_hash(typename Lookup<K>::hasher{}(key));
+}
+
+// Linear-probing table: a dense array of hashes is probed first, entries are
+// touched only on a hash match. Erase shifts the run back instead of leaving
+// tombstones, so lookups never scan dead slots.
+template<typename K, typename V>
+class FlatTable {
+public:
+    V* find(lookup_t<K> key, uint64_t hash) {
+        if (hashes_.empty()) return nullptr;
+        for (std::size_t i = hash & mask(); hashes_[i]; i = (i + 1) & mask())
+            if (hashes_[i] == hash && entries_[i]->first == key) return &entries_[i]->second;
+        return nullptr;
+    }
+
+    const V* find(lookup_t<K> key, uint64_t hash) const {
+        return const_cast<FlatTable*>(this)->find(key, hash);
+    }
+
+    // Returns the slot for `key`, default-constructing the value if absent.
+    std::pair<V*, bool> try_emplace(const K& key, uint64_t hash) {
+        if (auto* found = find(key, hash)) return {found, false};
+        if ((size_ + 1) * 4 > hashes_.size() * 3) grow();
+        std::size_t i = hash & mask();
+        while (hashes_[i]) i = (i + 1) & mask();
+        hashes_[i] = hash;
+        entries_[i].emplace(key, V{});
+        size_++;
+        return {&entries_[i]->second, true};
+    }
+
+    bool erase(lookup_t<K> key, uint64_t hash) {
+        if (hashes_.empty()) return false;
+        std::size_t i = hash & mask();
+        for (; hashes_[i]; i = (i + 1) & mask())
+            if (hashes_[i] == hash && entries_[i]->first == key) break;
+        if (!hashes_[i]) return false;
+
+        for (std::size_t j = i;;) {
+            j = (j + 1) & mask();
+            if (!hashes_[j]) break;
+            // Move j back into the hole unless that would put it before its home slot.
+            const std::size_t home = hashes_[j] & mask();
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                hashes_[i] = hashes_[j];
+                entries_[i] = std::move(entries_[j]);
+                i = j;
+            }
+        }
+        hashes_[i] = 0;
+        entries_[i].reset();
+        size_--;
+        return true;
+    }
+
+    std::size_t size() const { return size_; }
+
+    template<typename F>
+    void for_each(F&& f) const {
+        for (const auto& entry : entries_)
+            if (entry) f(entry->first, entry->second);
+    }
+
+    // Sizes the table so `n` entries fit without a rehash.
+    void reserve(std::size_t n) {
+        std::size_t capacity = hashes_.empty() ? 8 : hashes_.size();
+        while (n * 4 > capacity * 3) capacity *= 2;
+        if (capacity > hashes_.size()) rehash(capacity);
+    }
+
+private:
+    std::size_t mask() const { return hashes_.size() - 1; }
+
+    void grow() { rehash(hashes_.empty() ? 8 : hashes_.size() * 2); }
+
+    void rehash(std::size_t capacity) {
+        std::vector<uint64_t> hashes(capacity, 0);
+        std::vector<std::optional<std::pair<K, V>>> entries(hashes.size());
+        const std::size_t new_mask = hashes.size() - 1;
+        for (std::size_t s = 0; s < hashes_.size(); ++s) {
+            if (!hashes_[s]) continue;
+            std::size_t i = hashes_[s] & new_mask;
+            while (hashes[i]) i = (i + 1) & new_mask;
+            hashes[i] = hashes_[s];
+            entries[i] = std::move(entries_[s]);
+        }
+        hashes_ = std::move(hashes);
+        entries_ = std::move(entries);
+    }
+
+    std::vector<uint64_t> hashes_;
+    std::vector<std::optional<std::pair<K, V>>> entries_;
+    std::size_t size_ = 0;
+};
+
+}  // namespace detail
+
+template<typename K, typename V>
 class ConcurrentMap {
-    static_assert(Shards > 0, "Need at least one shard");
 public:
-    std::optional<V> get(const K& key) const {
-        auto& s = shard_for(key);
+    static constexpr std::size_t kDefaultShards = 16;
+
+    // The shard count is rounded up to a power of two.
+    explicit ConcurrentMap(std::size_t shards = kDefaultShards) {
+        while (shard_count_ < shards) shard_count_ <<= 1;
+        shards_ = std::make_unique<Shard[]>(shard_count_);
+    }
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    std::size_t shard_count() const { return shard_count_; }
+
+    std::optional<V> get(detail::lookup_t<K> key) const {
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
         std::shared_lock lk(s.mu);
-        auto it = s.data.find(key);
-        return it != s.data.end() ? std::optional<V>(it->second) : std::nullopt;
+        auto* found = s.data.find(key, hash);
+        return found ? std::optional<V>(*found) : std::nullopt;
+    }
+
+    // Calls f(const V&) under the shard's shared lock instead of copying the value out.
+    template<typename F>
+    bool visit(detail::lookup_t<K> key, F&& f) const {
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
+        std::shared_lock lk(s.mu);
+        auto* found = s.data.find(key, hash);
+        if (found) f(*found);
+        return found != nullptr;
+    }
+
+    // Calls f(key, value) for every entry, one shard at a time under its
+    // shared lock. Entries put or erased meanwhile may or may not be seen.
+    template<typename F>
+    void for_each(F&& f) const {
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock lk(shards_[i].mu);
+            shards_[i].data.for_each(f);
+        }
     }
 
     bool try_insert(const K& key, const V& value) {
-        auto& s = shard_for(key);
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
         std::unique_lock lk(s.mu);
-        return s.data.emplace(key, value).second;
+        auto [slot, inserted] = s.data.try_emplace(key, hash);
+        if (inserted) *slot = value;
+        return inserted;
     }
 
     void put(const K& key, const V& value) {
-        auto& s = shard_for(key);
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
         std::unique_lock lk(s.mu);
-        s.data.insert_or_assign(key, value);
+        *s.data.try_emplace(key, hash).first = value;
     }
 
-    bool erase(const K& key) {
-        auto& s = shard_for(key);
+    bool erase(detail::lookup_t<K> key) {
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
         std::unique_lock lk(s.mu);
-        return s.data.erase(key) > 0;
+        return s.data.erase(key, hash);
     }
 
     template<typename Factory>
     V get_or_create(const K& key, Factory&& factory) {
-        auto& s = shard_for(key);
+        const auto hash = hash_of(key);
+        auto& s = shard_for(hash);
         {
             std::shared_lock lk(s.mu);
-            auto it = s.data.find(key);
-            if (it != s.data.end()) return it->second;
+            if (auto* found = s.data.find(key, hash)) return *found;
         }
         {
             std::unique_lock lk(s.mu);
-            auto [it, inserted] = s.data.try_emplace(key);
-            if (inserted) it->second = factory();
-            return it->second;
+            auto [slot, inserted] = s.data.try_emplace(key, hash);
+            if (inserted) *slot = factory();
+            return *slot;
         }
     }
 
 private:
-    struct Shard {
+    // Own cache line per shard so neighbouring locks do not contend falsely.
+    struct alignas(64) Shard {
         mutable std::shared_mutex mu;
-        std::unordered_map<K, V> data;
+        detail::FlatTable<K, V> data;
     };
 
-    mutable std::array<Shard, Shards> shards_{};
+    static uint64_t hash_of(detail::lookup_t<K> key) { return detail::hash_key<K>(key); }
 
-    Shard& shard_for(const K& key) const {
-        return shards_[std::hash<K>{}(key) % Shards];
+    // High bits pick the shard, low bits the slot within it.
+    Shard& shard_for(uint64_t hash) const {
+        return shards_[(hash >> 40) & (shard_count_ - 1)];
     }
+
+    std::size_t shard_count_ = 1;
+    std::unique_ptr<Shard[]> shards_;
 };
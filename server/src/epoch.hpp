@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Epoch-based reclamation shared by ReadMostlyMap and PriceEngine. A reader
+// announces the global epoch in its own cache line for the length of one read
+// section; a writer frees unlinked memory only once no reader can still be in
+// the epoch it was unlinked in.
+namespace epoch {
+
+struct alignas(64) Reader {
+    std::atomic<uint64_t> epoch{0};  // 0 outside a read section
+    std::atomic<bool> in_use{false};
+    Reader* next = nullptr;
+};
+
+inline std::atomic<uint64_t> global_epoch{1};
+inline std::atomic<Reader*> readers{nullptr};
+
+// Records are recycled across threads and never freed.
+inline Reader* acquire_reader() {
+    for (auto* r = readers.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return r;
+    }
+    auto* r = new Reader;
+    r->in_use.store(true, std::memory_order_relaxed);
+    r->next = readers.load(std::memory_order_relaxed);
+    while (!readers.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+    return r;
+}
+
+struct ThreadReader {
+    Reader* reader = acquire_reader();
+    unsigned depth = 0;
+    ~ThreadReader() { reader->in_use.store(false, std::memory_order_release); }
+};
+
+inline ThreadReader& this_thread_reader() {
+    thread_local ThreadReader self;
+    return self;
+}
+
+class Guard {
+public:
+    Guard() : self_(this_thread_reader()) {
+        if (self_.depth++ == 0) {
+            self_.reader->epoch.store(global_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+            // The announcement must be visible before any pointer is loaded.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+    ~Guard() {
+        if (--self_.depth == 0) self_.reader->epoch.store(0, std::memory_order_release);
+    }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+private:
+    ThreadReader& self_;
+};
+
+// Moves the epoch on and returns the oldest epoch a reader may still be in.
+// Anything retired in an earlier epoch is unreachable.
+inline uint64_t advance() {
+    const uint64_t current = global_epoch.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = current + 1;
+    for (auto* r = readers.load(std::memory_order_acquire); r; r = r->next) {
+        const uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+        if (e && e < oldest) oldest = e;
+    }
+    return oldest;
+}
+
+}  // namespace epoch
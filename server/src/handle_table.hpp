@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+// Dense index → T* table. Chunks are allocated on first use and never move,
+// so a lookup is two indexed loads: no lock, no hashing, no refcount.
+template<typename T, size_t ChunkBits = 12, size_t MaxChunks = 4096>
+class HandleTable {
+public:
+    static constexpr size_t kChunkSize = size_t{1} << ChunkBits;
+    static constexpr size_t kCapacity = kChunkSize * MaxChunks;
+
+    HandleTable() = default;
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    ~HandleTable() {
+        for (auto& chunk : chunks_)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    T* get(uint64_t index) const {
+        if (index >= kCapacity) return nullptr;
+        auto* chunk = chunks_[index >> ChunkBits].load(std::memory_order_acquire);
+        return chunk ? chunk[index & (kChunkSize - 1)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    void put(uint64_t index, T* value) {
+        if (index >= kCapacity) throw std::length_error("HandleTable capacity exceeded");
+        chunk_for(index)[index & (kChunkSize - 1)].store(value, std::memory_order_release);
+    }
+
+private:
+    using Slot = std::atomic<T*>;
+
+    Slot* chunk_for(uint64_t index) {
+        auto& head = chunks_[index >> ChunkBits];
+        auto* chunk = head.load(std::memory_order_acquire);
+        if (chunk) return chunk;
+        auto* fresh = new Slot[kChunkSize]();
+        if (head.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+            return fresh;
+        delete[] fresh;
+        return chunk;
+    }
+
+    std::array<std::atomic<Slot*>, MaxChunks> chunks_{};
+};
@@ -0,0 +1,244 @@
+#include "ledger_auditor.hpp"
+#include "stock_service.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+bool differs(double actual, double expected) {
+    return std::abs(actual - expected) > 1e-9 * std::max(1.0, std::abs(expected));
+}
+
+}  // namespace
+
+std::optional<double> replay_history(const std::vector<HistoryEntry>& history, std::size_t from, double balance) {
+    for (std::size_t i = from; i < history.size(); ++i) {
+        // Same operation, same order as BankService::post, so equality is exact.
+        balance += signed_amount(history[i].type, history[i].amount);
+        if (balance != history[i].balance_after) return std::nullopt;
+    }
+    return balance;
+}
+
+LedgerAuditor::LedgerAuditor(const BankService& bank, std::chrono::milliseconds interval, std::size_t workers)
+    : bank_(bank), interval_(interval), workers_(workers) {
+    on_alert_ = [](const LedgerAlert& alert) {
+        std::cerr << "Ledger drift: ";
+        if (alert.kind == LedgerAlert::Kind::History)
+            std::cerr << "account " << alert.account_id << ' ' << to_string(alert.currency);
+        else if (alert.kind == LedgerAlert::Kind::Totals)
+            std::cerr << "user " << alert.user_id << " total " << to_string(alert.currency);
+        else
+            std::cerr << "user " << alert.user_id << " symbol " << alert.symbol
+                      << (alert.kind == LedgerAlert::Kind::StockEntries ? " entries" : " holdings");
+        std::cerr << " expected " << alert.expected << " actual " << alert.actual << std::endl;
+    };
+}
+
+LedgerAuditor::~LedgerAuditor() { stop(); }
+
+void LedgerAuditor::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&LedgerAuditor::run, this);
+}
+
+void LedgerAuditor::stop() {
+    if (!running_.exchange(false)) return;
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+void LedgerAuditor::check_stocks(const StockService& stocks) {
+    std::lock_guard lk(pass_mu_);
+    stocks_ = &stocks;
+}
+
+void LedgerAuditor::on_alert(std::function<void(const LedgerAlert&)> handler) {
+    std::lock_guard lk(pass_mu_);
+    on_alert_ = std::move(handler);
+}
+
+LedgerAuditor::Metrics LedgerAuditor::metrics() const {
+    return {passes_.load(), entries_checked_.load(), drift_alerts_.load(), owners_checked_.load(),
+            totals_checked_.load(), totals_skipped_.load(), last_pass_ms_.load()};
+}
+
+struct LedgerAuditor::Partial {
+    std::array<double, kMaxCurrencies> balances{};
+    uint64_t entries = 0;
+    uint64_t owners = 0;
+    std::vector<LedgerAlert> alerts;
+};
+
+void LedgerAuditor::run_once() {
+    constexpr std::size_t kBlock = 256;
+    std::lock_guard pass(pass_mu_);
+    const auto started = std::chrono::steady_clock::now();
+
+    const auto before = bank_.ledger_.snapshot();
+    struct Owner {
+        uint64_t user_id;
+        std::shared_ptr<UserAccounts> accounts;
+        OwnerState* state;
+    };
+    std::vector<Owner> owners;
+    bank_.users_.for_each([&](uint64_t user_id, const std::shared_ptr<UserAccounts>& ud) {
+        owners.push_back({user_id, ud, nullptr});
+    });
+    // Node-based map: the states stay put while the workers use them.
+    for (auto& owner : owners) owner.state = &owners_[owner.user_id];
+
+    std::size_t workers = workers_ ? workers_ : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<std::size_t>(1, std::min(workers, (owners.size() + kBlock - 1) / kBlock));
+    std::atomic<std::size_t> next_block{0};
+    std::vector<Partial> partial(workers);
+    auto scan = [&](Partial& out) {
+        for (;;) {
+            const std::size_t begin = next_block.fetch_add(kBlock);
+            if (begin >= owners.size()) return;
+            for (std::size_t i = begin; i < std::min(begin + kBlock, owners.size()); ++i)
+                audit_owner(owners[i].user_id, *owners[i].accounts, *owners[i].state, out);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w)
+        threads.emplace_back(scan, std::ref(partial[w]));
+    scan(partial[0]);
+    for (auto& t : threads) t.join();
+
+    std::vector<LedgerAlert> alerts;
+    std::array<double, kMaxCurrencies> balances{};
+    uint64_t entries = 0, audited = 0;
+    const std::size_t currencies = currency_count();
+    for (auto& p : partial) {
+        for (std::size_t c = 0; c < currencies; ++c) balances[c] += p.balances[c];
+        entries += p.entries;
+        audited += p.owners;
+        alerts.insert(alerts.end(), p.alerts.begin(), p.alerts.end());
+    }
+
+    // Owners were checked one at a time; together they only describe one
+    // ledger state if nothing was posted between the two snapshots.
+    const auto after = bank_.ledger_.snapshot();
+    if (before.quiescent && after.ops == before.ops) {
+        totals_checked_++;
+        for (std::size_t c = 0; c < currencies; ++c) {
+            if (differs(balances[c], before.totals[c]))
+                alerts.push_back({0, static_cast<Currency>(c), before.totals[c], balances[c],
+                                  LedgerAlert::Kind::Totals});
+        }
+    } else {
+        totals_skipped_++;
+    }
+
+    entries_checked_ += entries;
+    owners_checked_ += audited;
+    drift_alerts_ += alerts.size();
+    passes_++;
+    last_pass_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    if (on_alert_)
+        for (const auto& alert : alerts) on_alert_(alert);
+}
+
+void LedgerAuditor::audit_owner(uint64_t user_id, const UserAccounts& ud, OwnerState& state, Partial& out) const {
+    // Every posting and every trade of this owner's holds mu exclusively.
+    std::shared_lock lk(ud.mu);
+    std::array<double, kMaxCurrencies> balances{};
+    std::size_t index = 0;
+    for (auto* rec = ud.records.load(std::memory_order_acquire); rec;
+         rec = rec->next.load(std::memory_order_acquire), ++index) {
+        if (state.accounts.size() <= index) state.accounts.emplace_back();
+        auto& checkpoint = state.accounts[index];
+        const auto& account = rec->account;
+        const std::size_t entries = account.history.size();
+        auto replayed = entries >= checkpoint.entries
+            ? replay_history(account.history, checkpoint.entries, checkpoint.balance)
+            : std::nullopt;
+        // A closed account's residual was written off its balance, not its history.
+        const bool open = rec->is_open();
+        if (open && (!replayed || *replayed != account.balance))
+            out.alerts.push_back({account.id, account.currency, replayed.value_or(checkpoint.balance),
+                                  account.balance});
+        for (std::size_t i = std::min(entries, checkpoint.entries); i < entries; ++i) {
+            const auto& entry = account.history[i];
+            if (entry.type == OpType::BuyStock) ++tally(state, entry.symbol).bank_buys;
+            if (entry.type == OpType::SellStock) ++tally(state, entry.symbol).bank_sells;
+        }
+        out.entries += entries - std::min(entries, checkpoint.entries);
+        if (open) balances[static_cast<std::size_t>(account.currency)] += account.balance;
+        // Re-anchor on what is there now so one incident raises one alert.
+        checkpoint = {entries, account.balance};
+    }
+
+    const std::size_t currencies = currency_count();
+    for (std::size_t c = 0; c < currencies; ++c) {
+        out.balances[c] += balances[c];
+        if (differs(balances[c], ud.totals[c]))
+            out.alerts.push_back({0, static_cast<Currency>(c), ud.totals[c], balances[c],
+                                  LedgerAlert::Kind::Totals, user_id});
+    }
+    if (stocks_) audit_stocks(user_id, state, out);
+    out.owners++;
+}
+
+void LedgerAuditor::audit_stocks(uint64_t user_id, OwnerState& state, Partial& out) const {
+    // The caller holds the owner's lock, under which every trade of this
+    // user settles, so the portfolio and the bank entries agree right now.
+    auto up = stocks_->users_.get(user_id);
+    const UserPortfolio* portfolio = up ? up->get() : nullptr;
+    std::shared_lock<std::shared_mutex> lk;
+    if (portfolio) {
+        lk = std::shared_lock(portfolio->mu);
+        for (std::size_t row = state.trades; row < portfolio->trades.size(); ++row) {
+            const Trade trade = portfolio->trades.at(row);
+            auto& t = tally(state, trade.symbol);
+            ++(trade.is_buy ? t.trade_buys : t.trade_sells);
+            t.traded += trade.is_buy ? trade.quantity : -trade.quantity;
+        }
+        state.trades = portfolio->trades.size();
+        for (const auto& pos : portfolio->positions) tally(state, pos.symbol);
+    }
+
+    for (auto& t : state.stocks) {
+        auto alert = [&](LedgerAlert::Kind kind, int64_t expected, int64_t actual) {
+            out.alerts.push_back({0, Currency::RUB, static_cast<double>(expected), static_cast<double>(actual),
+                                  kind, user_id, t.symbol});
+        };
+        if (t.bank_buys != t.trade_buys || t.bank_sells != t.trade_sells) {
+            alert(LedgerAlert::Kind::StockEntries, t.bank_buys + t.bank_sells, t.trade_buys + t.trade_sells);
+            t.trade_buys = t.bank_buys;
+            t.trade_sells = t.bank_sells;
+        }
+        int64_t held = 0, in_lots = 0;
+        if (portfolio) {
+            for (const auto& pos : portfolio->positions)
+                if (pos.symbol == t.symbol) held += pos.quantity;
+            for (const auto& lot : portfolio->lots)
+                if (lot.symbol == t.symbol) in_lots += lot.quantity;
+        }
+        if (held != t.traded) {
+            alert(LedgerAlert::Kind::StockHoldings, t.traded, held);
+            t.traded = held;
+        }
+        if (in_lots != held) alert(LedgerAlert::Kind::StockHoldings, held, in_lots);
+    }
+}
+
+LedgerAuditor::StockTally& LedgerAuditor::tally(OwnerState& state, SymbolId symbol) {
+    for (auto& t : state.stocks)
+        if (t.symbol == symbol) return t;
+    return state.stocks.emplace_back(StockTally{symbol});
+}
+
+void LedgerAuditor::run() {
+    while (running_) {
+        {
+            std::unique_lock lock(cv_mu_);
+            cv_.wait_for(lock, interval_, [this] { return !running_.load(); });
+        }
+        if (!running_) break;
+        run_once();
+    }
+}
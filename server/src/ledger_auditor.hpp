@@ -0,0 +1,120 @@
+#pragma once
+#include "bank_service.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+class StockService;
+
+struct LedgerAlert {
+    enum class Kind : uint8_t {
+        History,        // an account's history does not replay onto its balance
+        Totals,         // a currency total disagrees with the balances it sums
+        StockEntries,   // BuyStock/SellStock entries disagree with the trade log
+        StockHoldings,  // traded quantity, position and lots disagree
+    };
+
+    uint64_t account_id = 0;  // History only
+    Currency currency = Currency::RUB;
+    double expected = 0.0;
+    double actual = 0.0;
+    Kind kind = Kind::History;
+    uint64_t user_id = 0;         // 0 for the bank-wide currency total
+    SymbolId symbol = kNoSymbol;  // the stock checks
+};
+
+// Replays history[from..] on top of `balance`. Returns the resulting balance,
+// or nullopt if any entry's balance_after disagrees with the replay.
+std::optional<double> replay_history(const std::vector<HistoryEntry>& history, std::size_t from, double balance);
+
+// Periodically checks the ledger against itself, one account owner at a
+// time under the owner's lock: every account's new history entries must
+// replay onto its balance, and the owner's balances must sum to its running
+// per-currency totals. The bank-wide totals are also checked when a pass
+// caught the bank at rest. With check_stocks(), each user's BuyStock and
+// SellStock entries must match their trade log, and the quantity traded
+// must match the position and the lots. Each pass only walks history and
+// trades added since the previous one.
+class LedgerAuditor {
+public:
+    struct Metrics {
+        uint64_t passes = 0;
+        uint64_t entries_checked = 0;
+        uint64_t drift_alerts = 0;
+        uint64_t owners_checked = 0;
+        uint64_t totals_checked = 0;  // passes that caught the ledger at rest
+        uint64_t totals_skipped = 0;  // passes where trading moved the totals mid-scan
+        double last_pass_ms = 0.0;
+    };
+
+    explicit LedgerAuditor(const BankService& bank,
+                           std::chrono::milliseconds interval = std::chrono::seconds(5),
+                           std::size_t workers = 0);
+    ~LedgerAuditor();
+
+    // Cross-checks `stocks` against the bank too; call before start().
+    void check_stocks(const StockService& stocks);
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    void on_alert(std::function<void(const LedgerAlert&)> handler);
+    void run_once();
+    Metrics metrics() const;
+
+private:
+    struct Checkpoint {
+        std::size_t entries = 0;
+        double balance = 0.0;
+    };
+
+    // Running counts for one symbol: bank entries and trades seen so far.
+    struct StockTally {
+        SymbolId symbol;
+        uint64_t bank_buys = 0;
+        uint64_t bank_sells = 0;
+        uint64_t trade_buys = 0;
+        uint64_t trade_sells = 0;
+        int64_t traded = 0;  // bought minus sold
+    };
+
+    // Where the previous pass left one owner; touched by one worker per pass.
+    struct OwnerState {
+        std::vector<Checkpoint> accounts;  // in the owner's record order
+        std::size_t trades = 0;            // trade log rows tallied
+        std::vector<StockTally> stocks;
+    };
+
+    struct Partial;
+
+    void audit_owner(uint64_t user_id, const UserAccounts& ud, OwnerState& state, Partial& out) const;
+    void audit_stocks(uint64_t user_id, OwnerState& state, Partial& out) const;
+    static StockTally& tally(OwnerState& state, SymbolId symbol);
+    void run();
+
+    const BankService& bank_;
+    const StockService* stocks_ = nullptr;
+    const std::chrono::milliseconds interval_;
+    const std::size_t workers_;
+
+    std::mutex pass_mu_;  // serializes passes; guards owners_ and on_alert_
+    std::unordered_map<uint64_t, OwnerState> owners_;  // by user id
+    std::function<void(const LedgerAlert&)> on_alert_;
+
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<uint64_t> entries_checked_{0};
+    std::atomic<uint64_t> drift_alerts_{0};
+    std::atomic<uint64_t> owners_checked_{0};
+    std::atomic<uint64_t> totals_checked_{0};
+    std::atomic<uint64_t> totals_skipped_{0};
+    std::atomic<double> last_pass_ms_{0.0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex cv_mu_;
+    std::condition_variable cv_;
+};
@@ -0,0 +1,65 @@
+#include "market_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+
+std::unique_ptr<TickWriter> create_tick_writer(const PriceEngine& prices, const std::string& path,
+                                               std::string& error) {
+    std::vector<std::string> tickers, currencies;
+    for (SymbolId id = 0; id < prices.symbols().size(); ++id) tickers.push_back(prices.symbols().name(id));
+    const auto columns = prices.read([](const MarketSnapshot& s) { return s.usd_rates.size(); });
+    for (std::size_t c = 0; c < columns; ++c) currencies.push_back(to_string(static_cast<Currency>(c)));
+    return TickWriter::create(path, std::move(tickers), std::move(currencies), error);
+}
+
+MarketRecorder::MarketRecorder(PriceEngine& prices, std::unique_ptr<TickWriter> writer, std::size_t capacity)
+    : writer_(std::move(writer)), quotes_(writer_->tickers()) {
+    std::size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+    slots_.resize(slots);
+    for (auto& slot : slots_) slot.values.resize(writer_->tickers() + writer_->currencies());
+    prices.on_tick([this](const MarketSnapshot& s) { push(s); });
+}
+
+MarketRecorder::~MarketRecorder() { stop(); }
+
+void MarketRecorder::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&MarketRecorder::run, this);
+}
+
+void MarketRecorder::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+}
+
+void MarketRecorder::push(const MarketSnapshot& s) {
+    if (!running_.load(std::memory_order_relaxed)) return;
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == slots_.size()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto& slot = slots_[head & (slots_.size() - 1)];
+    slot.tick = s.tick;
+    slot.time_us = std::chrono::duration_cast<std::chrono::microseconds>(s.time.time_since_epoch()).count();
+    const std::size_t rates = std::min(s.usd_rates.size(), slot.values.size() - quotes_);
+    std::copy_n(s.quotes.begin(), std::min(s.quotes.size(), quotes_), slot.values.begin());
+    std::copy_n(s.usd_rates.begin(), rates, slot.values.begin() + static_cast<std::ptrdiff_t>(quotes_));
+    head_.store(head + 1, std::memory_order_release);
+}
+
+void MarketRecorder::run() {
+    for (;;) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            if (!running_.load()) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        const auto& slot = slots_[tail & (slots_.size() - 1)];
+        writer_->append(slot.tick, slot.time_us, slot.values.data(), slot.values.data() + quotes_);
+        tail_.store(tail + 1, std::memory_order_release);
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    }
+    writer_->flush();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "price_engine.hpp"
+#include "tick_file.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A TickWriter with one column per instrument and per currency of `prices`.
+std::unique_ptr<TickWriter> create_tick_writer(const PriceEngine& prices, const std::string& path,
+                                               std::string& error);
+
+// Appends every tick the engine publishes to a tick file on a background
+// thread. The tick loop only copies the snapshot into a preallocated ring
+// slot; when the writer falls behind, ticks are dropped and counted rather
+// than stalling the engine. Blocks reach the file as they fill and on stop().
+//
+// Must be constructed before prices.start() and outlive the engine's ticking.
+class MarketRecorder {
+public:
+    static constexpr std::size_t kDefaultCapacity = 1024;
+
+    MarketRecorder(PriceEngine& prices, std::unique_ptr<TickWriter> writer,
+                   std::size_t capacity = kDefaultCapacity);
+    ~MarketRecorder();
+
+    void start();
+    // Writes out everything handed off so far and flushes the file.
+    void stop();
+
+    uint64_t recorded() const { return recorded_.load(); }
+    uint64_t dropped() const { return dropped_.load(); }
+
+private:
+    struct Slot {
+        uint64_t tick = 0;
+        int64_t time_us = 0;
+        std::vector<double> values;  // quotes, then USD rates
+    };
+
+    void push(const MarketSnapshot& snapshot);  // engine thread
+    void run();
+
+    std::unique_ptr<TickWriter> writer_;
+    const std::size_t quotes_;
+    std::vector<Slot> slots_;  // power-of-two ring
+    alignas(64) std::atomic<uint64_t> head_{0};  // next slot the engine fills
+    alignas(64) std::atomic<uint64_t> tail_{0};  // next slot the writer drains
+    alignas(64) std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
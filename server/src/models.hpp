@@ -1,27 +1,83 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <string>
+#include <string_view>
 #include <cstdint>
+#include <cstddef>
 #include <chrono>
+#include <mutex>
 #include <optional>
 #include <vector>
 
-enum class Currency { RUB, USD, EUR };
+// Dense currency id. The three built-ins always exist; a loaded Universe
+// registers any others at startup (see CurrencyRegistry).
+enum class Currency : uint16_t { RUB, USD, EUR };
 enum class OpType { Deposit, Withdraw, TransferIn, TransferOut, BuyStock, SellStock };
 
-inline std::string to_string(Currency c) {
-    switch (c) {
-        case Currency::RUB: return "RUB";
-        case Currency::USD: return "USD";
-        case Currency::EUR: return "EUR";
+// Upper bound on registered currencies; sizes the per-currency ledger arrays.
+constexpr std::size_t kMaxCurrencies = 64;
+
+// Dense id of an interned ticker; see SymbolTable.
+using SymbolId = uint32_t;
+constexpr SymbolId kNoSymbol = UINT32_MAX;
+
+// Process-wide code ⇄ Currency table. Slots are written once, before the
+// count that publishes them, so lookups take no lock.
+class CurrencyRegistry {
+public:
+    static CurrencyRegistry& instance() {
+        static CurrencyRegistry registry;
+        return registry;
     }
-    return "???";
+
+    // Idempotent; nullopt once kMaxCurrencies codes are taken.
+    std::optional<Currency> add(std::string_view code) {
+        std::lock_guard lk(mu_);
+        if (auto found = find(code)) return found;
+        const std::size_t n = count_.load(std::memory_order_relaxed);
+        if (n == kMaxCurrencies) return std::nullopt;
+        codes_[n] = std::string(code);
+        count_.store(n + 1, std::memory_order_release);
+        return static_cast<Currency>(n);
+    }
+
+    std::optional<Currency> find(std::string_view code) const {
+        const std::size_t n = size();
+        for (std::size_t i = 0; i < n; ++i)
+            if (codes_[i] == code) return static_cast<Currency>(i);
+        return std::nullopt;
+    }
+
+    const std::string& code(Currency c) const {
+        static const std::string unknown = "???";
+        const auto i = static_cast<std::size_t>(c);
+        return i < size() ? codes_[i] : unknown;
+    }
+
+    std::size_t size() const { return count_.load(std::memory_order_acquire); }
+
+private:
+    CurrencyRegistry() {
+        codes_[0] = "RUB";
+        codes_[1] = "USD";
+        codes_[2] = "EUR";
+        count_.store(3, std::memory_order_release);
+    }
+
+    std::mutex mu_;
+    std::array<std::string, kMaxCurrencies> codes_;
+    std::atomic<std::size_t> count_{0};
+};
+
+inline std::size_t currency_count() { return CurrencyRegistry::instance().size(); }
+
+inline std::string to_string(Currency c) {
+    return CurrencyRegistry::instance().code(c);
 }
 
-inline std::optional<Currency> currency_from_string(const std::string& s) {
-    if (s == "RUB") return Currency::RUB;
-    if (s == "USD") return Currency::USD;
-    if (s == "EUR") return Currency::EUR;
-    return std::nullopt;
+inline std::optional<Currency> currency_from_string(std::string_view s) {
+    return CurrencyRegistry::instance().find(s);
 }
 
 inline std::string to_string(OpType op) {
@@ -46,6 +102,19 @@ inline std::optional<OpType> optype_from_string(const std::string& s) {
     return std::nullopt;
 }
 
+// Effect of an operation on the account balance.
+inline double signed_amount(OpType op, double amount) {
+    switch (op) {
+        case OpType::Deposit:
+        case OpType::TransferIn:
+        case OpType::SellStock:   return amount;
+        case OpType::Withdraw:
+        case OpType::TransferOut:
+        case OpType::BuyStock:    return -amount;
+    }
+    return 0.0;
+}
+
 struct User {
     uint64_t id = 0;
     std::string username;
@@ -59,7 +128,8 @@ struct HistoryEntry {
     OpType type;
     double amount;
     double balance_after;
-    std::string counterparty;
+    std::string counterparty;          // peer account for transfers
+    SymbolId symbol = kNoSymbol;       // instrument for stock operations
 };
 
 struct Account {
@@ -70,16 +140,45 @@ struct Account {
     std::vector<HistoryEntry> history;
 };
 
+struct AccountSummary {
+    uint64_t id = 0;
+    uint64_t user_id = 0;
+    Currency currency = Currency::RUB;
+    double balance = 0.0;
+    uint64_t version = 0;
+};
+
 struct Position {
-    std::string ticker;
+    SymbolId symbol = kNoSymbol;
     int quantity = 0;
     double avg_price = 0.0;
+    // Valuation at the latest quote seen, kept current by StockService.
+    double mark = 0.0;
+    uint64_t mark_tick = 0;
+    double market_value = 0.0;
+    double unrealized_pnl = 0.0;
+};
+
+struct PortfolioTotals {
+    double market_value = 0.0;
+    double cost_basis = 0.0;
+    double unrealized_pnl = 0.0;
+};
+
+// A consistent copy of one user's positions and totals. `version` counts
+// every change to the portfolio; `tick` is the newest quote tick in it.
+struct PortfolioSnapshot {
+    std::vector<Position> positions;
+    PortfolioTotals totals;
+    uint64_t version = 0;
+    uint64_t tick = 0;
 };
 
 struct Trade {
     TimePoint timestamp;
-    std::string ticker;
+    SymbolId symbol;
     bool is_buy;
     int quantity;
     double price;
+    uint64_t tick = 0;  // PriceEngine tick the price was taken from
 };
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue for many producers and one consumer. Each cell
+// carries a sequence number: producers claim a cell by CAS on the tail and
+// publish it by bumping the cell's sequence, so a slow producer never
+// blocks the others, and the consumer reads cells in claim order.
+template<typename T>
+class MpscRing {
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit MpscRing(std::size_t capacity) {
+        std::size_t n = 2;
+        while (n < capacity) n <<= 1;
+        mask_ = n - 1;
+        cells_ = std::make_unique<Cell[]>(n);
+        for (std::size_t i = 0; i < n; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Any thread. False when the ring is full.
+    bool try_push(T&& value) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(seq - pos);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. False when the next cell is not published yet.
+    bool try_pop(T& out) {
+        Cell& cell = cells_[head_ & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+        out = std::move(cell.value);
+        cell.seq.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    // Consumer thread only; a push racing with it may or may not be seen.
+    bool empty() const {
+        return cells_[head_ & mask_].seq.load(std::memory_order_acquire) != head_ + 1;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::size_t head_ = 0;
+};
@@ -0,0 +1,242 @@
+#include "order_book.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr std::size_t kCompactAfter = 64;
+
+OrderHandle make_handle(uint32_t slot, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | slot;
+}
+
+}  // namespace
+
+OrderBook::Order* OrderBook::resolve(OrderHandle handle) {
+    const auto slot = static_cast<uint32_t>(handle);
+    const auto generation = static_cast<uint32_t>(handle >> 32);
+    if (slot >= orders_.size()) return nullptr;
+    Order& o = orders_[slot];
+    return o.live && o.generation == generation ? &o : nullptr;
+}
+
+std::optional<int64_t> OrderBook::best(const std::vector<Rung>& ladder) const {
+    // The back rung is normally live; emptied rungs behind it are skipped.
+    for (auto it = ladder.rbegin(); it != ladder.rend(); ++it) {
+        if (levels_[it->level].orders) return it->price;
+    }
+    return std::nullopt;
+}
+
+void OrderBook::reserve(std::size_t orders) {
+    orders_.reserve(orders);
+    free_orders_.reserve(orders);
+}
+
+uint32_t OrderBook::level_for(Side side, int64_t price) {
+    auto& rungs = ladder(side);
+    // Bids ascend and asks descend, so "worse than price" sorts first either way.
+    auto it = side == Side::Buy
+        ? std::lower_bound(rungs.begin(), rungs.end(), price,
+                           [](const Rung& r, int64_t p) { return r.price < p; })
+        : std::lower_bound(rungs.begin(), rungs.end(), price,
+                           [](const Rung& r, int64_t p) { return r.price > p; });
+    if (it != rungs.end() && it->price == price) {
+        if (levels_[it->level].orders == 0) --empty_levels_;
+        return it->level;
+    }
+    uint32_t level;
+    if (!free_levels_.empty()) {
+        level = free_levels_.back();
+        free_levels_.pop_back();
+    } else {
+        level = static_cast<uint32_t>(levels_.size());
+        levels_.emplace_back();
+    }
+    levels_[level] = {price, 0, kNil, kNil, 0};
+    rungs.insert(it, {price, level});
+    return level;
+}
+
+OrderHandle OrderBook::add(Side side, int64_t price, int64_t quantity, uint64_t tag,
+                           std::vector<BookFill>& fills) {
+    if (quantity <= 0) return kNoOrder;
+    auto& opposite = ladder(side == Side::Buy ? Side::Sell : Side::Buy);
+    while (quantity > 0 && !opposite.empty()) {
+        pop_empty(opposite);
+        if (opposite.empty()) break;
+        const Rung rung = opposite.back();
+        if (side == Side::Buy ? rung.price > price : rung.price < price) break;
+        fill_level(rung.level, quantity, tag, rung.price, fills);
+        if (levels_[rung.level].orders == 0) {
+            opposite.pop_back();
+            free_levels_.push_back(rung.level);
+        }
+    }
+    return queue(side, price, quantity, tag);
+}
+
+OrderHandle OrderBook::queue(Side side, int64_t price, int64_t quantity, uint64_t tag) {
+    if (quantity <= 0) return kNoOrder;
+    const uint32_t slot = take_slot();
+    if (slot == kNil) return kNoOrder;
+    link(slot, side, price, quantity, tag, false);
+    return make_handle(slot, orders_[slot].generation);
+}
+
+OrderHandle OrderBook::restore(OrderHandle handle, Side side, int64_t price, int64_t quantity, uint64_t tag) {
+    if (quantity <= 0) return kNoOrder;
+    if (Order* o = resolve(handle)) {
+        o->remaining += quantity;
+        levels_[o->level].quantity += quantity;
+        return handle;
+    }
+    const uint32_t slot = take_slot();
+    if (slot == kNil) return kNoOrder;
+    link(slot, side, price, quantity, tag, true);
+    return make_handle(slot, orders_[slot].generation);
+}
+
+uint32_t OrderBook::take_slot() {
+    if (!free_orders_.empty()) {
+        const uint32_t slot = free_orders_.back();
+        free_orders_.pop_back();
+        return slot;
+    }
+    if (orders_.size() == kNil) return kNil;
+    orders_.push_back({});
+    orders_.back().generation = 1;
+    return static_cast<uint32_t>(orders_.size() - 1);
+}
+
+void OrderBook::link(uint32_t slot, Side side, int64_t price, int64_t quantity, uint64_t tag, bool front) {
+    const uint32_t level = level_for(side, price);
+    Level& lv = levels_[level];
+    Order& o = orders_[slot];
+    o.tag = tag;
+    o.price = price;
+    o.remaining = quantity;
+    o.level = level;
+    o.side = side;
+    o.live = true;
+    if (front) {
+        o.prev = kNil;
+        o.next = lv.head;
+        if (lv.head != kNil) orders_[lv.head].prev = slot;
+        else lv.tail = slot;
+        lv.head = slot;
+    } else {
+        o.prev = lv.tail;
+        o.next = kNil;
+        if (lv.tail != kNil) orders_[lv.tail].next = slot;
+        else lv.head = slot;
+        lv.tail = slot;
+    }
+    lv.quantity += quantity;
+    ++lv.orders;
+    ++live_;
+}
+
+void OrderBook::fill_level(uint32_t level, int64_t& quantity, uint64_t taker_tag, int64_t price,
+                           std::vector<BookFill>& fills) {
+    Level& lv = levels_[level];
+    while (quantity > 0 && lv.head != kNil) {
+        const uint32_t slot = lv.head;
+        Order& o = orders_[slot];
+        const int64_t q = std::min(quantity, o.remaining);
+        o.remaining -= q;
+        lv.quantity -= q;
+        quantity -= q;
+        fills.push_back({o.tag, taker_tag, o.side, price, q, o.remaining});
+        if (o.remaining == 0) unlink(slot);
+    }
+}
+
+void OrderBook::unlink(uint32_t slot) {
+    Order& o = orders_[slot];
+    Level& lv = levels_[o.level];
+    if (o.prev != kNil) orders_[o.prev].next = o.next;
+    else lv.head = o.next;
+    if (o.next != kNil) orders_[o.next].prev = o.prev;
+    else lv.tail = o.prev;
+    lv.quantity -= o.remaining;
+    --lv.orders;
+    o.live = false;
+    ++o.generation;
+    free_orders_.push_back(slot);
+    --live_;
+}
+
+bool OrderBook::cancel(OrderHandle handle) {
+    Order* o = resolve(handle);
+    if (!o) return false;
+    const Side side = o->side;
+    const uint32_t level = o->level;
+    unlink(static_cast<uint32_t>(handle));
+    if (levels_[level].orders == 0) level_emptied(side, level);
+    return true;
+}
+
+bool OrderBook::reduce(OrderHandle handle, int64_t quantity) {
+    Order* o = resolve(handle);
+    if (!o || quantity >= o->remaining) return false;
+    if (quantity <= 0) return cancel(handle);
+    levels_[o->level].quantity -= o->remaining - quantity;
+    o->remaining = quantity;
+    return true;
+}
+
+void OrderBook::sweep(int64_t price, std::vector<BookFill>& fills) {
+    for (Side side : {Side::Buy, Side::Sell}) {
+        auto& rungs = ladder(side);
+        for (;;) {
+            pop_empty(rungs);
+            if (rungs.empty()) break;
+            const Rung rung = rungs.back();
+            if (side == Side::Buy ? rung.price < price : rung.price > price) break;
+            int64_t unlimited = std::numeric_limits<int64_t>::max();
+            fill_level(rung.level, unlimited, 0, price, fills);
+            rungs.pop_back();
+            free_levels_.push_back(rung.level);
+        }
+    }
+}
+
+void OrderBook::level_emptied(Side side, uint32_t level) {
+    auto& rungs = ladder(side);
+    if (rungs.back().level == level) {
+        rungs.pop_back();
+        free_levels_.push_back(level);
+        pop_empty(rungs);
+        return;
+    }
+    // Deep levels stay as tombstones so cancel never shifts the ladder; they
+    // are reused by the next order at that price or swept out in bulk.
+    if (++empty_levels_ >= kCompactAfter && empty_levels_ * 2 >= bids_.size() + asks_.size()) compact();
+}
+
+void OrderBook::pop_empty(std::vector<Rung>& rungs) {
+    while (!rungs.empty() && levels_[rungs.back().level].orders == 0) {
+        free_levels_.push_back(rungs.back().level);
+        rungs.pop_back();
+        --empty_levels_;
+    }
+}
+
+void OrderBook::compact() {
+    for (auto* rungs : {&bids_, &asks_}) {
+        auto keep = std::remove_if(rungs->begin(), rungs->end(), [&](const Rung& r) {
+            if (levels_[r.level].orders) return false;
+            free_levels_.push_back(r.level);
+            return true;
+        });
+        rungs->erase(keep, rungs->end());
+    }
+    empty_levels_ = 0;
+}
+
+std::optional<OrderBook::OrderView> OrderBook::find(OrderHandle handle) const {
+    const Order* o = resolve(handle);
+    if (!o) return std::nullopt;
+    return OrderView{o->side, o->price, o->remaining, o->tag};
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Side : uint8_t { Buy, Sell };
+
+inline std::string to_string(Side side) { return side == Side::Buy ? "buy" : "sell"; }
+
+inline std::optional<Side> side_from_string(std::string_view s) {
+    if (s == "buy") return Side::Buy;
+    if (s == "sell") return Side::Sell;
+    return std::nullopt;
+}
+
+// Books keep integer prices in ticks of kPriceTick USD.
+constexpr double kPriceTick = 0.01;
+
+inline std::optional<int64_t> to_ticks(double price) {
+    if (!std::isfinite(price) || price <= 0) return std::nullopt;
+    const auto ticks = std::llround(price / kPriceTick);
+    return ticks > 0 ? std::optional<int64_t>(ticks) : std::nullopt;
+}
+
+inline double from_ticks(int64_t ticks) { return static_cast<double>(ticks) * kPriceTick; }
+
+// Slot index in the low 32 bits, slot generation in the high 32, so a handle
+// to a cancelled or filled order never resolves to the slot's next tenant.
+using OrderHandle = uint64_t;
+constexpr OrderHandle kNoOrder = 0;
+
+struct BookFill {
+    uint64_t maker_tag = 0;
+    uint64_t taker_tag = 0;  // 0 when the simulated market took the other side
+    Side maker_side = Side::Buy;
+    int64_t price = 0;       // in ticks
+    int64_t quantity = 0;
+    int64_t maker_left = 0;  // resting after this fill; 0 = the maker is done
+};
+
+// One instrument's limit orders with price-time priority. Orders live in a
+// slab and queue at their level through intrusive index links, so cancel is
+// O(1) from the handle. Each side is a contiguous ladder of (price, level)
+// rungs with the best price at the back, where nearly all inserts and
+// removals happen. Prices are integers in the caller's tick size.
+//
+// Not thread-safe; OrderService serializes access per book.
+class OrderBook {
+public:
+    struct OrderView {
+        Side side;
+        int64_t price;
+        int64_t remaining;
+        uint64_t tag;
+    };
+
+    // Matches against the opposite side first (at the resting price), then
+    // rests what is left. Returns the resting handle, or kNoOrder if the
+    // order filled completely. `tag` is reported back in fills.
+    OrderHandle add(Side side, int64_t price, int64_t quantity, uint64_t tag, std::vector<BookFill>& fills);
+    // Rests without matching, for books whose two sides never trade with
+    // each other and only ever fill through sweep().
+    OrderHandle queue(Side side, int64_t price, int64_t quantity, uint64_t tag);
+    // Undoes a fill whose settlement failed: the quantity goes back onto the
+    // order if it still rests, otherwise a new order with `tag` is queued at
+    // the front of its level. Restore a taker's fills in reverse so the
+    // makers regain their original order. Returns the resting handle.
+    OrderHandle restore(OrderHandle handle, Side side, int64_t price, int64_t quantity, uint64_t tag);
+    bool cancel(OrderHandle handle);
+    // Lowers the remaining quantity in place, keeping queue position.
+    bool reduce(OrderHandle handle, int64_t quantity);
+    // The simulated market trades at `price` with unlimited depth: every
+    // resting order that crosses it fills there, best price first, FIFO
+    // within a level.
+    void sweep(int64_t price, std::vector<BookFill>& fills);
+
+    std::optional<OrderView> find(OrderHandle handle) const;
+    std::optional<int64_t> best_bid() const { return best(bids_); }
+    std::optional<int64_t> best_ask() const { return best(asks_); }
+    std::size_t size() const { return live_; }
+
+    void reserve(std::size_t orders);
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Order {
+        uint64_t tag;
+        int64_t price;
+        int64_t remaining;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t level;
+        uint32_t generation;
+        Side side;
+        bool live;
+    };
+
+    struct Level {
+        int64_t price;
+        int64_t quantity;
+        uint32_t head;
+        uint32_t tail;
+        uint32_t orders;
+    };
+
+    struct Rung {
+        int64_t price;
+        uint32_t level;
+    };
+
+    std::vector<Rung>& ladder(Side side) { return side == Side::Buy ? bids_ : asks_; }
+    std::optional<int64_t> best(const std::vector<Rung>& ladder) const;
+    Order* resolve(OrderHandle handle);
+    const Order* resolve(OrderHandle handle) const { return const_cast<OrderBook*>(this)->resolve(handle); }
+
+    uint32_t level_for(Side side, int64_t price);
+    uint32_t take_slot();  // kNil once every slot index is in use
+    void link(uint32_t slot, Side side, int64_t price, int64_t quantity, uint64_t tag, bool front);
+    void fill_level(uint32_t level, int64_t& quantity, uint64_t taker_tag, int64_t price,
+                    std::vector<BookFill>& fills);
+    void unlink(uint32_t slot);
+    void level_emptied(Side side, uint32_t level);
+    void pop_empty(std::vector<Rung>& ladder);
+    void compact();
+
+    std::vector<Order> orders_;
+    std::vector<uint32_t> free_orders_;
+    std::vector<Level> levels_;
+    std::vector<uint32_t> free_levels_;
+    std::vector<Rung> bids_;  // ascending: best bid at the back
+    std::vector<Rung> asks_;  // descending: best ask at the back
+    std::size_t live_ = 0;
+    std::size_t empty_levels_ = 0;  // emptied rungs not yet at the back
+};
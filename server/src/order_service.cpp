@@ -0,0 +1,254 @@
+#include "order_service.hpp"
+#include <algorithm>
+
+void OrderService::Book::publish_best() {
+    best_bid.store(book.best_bid().value_or(INT64_MIN), std::memory_order_relaxed);
+    best_ask.store(book.best_ask().value_or(INT64_MAX), std::memory_order_relaxed);
+}
+
+OrderService::OrderService(IBankService& bank, StockService& stock, PriceEngine& prices)
+    : bank_(bank),
+      stock_(stock),
+      symbols_(prices.symbols().size()),
+      books_(new Book[prices.symbols().size()]) {
+    prices.on_tick([this](const MarketSnapshot& snapshot) { on_tick(snapshot); });
+}
+
+std::optional<PlaceResult> OrderService::place(uint64_t user_id, SymbolId symbol, Side side,
+                                               double price, int quantity, uint64_t account_id) {
+    const auto ticks = to_ticks(price);
+    if (symbol >= symbols_ || !ticks || quantity <= 0) return std::nullopt;
+    auto acc = bank_.get_account_summary(account_id);
+    if (!acc || acc->user_id != user_id) return std::nullopt;
+
+    const Taker taker{next_id_.fetch_add(1, std::memory_order_relaxed), user_id, account_id,
+                      symbol, side, *ticks, quantity};
+    std::vector<BookFill> fills;
+    std::vector<std::optional<OrderInfo>> makers;
+    auto& b = books_[symbol];
+    {
+        std::lock_guard lk(b.mu);
+        const auto handle = b.book.add(side, *ticks, quantity, taker.order_id, fills);
+        if (handle != kNoOrder) orders_.put(taker.order_id, {user_id, account_id, symbol, side, handle});
+        take_makers(fills, makers);
+        b.publish_best();
+    }
+    const int filled = settle_taker(taker, fills, makers);
+    const auto left = find(user_id, taker.order_id);
+    return PlaceResult{taker.order_id, filled, left ? left->remaining : 0};
+}
+
+bool OrderService::cancel(uint64_t user_id, uint64_t order_id) {
+    auto info = orders_.get(order_id);
+    if (!info || info->user_id != user_id) return false;
+    auto& b = books_[info->symbol];
+    std::lock_guard lk(b.mu);
+    // Re-read under the lock: an amend may have re-queued the order.
+    info = orders_.get(order_id);
+    if (!info || !b.book.cancel(info->handle)) return false;
+    orders_.erase(order_id);
+    b.publish_best();
+    return true;
+}
+
+std::optional<PlaceResult> OrderService::amend(uint64_t user_id, uint64_t order_id, double price, int quantity) {
+    const auto ticks = to_ticks(price);
+    if (!ticks || quantity <= 0) return std::nullopt;
+    auto info = orders_.get(order_id);
+    if (!info || info->user_id != user_id) return std::nullopt;
+
+    std::vector<BookFill> fills;
+    std::vector<std::optional<OrderInfo>> makers;
+    std::optional<Taker> taker;
+    auto& b = books_[info->symbol];
+    {
+        std::lock_guard lk(b.mu);
+        info = orders_.get(order_id);
+        const auto view = info ? b.book.find(info->handle) : std::nullopt;
+        if (!view) return std::nullopt;
+        if (*ticks == view->price && quantity <= view->remaining) {
+            if (quantity < view->remaining) b.book.reduce(info->handle, quantity);
+            return PlaceResult{order_id, 0, quantity};
+        }
+        taker = Taker{order_id, user_id, info->account_id, info->symbol, info->side, *ticks, quantity};
+        b.book.cancel(info->handle);
+        const auto handle = b.book.add(info->side, *ticks, quantity, order_id, fills);
+        if (handle != kNoOrder) {
+            info->handle = handle;
+            orders_.put(order_id, *info);
+        } else {
+            orders_.erase(order_id);
+        }
+        take_makers(fills, makers);
+        b.publish_best();
+    }
+    const int filled = settle_taker(*taker, fills, makers);
+    const auto left = find(user_id, order_id);
+    return PlaceResult{order_id, filled, left ? left->remaining : 0};
+}
+
+std::optional<RestingOrder> OrderService::find(uint64_t user_id, uint64_t order_id) const {
+    auto info = orders_.get(order_id);
+    if (!info || info->user_id != user_id) return std::nullopt;
+    auto& b = books_[info->symbol];
+    std::lock_guard lk(b.mu);
+    info = orders_.get(order_id);
+    const auto view = info ? b.book.find(info->handle) : std::nullopt;
+    if (!view) return std::nullopt;
+    return RestingOrder{info->symbol, view->side, from_ticks(view->price), static_cast<int>(view->remaining)};
+}
+
+void OrderService::on_tick(const MarketSnapshot& snapshot) {
+    const std::size_t n = std::min(symbols_, snapshot.quotes.size());
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        const auto ticks = to_ticks(snapshot.quotes[symbol]);
+        if (!ticks) continue;
+        auto& b = books_[symbol];
+        if (b.best_bid.load(std::memory_order_relaxed) < *ticks &&
+            b.best_ask.load(std::memory_order_relaxed) > *ticks) continue;
+        tick_fills_.clear();
+        {
+            std::lock_guard lk(b.mu);
+            b.book.sweep(*ticks, tick_fills_);
+            take_makers(tick_fills_, tick_makers_);
+            b.publish_best();
+        }
+        settle_market(symbol, tick_fills_, tick_makers_);
+    }
+}
+
+void OrderService::take_makers(const std::vector<BookFill>& fills, std::vector<std::optional<OrderInfo>>& makers) {
+    makers.clear();
+    for (const auto& fill : fills) {
+        makers.push_back(orders_.get(fill.maker_tag));
+        if (makers.back() && fill.maker_left == 0) orders_.erase(fill.maker_tag);
+    }
+}
+
+void OrderService::settle_market(SymbolId symbol, const std::vector<BookFill>& fills,
+                                 const std::vector<std::optional<OrderInfo>>& makers) {
+    for (std::size_t i = 0; i < fills.size(); ++i) {
+        const auto& fill = fills[i];
+        const auto& maker = makers[i];
+        if (!maker) continue;
+        const double price = from_ticks(fill.price);
+        const int quantity = static_cast<int>(fill.quantity);
+        if (settle_leg(maker->user_id, maker->account_id, symbol, fill.maker_side, price, quantity)) {
+            emit({OrderEvent::Kind::Fill, fill.maker_tag, maker->user_id, symbol, fill.maker_side,
+                  price, quantity, static_cast<int>(fill.maker_left)});
+        } else {
+            reject(fill.maker_tag, maker->user_id, symbol, fill.maker_side, price);
+        }
+    }
+}
+
+int OrderService::settle_taker(const Taker& taker, std::vector<BookFill> fills,
+                               std::vector<std::optional<OrderInfo>> makers) {
+    const SymbolId symbol = taker.symbol;
+    int filled = 0;
+    for (;;) {
+        int unfilled = 0;
+        for (std::size_t i = 0; i < fills.size(); ++i) {
+            const auto& fill = fills[i];
+            const auto& maker = makers[i];
+            const double price = from_ticks(fill.price);
+            const int quantity = static_cast<int>(fill.quantity);
+            if (!maker) {
+                unfilled += quantity;
+                continue;
+            }
+            const bool maker_buys = fill.maker_side == Side::Buy;
+            const auto result = maker_buys
+                ? stock_.settle_match(maker->user_id, maker->account_id, taker.user_id, taker.account_id,
+                                      symbol, quantity, price)
+                : stock_.settle_match(taker.user_id, taker.account_id, maker->user_id, maker->account_id,
+                                      symbol, quantity, price);
+            if (result.ok()) {
+                filled += quantity;
+                emit({OrderEvent::Kind::Fill, fill.maker_tag, maker->user_id, symbol, fill.maker_side,
+                      price, quantity, static_cast<int>(fill.maker_left)});
+                emit({OrderEvent::Kind::Fill, taker.order_id, taker.user_id, symbol, taker.side,
+                      price, quantity, taker.quantity - filled});
+            } else if (result.failed == (maker_buys ? SettleParty::Buyer : SettleParty::Seller)) {
+                reject(fill.maker_tag, maker->user_id, symbol, fill.maker_side, price);
+                unfilled += quantity;
+            } else {
+                // Neither side of this or any later fill moved: the makers go
+                // back where they were and the taker's remainder is cancelled.
+                restore(symbol, fills, makers, i);
+                reject(taker.order_id, taker.user_id, symbol, taker.side, from_ticks(taker.price));
+                return filled;
+            }
+        }
+        if (unfilled == 0) return filled;
+
+        // The makers that failed are out of the book; match their share again,
+        // together with whatever of the taker still rests.
+        fills.clear();
+        auto& b = books_[symbol];
+        std::lock_guard lk(b.mu);
+        int64_t quantity = unfilled;
+        auto info = orders_.get(taker.order_id);
+        if (info) {
+            if (auto view = b.book.find(info->handle)) quantity += view->remaining;
+            b.book.cancel(info->handle);
+        }
+        const auto handle = b.book.add(taker.side, taker.price, quantity, taker.order_id, fills);
+        if (handle != kNoOrder) {
+            orders_.put(taker.order_id, {taker.user_id, taker.account_id, symbol, taker.side, handle});
+        } else if (info) {
+            orders_.erase(taker.order_id);
+        }
+        take_makers(fills, makers);
+        b.publish_best();
+    }
+}
+
+void OrderService::restore(SymbolId symbol, const std::vector<BookFill>& fills,
+                           const std::vector<std::optional<OrderInfo>>& makers, std::size_t from) {
+    auto& b = books_[symbol];
+    std::lock_guard lk(b.mu);
+    for (std::size_t i = fills.size(); i-- > from;) {
+        const auto& fill = fills[i];
+        const auto& maker = makers[i];
+        if (!maker) continue;
+        if (fill.maker_left > 0) {
+            // Still resting, unless its owner cancelled or amended it meanwhile.
+            auto info = orders_.get(fill.maker_tag);
+            if (!info || info->handle != maker->handle) continue;
+        }
+        const auto handle = b.book.restore(maker->handle, fill.maker_side, fill.price, fill.quantity, fill.maker_tag);
+        if (handle == kNoOrder) continue;
+        auto info = *maker;
+        info.handle = handle;
+        orders_.put(fill.maker_tag, info);
+    }
+    b.publish_best();
+}
+
+bool OrderService::settle_leg(uint64_t user_id, uint64_t account_id, SymbolId symbol, Side side,
+                              double price, int quantity) {
+    if (side == Side::Buy) return stock_.buy_at(user_id, symbol, quantity, account_id, price).has_value();
+    return stock_.sell_at(user_id, symbol, quantity, account_id, price).has_value();
+}
+
+void OrderService::reject(uint64_t order_id, uint64_t user_id, SymbolId symbol, Side side, double price) {
+    int cancelled = 0;
+    {
+        auto& b = books_[symbol];
+        std::lock_guard lk(b.mu);
+        if (auto info = orders_.get(order_id)) {
+            if (auto view = b.book.find(info->handle)) {
+                cancelled = static_cast<int>(view->remaining);
+                b.book.cancel(info->handle);
+                b.publish_best();
+            }
+            orders_.erase(order_id);
+        }
+    }
+    emit({OrderEvent::Kind::Rejected, order_id, user_id, symbol, side, price, cancelled, 0});
+}
+
+void OrderService::emit(const OrderEvent& event) const {
+    for (const auto& handler : handlers_) handler(event);
+}
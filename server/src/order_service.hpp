@@ -0,0 +1,135 @@
+#pragma once
+#include "order_book.hpp"
+#include "stock_service.hpp"
+#include "price_engine.hpp"
+#include "concurrent_map.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+struct OrderEvent {
+    enum class Kind : uint8_t { Fill, Rejected };
+    Kind kind;
+    uint64_t order_id;
+    uint64_t user_id;
+    SymbolId symbol;
+    Side side;
+    double price;   // USD; the fill price, or the limit for a rejection
+    int quantity;   // filled, or cancelled for a rejection
+    int remaining;  // still resting after the event
+};
+
+struct PlaceResult {
+    uint64_t order_id;
+    int filled;
+    int remaining;
+};
+
+struct RestingOrder {
+    SymbolId symbol;
+    Side side;
+    double price;
+    int remaining;
+};
+
+// Limit orders on one book per instrument. An incoming order first matches
+// resting orders on the other side; whatever remains rests until a user
+// order or a price tick crosses it. The simulated market is the counterparty
+// at every tick: bids at or above the quote and asks at or below it fill at
+// the quote with unlimited depth.
+//
+// Fills settle through StockService at the fill price after the book lock
+// is released. A fill between two users settles both sides at once with
+// StockService::settle_match; a fill against the market has only the
+// resting side. Nothing is reserved while an order rests, so a party that
+// lacks the funds or the shares fails its fill and has its remainder
+// cancelled and reported as Rejected. A failed maker's share of the taker
+// is matched again; a failed taker puts its makers back in the book ahead
+// of their level, unfilled.
+//
+// Must be constructed before prices.start() and outlive the engine's ticking.
+class OrderService {
+public:
+    OrderService(IBankService& bank, StockService& stock, PriceEngine& prices);
+
+    OrderService(const OrderService&) = delete;
+    OrderService& operator=(const OrderService&) = delete;
+
+    // Fills and rejections; called on the thread that caused them, never
+    // under a book lock. Register before trading starts.
+    void on_event(std::function<void(const OrderEvent&)> handler) {
+        handlers_.push_back(std::move(handler));
+    }
+
+    // Prices are rounded to kPriceTick. nullopt for an unknown symbol, an
+    // account the user does not own, or a non-positive price or quantity.
+    std::optional<PlaceResult> place(uint64_t user_id, SymbolId symbol, Side side,
+                                     double price, int quantity, uint64_t account_id);
+    bool cancel(uint64_t user_id, uint64_t order_id);
+    // `quantity` is the new remaining quantity. A lower quantity at the same
+    // price keeps the order's place in the queue; anything else re-queues it
+    // and may match immediately.
+    std::optional<PlaceResult> amend(uint64_t user_id, uint64_t order_id, double price, int quantity);
+
+    std::optional<RestingOrder> find(uint64_t user_id, uint64_t order_id) const;
+
+private:
+    struct OrderInfo {
+        uint64_t user_id;
+        uint64_t account_id;
+        SymbolId symbol;
+        Side side;
+        OrderHandle handle;
+    };
+
+    // The taker of a place/amend call; its fills are not in the order map.
+    struct Taker {
+        uint64_t order_id;
+        uint64_t user_id;
+        uint64_t account_id;
+        SymbolId symbol;
+        Side side;
+        int64_t price;
+        int quantity;
+    };
+
+    // The best prices are mirrored outside the lock so a tick skips every
+    // book it does not cross without touching the mutex.
+    struct alignas(64) Book {
+        std::mutex mu;
+        OrderBook book;
+        std::atomic<int64_t> best_bid{INT64_MIN};
+        std::atomic<int64_t> best_ask{INT64_MAX};
+
+        void publish_best();
+    };
+
+    void on_tick(const MarketSnapshot& snapshot);
+    // Under the book lock: the order behind each fill, dropping from the
+    // order map the makers a fill completed.
+    void take_makers(const std::vector<BookFill>& fills, std::vector<std::optional<OrderInfo>>& makers);
+    void settle_market(SymbolId symbol, const std::vector<BookFill>& fills,
+                       const std::vector<std::optional<OrderInfo>>& makers);
+    // Returns the quantity the taker actually settled.
+    int settle_taker(const Taker& taker, std::vector<BookFill> fills, std::vector<std::optional<OrderInfo>> makers);
+    // Undoes fills[from..] for makers whose taker could not settle.
+    void restore(SymbolId symbol, const std::vector<BookFill>& fills,
+                 const std::vector<std::optional<OrderInfo>>& makers, std::size_t from);
+    bool settle_leg(uint64_t user_id, uint64_t account_id, SymbolId symbol, Side side, double price, int quantity);
+    void reject(uint64_t order_id, uint64_t user_id, SymbolId symbol, Side side, double price);
+    void emit(const OrderEvent& event) const;
+
+    IBankService& bank_;
+    StockService& stock_;
+    const std::size_t symbols_;
+    std::unique_ptr<Book[]> books_;
+    ConcurrentMap<uint64_t, OrderInfo> orders_;  // resting orders; changed only under their book's lock
+    std::atomic<uint64_t> next_id_{1};
+    std::vector<std::function<void(const OrderEvent&)>> handlers_;
+    std::vector<BookFill> tick_fills_;  // engine thread only
+    std::vector<std::optional<OrderInfo>> tick_makers_;  // engine thread only
+};
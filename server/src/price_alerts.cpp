@@ -0,0 +1,117 @@
+#include "price_alerts.hpp"
+
+#include "tcp_framing.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace {
+
+bool holds(const std::vector<Position>& positions, SymbolId symbol) {
+    return std::any_of(positions.begin(), positions.end(),
+                       [&](const Position& p) { return p.symbol == symbol && p.quantity > 0; });
+}
+
+}  // namespace
+
+PriceAlerts::PriceAlerts(StockService& stock, PriceEngine& prices, SessionRegistry& sessions, double threshold)
+    : stock_(stock),
+      prices_(prices),
+      sessions_(sessions),
+      threshold_(threshold),
+      symbols_(prices.symbols().size()),
+      watchers_(new Watchers[prices.symbols().size()]),
+      last_quotes_(prices.read([](const MarketSnapshot& s) { return s.quotes; })) {
+    stock.on_holding_change([this](uint64_t user_id, SymbolId symbol) { refresh(user_id, symbol); });
+    sessions.on_presence([this](uint64_t user_id, bool online) { presence(user_id, online); });
+    prices.on_tick([this](const MarketSnapshot& snapshot) { on_tick(snapshot); });
+}
+
+std::size_t PriceAlerts::watchers(SymbolId symbol) const {
+    if (symbol >= symbols_) return 0;
+    std::lock_guard lk(watchers_[symbol].mu);
+    return watchers_[symbol].users.size();
+}
+
+void PriceAlerts::watch(SymbolId symbol, uint64_t user_id) {
+    auto& w = watchers_[symbol];
+    std::lock_guard lk(w.mu);
+    w.users.push_back(user_id);
+}
+
+void PriceAlerts::unwatch(SymbolId symbol, uint64_t user_id) {
+    auto& w = watchers_[symbol];
+    std::lock_guard lk(w.mu);
+    auto it = std::find(w.users.begin(), w.users.end(), user_id);
+    if (it == w.users.end()) return;
+    *it = w.users.back();
+    w.users.pop_back();
+}
+
+void PriceAlerts::presence(uint64_t user_id, bool online) {
+    auto user = users_.get_or_create(user_id, [] { return std::make_shared<UserState>(); });
+    std::lock_guard lk(user->mu);
+    user->online = online;
+    if (!online) {
+        for (SymbolId symbol : user->watched) unwatch(symbol, user_id);
+        user->watched.clear();
+        return;
+    }
+    for (const auto& pos : stock_.get_portfolio(user_id)) {
+        if (pos.quantity <= 0 || pos.symbol >= symbols_) continue;
+        if (std::find(user->watched.begin(), user->watched.end(), pos.symbol) != user->watched.end()) continue;
+        user->watched.push_back(pos.symbol);
+        watch(pos.symbol, user_id);
+    }
+}
+
+void PriceAlerts::refresh(uint64_t user_id, SymbolId symbol) {
+    auto user = users_.get(user_id);
+    if (!user || symbol >= symbols_) return;
+    std::lock_guard lk((*user)->mu);
+    if (!(*user)->online) return;
+    // Read the portfolio rather than trust the caller: trade callbacks for
+    // one user may arrive out of order, and the last one must win.
+    const bool held = holds(stock_.get_portfolio(user_id), symbol);
+    auto& watched = (*user)->watched;
+    auto it = std::find(watched.begin(), watched.end(), symbol);
+    if (held && it == watched.end()) {
+        watched.push_back(symbol);
+        watch(symbol, user_id);
+    } else if (!held && it != watched.end()) {
+        watched.erase(it);
+        unwatch(symbol, user_id);
+    }
+}
+
+void PriceAlerts::on_tick(const MarketSnapshot& snapshot) {
+    const std::size_t n = std::min(symbols_, snapshot.quotes.size());
+    last_quotes_.resize(n, 0.0);
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        const double old_price = last_quotes_[symbol];
+        const double new_price = snapshot.quotes[symbol];
+        last_quotes_[symbol] = new_price;
+        if (old_price <= 0 || std::abs(new_price - old_price) < threshold_ * old_price) continue;
+
+        {
+            auto& w = watchers_[symbol];
+            std::lock_guard lk(w.mu);
+            recipients_.assign(w.users.begin(), w.users.end());
+        }
+        if (recipients_.empty()) continue;
+
+        const nlohmann::json event = {
+            {"type", "notification"},
+            {"event", "price_alert"},
+            {"ticker", prices_.symbols().name(symbol)},
+            {"old_price", old_price},
+            {"new_price", new_price},
+            {"change_pct", (new_price - old_price) / old_price * 100.0},
+        };
+        const auto frame = std::make_shared<const std::string>(frame_json_payload(event.dump()));
+        for (uint64_t user_id : recipients_) sessions_.push(user_id, frame);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "concurrent_map.hpp"
+#include "price_engine.hpp"
+#include "session_registry.hpp"
+#include "stock_service.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pushes a price_alert to every connected holder of a symbol whose quote
+// moves by the threshold or more in one tick. A reverse index keeps, per
+// symbol, the users who are online and hold it: trades that open or close
+// a position and the first login or last disconnect of a user update it, so
+// a tick only looks at the symbols that jumped and reaches their holders
+// directly. Each alert is serialized once and the frame shared by all its
+// recipients.
+//
+// Construct before prices.start() and before the server accepts connections;
+// outlive both.
+class PriceAlerts {
+public:
+    static constexpr double kDefaultThreshold = 0.05;
+
+    PriceAlerts(StockService& stock, PriceEngine& prices, SessionRegistry& sessions,
+                double threshold = kDefaultThreshold);
+
+    PriceAlerts(const PriceAlerts&) = delete;
+    PriceAlerts& operator=(const PriceAlerts&) = delete;
+
+    // Online users holding the symbol.
+    std::size_t watchers(SymbolId symbol) const;
+
+private:
+    struct UserState {
+        std::mutex mu;
+        bool online = false;
+        std::vector<SymbolId> watched;
+    };
+
+    struct alignas(64) Watchers {
+        mutable std::mutex mu;
+        std::vector<uint64_t> users;
+    };
+
+    void presence(uint64_t user_id, bool online);
+    void refresh(uint64_t user_id, SymbolId symbol);
+    void watch(SymbolId symbol, uint64_t user_id);
+    void unwatch(SymbolId symbol, uint64_t user_id);
+    void on_tick(const MarketSnapshot& snapshot);
+
+    StockService& stock_;
+    const PriceEngine& prices_;
+    SessionRegistry& sessions_;
+    const double threshold_;
+    const std::size_t symbols_;
+    std::unique_ptr<Watchers[]> watchers_;
+    ConcurrentMap<uint64_t, std::shared_ptr<UserState>> users_;
+    std::vector<double> last_quotes_;  // engine thread only
+    std::vector<uint64_t> recipients_;
+};
@@ -1,19 +1,85 @@
 #include "price_engine.hpp"
+#include <algorithm>
 #include <random>
+#include <stdexcept>
 
-PriceEngine::PriceEngine() {
-    quotes_ = {
-        {"AAPL", 178.50}, {"GOOGL", 140.20}, {"TSLA", 245.00}, {"AMZN", 185.60},
-        {"MSFT", 415.30}, {"NFLX", 620.00}, {"META", 510.40}, {"NVDA", 790.00}
-    };
-    usd_rates_ = {
-        {Currency::USD, 1.0},
-        {Currency::RUB, 92.5},
-        {Currency::EUR, 0.92}
-    };
+namespace {
+
+uint64_t random_seed() {
+    std::random_device rd;
+    return (uint64_t{rd()} << 32) | rd();
+}
+
+}  // namespace
+
+void MarketSnapshot::fill_cross_rates() {
+    const std::size_t n = usd_rates.size();
+    cross.resize(n * n);
+    for (std::size_t f = 0; f < n; ++f) {
+        double* row = cross.data() + f * n;
+        const double from = usd_rates[f];
+        for (std::size_t t = 0; t < n; ++t)
+            row[t] = from > 0.0 && usd_rates[t] > 0.0 ? usd_rates[t] / from : 0.0;
+        row[f] = 1.0;
+    }
 }
 
-PriceEngine::~PriceEngine() { stop(); }
+PriceEngine::PriceEngine(const Universe& universe, const SimulationConfig& config)
+    : config_(config),
+      seed_(config.seed.value_or(random_seed())),
+      candles_(universe.instruments.size(), config.candle_capacity),
+      rng_(seed_),
+      fx_rng_(seed_ ^ 0x5851f42d4c957f2dULL) {
+    auto first = std::make_unique<MarketSnapshot>();
+    first->time = std::chrono::system_clock::now();
+    symbols_.reserve(universe.instruments.size());
+    first->quotes.reserve(universe.instruments.size());
+    amplitude_.reserve(universe.instruments.size());
+    for (const auto& spec : universe.instruments) {
+        symbols_.intern(spec.ticker);
+        first->quotes.push_back(spec.price);
+        amplitude_.push_back(spec.volatility);
+    }
+
+    std::vector<std::pair<Currency, const CurrencySpec*>> currencies;
+    for (const auto& spec : universe.currencies) {
+        auto id = CurrencyRegistry::instance().add(spec.code);
+        if (!id) throw std::length_error("too many currencies registered");
+        currencies.emplace_back(*id, &spec);
+    }
+    // Ids are process-wide; currencies another universe registered stay unquoted here.
+    first->usd_rates.assign(currency_count(), 0.0);
+    fx_amplitude_.assign(currency_count(), 0.0);
+    for (const auto& [id, spec] : currencies) {
+        first->usd_rates[static_cast<std::size_t>(id)] = spec->usd_rate;
+        fx_amplitude_[static_cast<std::size_t>(id)] = spec->code == "USD" ? 0.0 : spec->volatility;
+    }
+
+    if (const auto& replay = config_.replay) {
+        if (replay->tickers().size() != symbols_.size())
+            throw std::invalid_argument("replay file has different tickers");
+        for (SymbolId id = 0; id < symbols_.size(); ++id)
+            if (replay->tickers()[id] != symbols_.name(id))
+                throw std::invalid_argument("replay file has different tickers");
+        for (const auto& code : replay->currencies()) {
+            auto id = currency_from_string(code);
+            const bool quoted = id && std::any_of(currencies.begin(), currencies.end(),
+                                                  [&](const auto& c) { return c.first == *id; });
+            replay_columns_.push_back(quoted ? static_cast<std::size_t>(*id) : SIZE_MAX);
+        }
+        if (!load_replay_frame(*first)) throw std::invalid_argument("replay file has no ticks");
+    }
+    first->fill_cross_rates();
+    candles_.update(first->quotes, first->time);
+    current_.store(first.release(), std::memory_order_release);
+}
+
+PriceEngine::~PriceEngine() {
+    stop();
+    delete current_.load();
+    for (auto& [_, old] : retired_) delete old;
+    for (auto* spare : spare_) delete spare;
+}
 
 void PriceEngine::start() {
     if (running_.exchange(true)) return;
@@ -26,40 +92,91 @@ void PriceEngine::stop() {
     if (thread_.joinable()) thread_.join();
 }
 
-double PriceEngine::get_quote(const std::string& ticker) const {
-    std::shared_lock lock(mu_);
-    auto it = quotes_.find(ticker);
-    return it != quotes_.end() ? it->second : 0.0;
+double PriceEngine::get_quote(SymbolId symbol) const {
+    return read([&](const MarketSnapshot& s) { return s.quote(symbol); });
+}
+
+double PriceEngine::get_quote(std::string_view ticker) const {
+    auto symbol = symbols_.find(ticker);
+    return symbol ? get_quote(*symbol) : 0.0;
 }
 
 std::unordered_map<std::string, double> PriceEngine::get_all_quotes() const {
-    std::shared_lock lock(mu_);
-    return quotes_;
+    std::unordered_map<std::string, double> out;
+    for_each_quote([&](const std::string& ticker, double price) { out.emplace(ticker, price); });
+    return out;
 }
 
 double PriceEngine::get_rate(Currency from, Currency to) const {
     if (from == to) return 1.0;
-    std::shared_lock lock(mu_);
-    return usd_rates_.at(to) / usd_rates_.at(from);
+    return read([&](const MarketSnapshot& s) { return s.rate(from, to); });
 }
 
-void PriceEngine::run() {
-    std::mt19937 rng{std::random_device{}()};
-    std::uniform_real_distribution<> stock_pct(-0.03, 0.03);
-    std::uniform_real_distribution<> fx_pct(-0.005, 0.005);
+void PriceEngine::publish(MarketSnapshot* next) {
+    const auto* old = current_.exchange(next, std::memory_order_acq_rel);
+    retired_.emplace_back(epoch::global_epoch.load(), old);
+    const uint64_t oldest = epoch::advance();
+    for (auto it = retired_.begin(); it != retired_.end();) {
+        if (it->first < oldest) {
+            spare_.push_back(const_cast<MarketSnapshot*>(it->second));
+            it = retired_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool PriceEngine::load_replay_frame(MarketSnapshot& into) {
+    if (!config_.replay->next(frame_)) return false;
+    std::copy(frame_.quotes.begin(), frame_.quotes.end(), into.quotes.begin());
+    for (std::size_t column = 0; column < replay_columns_.size(); ++column)
+        if (replay_columns_[column] != SIZE_MAX) into.usd_rates[replay_columns_[column]] = frame_.usd_rates[column];
+    into.time = TimePoint(std::chrono::microseconds(frame_.time_us));
+    into.tick = frame_.tick;
+    return true;
+}
 
+uint64_t PriceEngine::step() {
+    // Build the next tick in a recycled snapshot; copy-assignment reuses its buffers.
+    MarketSnapshot* next;
+    if (spare_.empty()) {
+        next = new MarketSnapshot;
+    } else {
+        next = spare_.back();
+        spare_.pop_back();
+    }
+    *next = *current_.load(std::memory_order_relaxed);
+    if (config_.replay) {
+        if (!load_replay_frame(*next)) {
+            spare_.push_back(next);
+            return 0;
+        }
+    } else {
+        random_walk_step(next->quotes.data(), amplitude_.data(), next->quotes.size(), rng_);
+        random_walk_step(next->usd_rates.data(), fx_amplitude_.data(), next->usd_rates.size(), fx_rng_);
+        next->time = std::chrono::system_clock::now();
+        ++next->tick;
+    }
+    const uint64_t tick = next->tick;
+    next->fill_cross_rates();
+    publish(next);
+    candles_.update(next->quotes, next->time);
+    for (const auto& listener : listeners_) listener(*next);
+    return tick;
+}
+
+void PriceEngine::run() {
+    const auto interval = config_.tick_interval;
+    auto deadline = std::chrono::steady_clock::now();
     while (running_) {
-        {
+        if (interval.count() > 0) {
+            // Fixed cadence; after a stall, resume from now instead of bursting.
+            deadline = std::max(deadline + interval, std::chrono::steady_clock::now());
             std::unique_lock lock(cv_mu_);
-            cv_.wait_for(lock, std::chrono::milliseconds(100), [this] { return !running_.load(); });
+            cv_.wait_until(lock, deadline, [this] { return !running_.load(); });
         }
         if (!running_) break;
-
-        std::unique_lock lock(mu_);
-        for (auto& [_, price] : quotes_)
-            price *= (1.0 + stock_pct(rng));
-        for (auto& [cur, rate] : usd_rates_)
-            if (cur != Currency::USD)
-                rate *= (1.0 + fx_pct(rng));
+        const uint64_t tick = step();
+        if (tick == 0 || (config_.max_ticks && tick >= config_.max_ticks)) break;
     }
 }
@@ -1,30 +1,140 @@
 #pragma once
 #include "models.hpp"
+#include "candle_store.hpp"
+#include "epoch.hpp"
+#include "price_kernel.hpp"
+#include "symbol_table.hpp"
+#include "tick_file.hpp"
+#include "universe.hpp"
 #include <unordered_map>
-#include <shared_mutex>
+#include <string_view>
+#include <mutex>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <optional>
 #include <condition_variable>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Prices as of one tick. Immutable once published.
+struct MarketSnapshot {
+    uint64_t tick = 0;
+    TimePoint time;
+    std::vector<double> quotes;     // by SymbolId
+    std::vector<double> usd_rates;  // by Currency: 1 USD = X units; 0 if not quoted
+    std::vector<double> cross;      // [from * usd_rates.size() + to], from fill_cross_rates()
+
+    double quote(SymbolId symbol) const { return symbol < quotes.size() ? quotes[symbol] : 0.0; }
+    double usd_rate(Currency c) const {
+        const auto i = static_cast<std::size_t>(c);
+        return i < usd_rates.size() ? usd_rates[i] : 0.0;
+    }
+    // Units of `to` per unit of `from`; 0 when either side is not quoted.
+    double rate(Currency from, Currency to) const {
+        const auto f = static_cast<std::size_t>(from), t = static_cast<std::size_t>(to);
+        const std::size_t n = usd_rates.size();
+        if (f >= n || t >= n) return from == to ? 1.0 : 0.0;
+        return cross[f * n + t];
+    }
+
+    // Recomputes `cross` from `usd_rates`; once per FX tick, before publishing.
+    void fill_cross_rates();
+};
+
+// How the run() thread advances the market. The walk is bit-identical on
+// every code path, so a fixed seed reproduces the price path exactly.
+struct SimulationConfig {
+    std::optional<uint64_t> seed;                  // unset: fresh random seed
+    std::chrono::milliseconds tick_interval{100};  // zero: tick as fast as possible
+    uint64_t max_ticks = 0;                        // run() stops at or past this tick; 0 = no limit
+    // Set: ticks replay this recorded file instead of the walk. Its tickers
+    // must be the universe's, in order; the first frame is the opening tick
+    // and every tick keeps the number it was recorded under.
+    std::shared_ptr<TickReader> replay;
+    std::size_t candle_capacity = CandleStore::kDefaultCapacity;  // bars kept per symbol and interval
+};
 
 class PriceEngine {
 public:
-    PriceEngine();
+    // Registers the universe's currencies with CurrencyRegistry; throws if it
+    // is full or the replay file does not fit the universe.
+    explicit PriceEngine(const Universe& universe = Universe::defaults(),
+                         const SimulationConfig& config = {});
     ~PriceEngine();
 
     void start();
     void stop();
     bool is_running() const { return running_.load(); }
 
-    double get_quote(const std::string& ticker) const;
+    // Publishes the next tick on the calling thread and returns its number;
+    // for driving a replay step by step. Not while the run() thread is active.
+    // 0 once a replayed file is exhausted.
+    uint64_t step();
+
+    // Runs on the stepping thread after each tick is published. Register
+    // before start(); the tick loop waits for listeners, so keep them short.
+    void on_tick(std::function<void(const MarketSnapshot&)> listener) {
+        listeners_.push_back(std::move(listener));
+    }
+
+    // Seed of this engine's walk; pass it back in SimulationConfig to replay the run.
+    uint64_t seed() const { return seed_; }
+
+    const SymbolTable& symbols() const { return symbols_; }
+
+    // OHLC bars at 1s/1m/5m/1h, folded in as each tick is published.
+    const CandleStore& candles() const { return candles_; }
+
+    // Runs f(const MarketSnapshot&) against the current tick: no lock, no
+    // copy, and every value f reads comes from the same tick. The result is
+    // returned by value, so no reference into the snapshot outlives the guard.
+    template<typename F>
+    std::decay_t<std::invoke_result_t<F, const MarketSnapshot&>> read(F&& f) const {
+        epoch::Guard guard;
+        return f(*current_.load(std::memory_order_acquire));
+    }
+
+    uint64_t tick() const { return read([](const MarketSnapshot& s) { return s.tick; }); }
+    double get_quote(SymbolId symbol) const;
+    double get_quote(std::string_view ticker) const;  // 0 for an unknown ticker
     std::unordered_map<std::string, double> get_all_quotes() const;
+
+    // Calls f(const std::string& ticker, double price) for every quote of one tick.
+    template<typename F>
+    void for_each_quote(F&& f) const {
+        read([&](const MarketSnapshot& s) {
+            for (SymbolId id = 0; id < s.quotes.size(); ++id) f(symbols_.name(id), s.quotes[id]);
+        });
+    }
     double get_rate(Currency from, Currency to) const;
+    bool quotes_currency(Currency c) const {
+        return read([&](const MarketSnapshot& s) { return s.usd_rate(c) > 0.0; });
+    }
 
 private:
     void run();
+    void publish(MarketSnapshot* next);  // run() thread only
+    bool load_replay_frame(MarketSnapshot& into);
 
-    mutable std::shared_mutex mu_;
-    std::unordered_map<std::string, double> quotes_;
-    std::unordered_map<Currency, double> usd_rates_;  // 1 USD = X units of currency
+    const SimulationConfig config_;
+    const uint64_t seed_;
+    SymbolTable symbols_;  // fixed after construction
+    CandleStore candles_;
+    std::vector<double> amplitude_;  // max relative move per tick, by SymbolId
+    std::vector<double> fx_amplitude_;  // by Currency
+    WalkRng rng_;     // stepping thread only
+    WalkRng fx_rng_;
+    std::vector<std::size_t> replay_columns_;  // replay currency column → Currency, SIZE_MAX if not quoted
+    TickFrame frame_;
+    std::vector<std::function<void(const MarketSnapshot&)>> listeners_;
+    std::atomic<const MarketSnapshot*> current_{nullptr};
+    // Replaced snapshots wait here until no reader can hold them, then are reused.
+    std::vector<std::pair<uint64_t, const MarketSnapshot*>> retired_;
+    std::vector<MarketSnapshot*> spare_;
 
     std::thread thread_;
     std::atomic<bool> running_{false};
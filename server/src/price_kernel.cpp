@@ -0,0 +1,120 @@
+#include "price_kernel.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define YC_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Top 52 bits as the mantissa of a double in [1, 2), mapped to [-1, 1).
+double to_signed_unit(uint64_t bits) {
+    const uint64_t raw = (bits >> 12) | 0x3ff0000000000000ULL;
+    double d;
+    std::memcpy(&d, &raw, sizeof d);
+    return (d - 1.5) * 2.0;
+}
+
+void next_scalar(WalkRng& rng, double (&u)[WalkRng::kLanes]) {
+    for (std::size_t l = 0; l < WalkRng::kLanes; ++l) {
+        uint64_t x = rng.s0[l];
+        const uint64_t y = rng.s1[l];
+        rng.s0[l] = y;
+        x ^= x << 23;
+        rng.s1[l] = x ^ y ^ (x >> 17) ^ (y >> 26);
+        u[l] = to_signed_unit(rng.s1[l] + y);
+    }
+}
+
+}  // namespace
+
+WalkRng::WalkRng(uint64_t seed) {
+    for (std::size_t l = 0; l < kLanes; ++l) {
+        s0[l] = splitmix64(seed);
+        s1[l] = splitmix64(seed);
+    }
+}
+
+namespace detail {
+
+void random_walk_step_scalar(double* prices, const double* amplitude, std::size_t n, WalkRng& rng) {
+    double u[WalkRng::kLanes];
+    for (std::size_t i = 0; i < n; i += WalkRng::kLanes) {
+        next_scalar(rng, u);
+        for (std::size_t l = 0; l < WalkRng::kLanes && i + l < n; ++l)
+            prices[i + l] *= 1.0 + amplitude[i + l] * u[l];
+    }
+}
+
+#ifdef YC_HAVE_AVX2_KERNEL
+
+__attribute__((target("avx2")))
+static void walk_avx2(double* prices, const double* amplitude, std::size_t n, WalkRng& rng) {
+    __m256i s0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(rng.s0));
+    __m256i s1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(rng.s1));
+    const __m256i exponent = _mm256_set1_epi64x(0x3ff0000000000000LL);
+    const __m256d half = _mm256_set1_pd(1.5);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    std::size_t i = 0;
+    for (; i + WalkRng::kLanes <= n; i += WalkRng::kLanes) {
+        __m256i x = s0;
+        const __m256i y = s1;
+        s0 = y;
+        x = _mm256_xor_si256(x, _mm256_slli_epi64(x, 23));
+        s1 = _mm256_xor_si256(_mm256_xor_si256(x, y),
+                              _mm256_xor_si256(_mm256_srli_epi64(x, 17), _mm256_srli_epi64(y, 26)));
+        const __m256i bits = _mm256_or_si256(_mm256_srli_epi64(_mm256_add_epi64(s1, y), 12), exponent);
+        const __m256d u = _mm256_mul_pd(_mm256_sub_pd(_mm256_castsi256_pd(bits), half), two);
+
+        const __m256d p = _mm256_loadu_pd(prices + i);
+        const __m256d a = _mm256_loadu_pd(amplitude + i);
+        _mm256_storeu_pd(prices + i, _mm256_mul_pd(p, _mm256_add_pd(one, _mm256_mul_pd(a, u))));
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i*>(rng.s0), s0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(rng.s1), s1);
+    if (i < n) random_walk_step_scalar(prices + i, amplitude + i, n - i, rng);
+}
+
+bool random_walk_step_avx2(double* prices, const double* amplitude, std::size_t n, WalkRng& rng) {
+    if (!__builtin_cpu_supports("avx2")) return false;
+    walk_avx2(prices, amplitude, n, rng);
+    return true;
+}
+
+#else
+
+bool random_walk_step_avx2(double*, const double*, std::size_t, WalkRng&) { return false; }
+
+#endif
+
+}  // namespace detail
+
+namespace {
+
+bool use_avx2() {
+#ifdef YC_HAVE_AVX2_KERNEL
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+}  // namespace
+
+void random_walk_step(double* prices, const double* amplitude, std::size_t n, WalkRng& rng) {
+    if (!use_avx2() || !detail::random_walk_step_avx2(prices, amplitude, n, rng))
+        detail::random_walk_step_scalar(prices, amplitude, n, rng);
+}
+
+const char* random_walk_isa() { return use_avx2() ? "avx2" : "scalar"; }
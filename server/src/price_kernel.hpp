@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Four interleaved xorshift128+ generators. Shifts, adds and xors only, so
+// one AVX2 register advances all four lanes at once.
+struct WalkRng {
+    static constexpr std::size_t kLanes = 4;
+
+    explicit WalkRng(uint64_t seed = 0x9e3779b97f4a7c15ULL);
+
+    alignas(32) uint64_t s0[kLanes];
+    alignas(32) uint64_t s1[kLanes];
+};
+
+// One random-walk tick over a structure-of-arrays price store:
+//   prices[i] *= 1 + amplitude[i] * u,   u uniform in [-1, 1).
+// Element i draws from lane i % 4, so every code path consumes the generator
+// identically and produces bit-identical prices.
+void random_walk_step(double* prices, const double* amplitude, std::size_t n, WalkRng& rng);
+
+// Which implementation random_walk_step dispatches to on this CPU.
+const char* random_walk_isa();
+
+namespace detail {
+void random_walk_step_scalar(double* prices, const double* amplitude, std::size_t n, WalkRng& rng);
+bool random_walk_step_avx2(double* prices, const double* amplitude, std::size_t n, WalkRng& rng);  // false if unavailable
+}  // namespace detail
@@ -0,0 +1,187 @@
+#pragma once
+#include "concurrent_map.hpp"
+#include "epoch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Drop-in for ConcurrentMap where reads vastly outnumber writes. Lookups take
+// no lock: they probe an immutable-per-slot table with acquire loads. Writers
+// serialize on one mutex, swap slot pointers or publish a rebuilt table, and
+// hand the old memory to epoch reclamation.
+template<typename K, typename V>
+class ReadMostlyMap {
+public:
+    ReadMostlyMap() : table_(new Table(kMinCapacity)) {}
+
+    ~ReadMostlyMap() {
+        auto* table = table_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i <= table->mask; ++i) {
+            auto* node = table->slots[i].load(std::memory_order_relaxed);
+            if (node && node != tombstone()) delete node;
+        }
+        delete table;
+        for (auto& [_, node] : retired_nodes_) delete node;
+        for (auto& [_, old] : retired_tables_) delete old;
+    }
+
+    ReadMostlyMap(const ReadMostlyMap&) = delete;
+    ReadMostlyMap& operator=(const ReadMostlyMap&) = delete;
+
+    std::optional<V> get(detail::lookup_t<K> key) const {
+        const auto hash = detail::hash_key<K>(key);
+        epoch::Guard guard;
+        auto* node = find(*table_.load(std::memory_order_acquire), key, hash).first;
+        return node ? std::optional<V>(node->value) : std::nullopt;
+    }
+
+    // Calls f(const V&) inside the read section instead of copying the value out.
+    template<typename F>
+    bool visit(detail::lookup_t<K> key, F&& f) const {
+        const auto hash = detail::hash_key<K>(key);
+        epoch::Guard guard;
+        auto* node = find(*table_.load(std::memory_order_acquire), key, hash).first;
+        if (node) f(node->value);
+        return node != nullptr;
+    }
+
+    bool try_insert(const K& key, const V& value) {
+        std::lock_guard lk(write_mu_);
+        const auto hash = detail::hash_key<K>(key);
+        if (find(*table_.load(std::memory_order_relaxed), key, hash).first) return false;
+        insert(new Node{hash, key, value});
+        return true;
+    }
+
+    void put(const K& key, const V& value) {
+        std::lock_guard lk(write_mu_);
+        const auto hash = detail::hash_key<K>(key);
+        auto [old, slot] = find(*table_.load(std::memory_order_relaxed), key, hash);
+        if (!old) {
+            insert(new Node{hash, key, value});
+            return;
+        }
+        slot->store(new Node{hash, key, value}, std::memory_order_release);
+        retire(old);
+    }
+
+    bool erase(detail::lookup_t<K> key) {
+        std::lock_guard lk(write_mu_);
+        const auto hash = detail::hash_key<K>(key);
+        auto [old, slot] = find(*table_.load(std::memory_order_relaxed), key, hash);
+        if (!old) return false;
+        slot->store(tombstone(), std::memory_order_release);
+        live_--;
+        retire(old);
+        return true;
+    }
+
+    template<typename Factory>
+    V get_or_create(const K& key, Factory&& factory) {
+        if (auto found = get(key)) return *found;
+        std::lock_guard lk(write_mu_);
+        const auto hash = detail::hash_key<K>(key);
+        if (auto* node = find(*table_.load(std::memory_order_relaxed), key, hash).first) return node->value;
+        auto* node = new Node{hash, key, factory()};
+        insert(node);
+        return node->value;
+    }
+
+    // Unlinked nodes and tables not yet freed; for tests.
+    std::size_t pending_reclaim() const {
+        std::lock_guard lk(write_mu_);
+        return retired_nodes_.size() + retired_tables_.size();
+    }
+
+private:
+    static constexpr std::size_t kMinCapacity = 16;
+    static constexpr std::size_t kReclaimBatch = 64;  // bounds garbage, amortizes the reader scan
+
+    struct Node {
+        uint64_t hash;
+        K key;
+        V value;
+    };
+
+    struct Table {
+        explicit Table(std::size_t capacity)
+            : mask(capacity - 1), slots(new std::atomic<Node*>[capacity]()) {}
+        const std::size_t mask;
+        const std::unique_ptr<std::atomic<Node*>[]> slots;
+    };
+
+    static Node* tombstone() {
+        static char marker;
+        return reinterpret_cast<Node*>(&marker);
+    }
+
+    static std::pair<Node*, std::atomic<Node*>*> find(const Table& table, detail::lookup_t<K> key, uint64_t hash) {
+        for (std::size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+            auto* node = table.slots[i].load(std::memory_order_acquire);
+            if (!node) return {nullptr, nullptr};
+            if (node != tombstone() && node->hash == hash && node->key == key) return {node, &table.slots[i]};
+        }
+    }
+
+    // Caller holds write_mu_ and has checked the key is absent.
+    void insert(Node* node) {
+        auto* table = table_.load(std::memory_order_relaxed);
+        if ((used_ + 1) * 2 > table->mask + 1) table = rebuild(*table);
+        for (std::size_t i = node->hash & table->mask;; i = (i + 1) & table->mask) {
+            auto* cur = table->slots[i].load(std::memory_order_relaxed);
+            if (cur && cur != tombstone()) continue;
+            if (!cur) used_++;
+            table->slots[i].store(node, std::memory_order_release);
+            break;
+        }
+        live_++;
+    }
+
+    // Copies live nodes into a fresh table sized for growth, dropping tombstones.
+    Table* rebuild(const Table& old) {
+        std::size_t capacity = kMinCapacity;
+        while ((live_ + 1) * 4 > capacity) capacity <<= 1;
+        auto* fresh = new Table(capacity);
+        for (std::size_t s = 0; s <= old.mask; ++s) {
+            auto* node = old.slots[s].load(std::memory_order_relaxed);
+            if (!node || node == tombstone()) continue;
+            std::size_t i = node->hash & fresh->mask;
+            while (fresh->slots[i].load(std::memory_order_relaxed)) i = (i + 1) & fresh->mask;
+            fresh->slots[i].store(node, std::memory_order_relaxed);
+        }
+        used_ = live_;
+        table_.store(fresh, std::memory_order_release);
+        retired_tables_.emplace_back(epoch::global_epoch.load(), &old);
+        reclaim();
+        return fresh;
+    }
+
+    void retire(Node* node) {
+        retired_nodes_.emplace_back(epoch::global_epoch.load(), node);
+        if (retired_nodes_.size() >= kReclaimBatch) reclaim();
+    }
+
+    void reclaim() {
+        const uint64_t oldest = epoch::advance();
+        auto free_before = [oldest](auto& retired) {
+            auto keep = std::partition(retired.begin(), retired.end(),
+                                       [oldest](const auto& r) { return r.first >= oldest; });
+            for (auto it = keep; it != retired.end(); ++it) delete it->second;
+            retired.erase(keep, retired.end());
+        };
+        free_before(retired_nodes_);
+        free_before(retired_tables_);
+    }
+
+    std::atomic<Table*> table_;
+    mutable std::mutex write_mu_;
+    std::size_t used_ = 0;  // live nodes plus tombstones; guarded by write_mu_
+    std::size_t live_ = 0;
+    std::vector<std::pair<uint64_t, Node*>> retired_nodes_;
+    std::vector<std::pair<uint64_t, const Table*>> retired_tables_;
+};
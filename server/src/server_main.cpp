@@ -1,14 +1,22 @@
 #include "auth_service.hpp"
 #include "bank_service.hpp"
 #include "command_dispatcher.hpp"
+#include "ledger_auditor.hpp"
+#include "market_recorder.hpp"
+#include "order_service.hpp"
+#include "price_alerts.hpp"
 #include "price_engine.hpp"
 #include "stock_service.hpp"
 #include "tcp_server.hpp"
+#include "trade_sequencer.hpp"
+#include "trigger_service.hpp"
+#include "universe.hpp"
 
 #include <boost/asio.hpp>
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <csignal>
 #include <string>
 
@@ -20,6 +28,29 @@ std::size_t parse_threads(const char* value) {
     return parsed == 0 ? 4 : parsed;
 }
 
+// YELLOWCORE_SEQUENCER=N routes market trades through a TradeSequencer
+// with N threads.
+std::unique_ptr<TradeSequencer> sequencer_from_env(StockService& stock, PriceEngine& prices) {
+    const char* threads = std::getenv("YELLOWCORE_SEQUENCER");
+    if (!threads) return nullptr;
+    return std::make_unique<TradeSequencer>(stock, prices, std::strtoul(threads, nullptr, 10));
+}
+
+// YELLOWCORE_SEED fixes the price path; YELLOWCORE_TICK_MS=0 ticks as fast as
+// possible; YELLOWCORE_REPLAY names a tick file to play back instead.
+SimulationConfig simulation_from_env(std::string& error) {
+    SimulationConfig config;
+    if (const char* replay = std::getenv("YELLOWCORE_REPLAY")) {
+        config.replay = TickReader::open(replay, error);
+        if (!config.replay) return config;
+    }
+    if (const char* seed = std::getenv("YELLOWCORE_SEED"))
+        config.seed = std::strtoull(seed, nullptr, 10);
+    if (const char* tick_ms = std::getenv("YELLOWCORE_TICK_MS"))
+        config.tick_interval = std::chrono::milliseconds(std::strtoul(tick_ms, nullptr, 10));
+    return config;
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -27,14 +58,44 @@ int main(int argc, char** argv) {
     const unsigned short port = static_cast<unsigned short>(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 9090);
     const std::size_t threads = argc > 3 ? parse_threads(argv[3]) : 4;
 
+    std::string error;
+    auto simulation = simulation_from_env(error);
+    if (!error.empty()) {
+        std::cerr << "Bad replay file: " << error << std::endl;
+        return 1;
+    }
+
+    auto universe = simulation.replay ? simulation.replay->universe() : Universe::defaults();
+    if (argc > 4) {
+        auto loaded = Universe::load(argv[4], error);
+        if (!loaded) {
+            std::cerr << "Bad universe config: " << error << std::endl;
+            return 1;
+        }
+        universe = std::move(*loaded);
+    }
+
     try {
+        std::unique_ptr<MarketRecorder> recorder;  // outlives the engine that feeds it
         AuthService auth;
         BankService bank;
-        PriceEngine prices;
+        PriceEngine prices(universe, simulation);
         StockService stock(bank, prices);
-        CommandDispatcher dispatcher(auth, bank, stock, prices);
+        OrderService orders(bank, stock, prices);
+        TriggerService triggers(bank, stock, prices);
+        auto sequencer = sequencer_from_env(stock, prices);
+        CommandDispatcher dispatcher(auth, bank, stock, prices, &orders, &triggers, sequencer.get());
+        PriceAlerts alerts(stock, prices, dispatcher.sessions());
+        LedgerAuditor auditor(bank);
+        auditor.check_stocks(stock);
 
-        prices.start();
+        // YELLOWCORE_RECORD names a tick file that receives every published tick.
+        if (const char* record = std::getenv("YELLOWCORE_RECORD")) {
+            auto writer = create_tick_writer(prices, record, error);
+            if (!writer) throw std::runtime_error(error);
+            recorder = std::make_unique<MarketRecorder>(prices, std::move(writer));
+            recorder->start();
+        }
 
         auto address = boost::asio::ip::make_address(host);
         TcpServer server(address, port, threads, dispatcher);
@@ -43,11 +104,23 @@ int main(int argc, char** argv) {
             server.stop();
         });
 
+        // Start ticking only once nothing below can throw: the tick listeners
+        // point into objects declared after the engine.
+        if (sequencer) sequencer->start();
+        prices.start();
+        auditor.start();
+
         std::cout << "YellowCore server listening on " << host << ':' << port
-                  << " with " << threads << " worker threads" << std::endl;
+                  << " with " << threads << " worker threads, "
+                  << universe.instruments.size() << " instruments and "
+                  << universe.currencies.size() << " currencies, price seed "
+                  << prices.seed() << std::endl;
 
         server.run();
+        auditor.stop();
         prices.stop();
+        if (sequencer) sequencer->stop();
+        if (recorder) recorder->stop();
         return 0;
     } catch (const std::exception& ex) {
         std::cerr << "Server startup failed: " << ex.what() << std::endl;
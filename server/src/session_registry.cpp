@@ -0,0 +1,87 @@
+#include "session_registry.hpp"
+
+#include "tcp_framing.hpp"
+#include "tcp_session.hpp"
+
+#include <algorithm>
+
+template <typename Pred>
+std::size_t SessionRegistry::remove(uint64_t user_id, std::vector<Bound>& list, Pred drop) {
+    if (list.empty()) return 0;
+    std::size_t dropped = 0;
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const Bound& b) {
+                                  auto locked = b.session.lock();
+                                  if (!locked) return true;
+                                  if (!drop(b, locked.get())) return false;
+                                  ++dropped;
+                                  return true;
+                              }),
+               list.end());
+    if (list.empty()) {
+        for (const auto& handler : presence_handlers_) handler(user_id, false);
+    }
+    return dropped;
+}
+
+void SessionRegistry::bind(uint64_t user_id, std::string token, const std::shared_ptr<TcpSession>& session) {
+    auto user = users_.get_or_create(user_id, [] { return std::make_shared<UserSessions>(); });
+    std::lock_guard lk(user->mu);
+    // Drop sessions that closed without unbinding while we are here.
+    auto& list = user->sessions;
+    list.erase(std::remove_if(list.begin(), list.end(), [](const Bound& b) { return b.session.expired(); }),
+               list.end());
+    for (auto& bound : list) {
+        if (bound.session.lock() == session) {
+            bound.token = std::move(token);
+            return;
+        }
+    }
+    list.push_back({session, std::move(token)});
+    if (list.size() == 1) {
+        for (const auto& handler : presence_handlers_) handler(user_id, true);
+    }
+}
+
+void SessionRegistry::unbind(uint64_t user_id, const TcpSession* session) {
+    auto user = users_.get(user_id);
+    if (!user) return;
+    std::lock_guard lk((*user)->mu);
+    remove(user_id, (*user)->sessions, [&](const Bound&, const TcpSession* s) { return s == session; });
+}
+
+std::size_t SessionRegistry::revoke(uint64_t user_id, std::string_view token) {
+    auto user = users_.get(user_id);
+    if (!user) return 0;
+    std::lock_guard lk((*user)->mu);
+    return remove(user_id, (*user)->sessions, [&](const Bound& b, const TcpSession*) { return b.token == token; });
+}
+
+std::vector<std::shared_ptr<TcpSession>> SessionRegistry::live(uint64_t user_id) const {
+    std::vector<std::shared_ptr<TcpSession>> out;
+    auto user = users_.get(user_id);
+    if (!user) return out;
+    std::lock_guard lk((*user)->mu);
+    for (const auto& bound : (*user)->sessions) {
+        if (auto session = bound.session.lock()) out.push_back(std::move(session));
+    }
+    return out;
+}
+
+std::size_t SessionRegistry::push(uint64_t user_id, const nlohmann::json& event) const {
+    const auto targets = live(user_id);
+    if (targets.empty()) return 0;
+    const auto frame = std::make_shared<const std::string>(frame_json_payload(event.dump()));
+    for (const auto& session : targets) session->push(frame);
+    return targets.size();
+}
+
+std::size_t SessionRegistry::push(uint64_t user_id, const std::shared_ptr<const std::string>& frame) const {
+    const auto targets = live(user_id);
+    for (const auto& session : targets) session->push(frame);
+    return targets.size();
+}
+
+std::size_t SessionRegistry::sessions(uint64_t user_id) const {
+    return live(user_id).size();
+}
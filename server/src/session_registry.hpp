@@ -0,0 +1,65 @@
+#pragma once
+
+#include "concurrent_map.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TcpSession;
+
+// Live sessions of each logged-in user, for server-initiated notifications.
+// A session binds on login with its token and unbinds on disconnect; logging
+// a token out drops every session bound with it, on whichever connection.
+// Entries are weak so the registry never keeps a closed connection alive.
+class SessionRegistry {
+public:
+    // Binding a session that is already bound only replaces its token.
+    void bind(uint64_t user_id, std::string token, const std::shared_ptr<TcpSession>& session);
+    void unbind(uint64_t user_id, const TcpSession* session);
+    // Unbinds every session of the user bound with `token`; returns how many.
+    std::size_t revoke(uint64_t user_id, std::string_view token);
+
+    // Called with true when a user's first session binds and false when the
+    // last one unbinds, under that user's lock so the calls for one user
+    // never reorder. Register before the server accepts connections.
+    void on_presence(std::function<void(uint64_t user_id, bool online)> handler) {
+        presence_handlers_.push_back(std::move(handler));
+    }
+
+    // Serializes and frames `event` once, then queues the same buffer on
+    // every session of the user. Nothing is serialized for a user with no
+    // sessions. Returns the number of sessions reached.
+    std::size_t push(uint64_t user_id, const nlohmann::json& event) const;
+    std::size_t push(uint64_t user_id, const std::shared_ptr<const std::string>& frame) const;
+
+    std::size_t sessions(uint64_t user_id) const;
+
+private:
+    struct Bound {
+        std::weak_ptr<TcpSession> session;
+        std::string token;
+    };
+
+    struct UserSessions {
+        std::mutex mu;
+        std::vector<Bound> sessions;
+    };
+
+    // Erases the entries matching `drop` along with closed ones, then fires
+    // the offline handlers if that emptied the list. Under the user's lock.
+    template <typename Pred>
+    std::size_t remove(uint64_t user_id, std::vector<Bound>& list, Pred drop);
+
+    std::vector<std::shared_ptr<TcpSession>> live(uint64_t user_id) const;
+
+    ConcurrentMap<uint64_t, std::shared_ptr<UserSessions>> users_;
+    std::vector<std::function<void(uint64_t, bool)>> presence_handlers_;
+};
@@ -1,100 +1,329 @@
 #include "stock_service.hpp"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+Position& position_for(UserPortfolio& up, SymbolId symbol) {
+    for (auto& pos : up.positions)
+        if (pos.symbol == symbol) return pos;
+    return up.positions.emplace_back(Position{symbol, 0, 0.0});
+}
+
+Lot& lot_for(UserPortfolio& up, uint64_t account_id, SymbolId symbol) {
+    for (auto& lot : up.lots)
+        if (lot.account_id == account_id && lot.symbol == symbol) return lot;
+    return up.lots.emplace_back(Lot{account_id, symbol, 0});
+}
+
+// Price and conversion rate from one snapshot, so a trade never mixes ticks.
+TickPrice price_at_tick(const PriceEngine& prices, SymbolId symbol, Currency currency) {
+    return prices.read([&](const MarketSnapshot& s) {
+        return TickPrice{s.quote(symbol), s.rate(Currency::USD, currency), s.tick};
+    });
+}
+
+// Same lookup as MarketSnapshot::rate(USD, currency) on a captured row.
+double rate_from(const std::vector<double>& usd_rates, Currency currency) {
+    const auto i = static_cast<std::size_t>(currency);
+    if (i >= usd_rates.size()) return currency == Currency::USD ? 1.0 : 0.0;
+    return usd_rates[i];
+}
+
+template<typename T, typename Pred>
+T* find_in(std::vector<T>& items, Pred&& pred) {
+    auto it = std::find_if(items.begin(), items.end(), pred);
+    return it != items.end() ? &*it : nullptr;
+}
+
+// Moves the mark to `quote` unless the position already carries a newer
+// tick, then values the position at its mark.
+void revalue(Position& pos, double quote, uint64_t tick) {
+    if (tick >= pos.mark_tick) {
+        pos.mark = quote;
+        pos.mark_tick = tick;
+    }
+    pos.market_value = pos.mark * pos.quantity;
+    pos.unrealized_pnl = (pos.mark - pos.avg_price) * pos.quantity;
+}
+
+// Re-sums the totals after a trade; ticks adjust them by deltas instead.
+void retotal(UserPortfolio& up, uint64_t tick) {
+    PortfolioTotals totals;
+    for (const auto& pos : up.positions) {
+        totals.market_value += pos.market_value;
+        totals.cost_basis += pos.avg_price * pos.quantity;
+        totals.unrealized_pnl += pos.unrealized_pnl;
+    }
+    up.totals = totals;
+    up.tick = std::max(up.tick, tick);
+    ++up.version;
+}
+
+// Books a bought lot at `price`; caller holds up.mu. True if the position opened.
+bool add_shares(UserPortfolio& up, uint64_t account_id, SymbolId symbol, int quantity, double price,
+                double quote, uint64_t tick) {
+    auto& pos = position_for(up, symbol);
+    const bool opened = pos.quantity == 0;
+    double total = pos.avg_price * pos.quantity + price * quantity;
+    pos.quantity += quantity;
+    pos.avg_price = total / pos.quantity;
+    revalue(pos, quote, tick);
+    retotal(up, tick);
+    lot_for(up, account_id, symbol).quantity += quantity;
+    up.trades.append({std::chrono::system_clock::now(), symbol, true, quantity, price, tick});
+    return opened;
+}
+
+// Books a sale at `price`; caller holds up.mu. False, with nothing changed,
+// if the account holds fewer than `quantity` shares.
+bool remove_shares(UserPortfolio& up, uint64_t account_id, SymbolId symbol, int quantity, double price,
+                   double quote, uint64_t tick, bool& closed) {
+    auto* pos = find_in(up.positions, [&](const Position& p) { return p.symbol == symbol; });
+    if (!pos || pos->quantity < quantity) {
+        return false;
+    }
+
+    auto* lot = find_in(up.lots, [&](const Lot& l) {
+        return l.account_id == account_id && l.symbol == symbol;
+    });
+    if (!lot || lot->quantity < quantity) {
+        return false;
+    }
+
+    pos->quantity -= quantity;
+    lot->quantity -= quantity;
+    if (lot->quantity == 0) {
+        up.lots.erase(up.lots.begin() + (lot - up.lots.data()));
+    }
+    if (pos->quantity == 0) {
+        up.positions.erase(up.positions.begin() + (pos - up.positions.data()));
+        closed = true;
+    } else {
+        revalue(*pos, quote, tick);
+    }
+    retotal(up, tick);
+    up.trades.append({std::chrono::system_clock::now(), symbol, false, quantity, price, tick});
+    return true;
+}
+
+// True if the caller must add the portfolio to the symbol's holder list.
+bool claim_index(UserPortfolio& up, SymbolId symbol) {
+    if (std::find(up.indexed.begin(), up.indexed.end(), symbol) != up.indexed.end()) return false;
+    up.indexed.push_back(symbol);
+    return true;
+}
+
+}  // namespace
 
 StockService::StockService(IBankService& bank, PriceEngine& prices)
-    : bank_(bank), prices_(prices) {}
+    : bank_(bank),
+      prices_(prices),
+      symbols_(prices.symbols().size()),
+      holders_(new Holders[prices.symbols().size()]) {
+    prices.on_tick([this](const MarketSnapshot& snapshot) { on_tick(snapshot); });
+}
+
+void StockService::index(SymbolId symbol, const std::shared_ptr<UserPortfolio>& up) {
+    auto& h = holders_[symbol];
+    std::lock_guard lk(h.mu);
+    h.portfolios.push_back(up);
+}
+
+void StockService::holding_changed(uint64_t user_id, SymbolId symbol) const {
+    for (const auto& handler : holding_handlers_) handler(user_id, symbol);
+}
+
+void StockService::on_tick(const MarketSnapshot& snapshot) {
+    const std::size_t n = std::min(symbols_, snapshot.quotes.size());
+    last_quotes_.resize(n, 0.0);
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        const double quote = snapshot.quotes[symbol];
+        if (quote == last_quotes_[symbol]) continue;
+        last_quotes_[symbol] = quote;
+
+        auto& h = holders_[symbol];
+        std::lock_guard lk(h.mu);
+        auto& list = h.portfolios;
+        for (std::size_t i = 0; i < list.size();) {
+            auto& up = *list[i];
+            std::unique_lock plk(up.mu);
+            auto* pos = find_in(up.positions, [&](const Position& p) { return p.symbol == symbol; });
+            if (!pos) {
+                up.indexed.erase(std::find(up.indexed.begin(), up.indexed.end(), symbol));
+                plk.unlock();
+                list[i] = std::move(list.back());
+                list.pop_back();
+                continue;
+            }
+            const double market_value = pos->market_value, pnl = pos->unrealized_pnl;
+            revalue(*pos, quote, snapshot.tick);
+            up.totals.market_value += pos->market_value - market_value;
+            up.totals.unrealized_pnl += pos->unrealized_pnl - pnl;
+            up.tick = std::max(up.tick, snapshot.tick);
+            ++up.version;
+            ++i;
+        }
+    }
+}
+
+std::optional<BuyResult> StockService::buy(
+    uint64_t user_id, std::string_view ticker, int quantity, uint64_t account_id) {
+    auto symbol = prices_.symbols().find(ticker);
+    if (!symbol) return std::nullopt;
+    return buy(user_id, *symbol, quantity, account_id);
+}
+
+std::optional<SellResult> StockService::sell(
+    uint64_t user_id, std::string_view ticker, int quantity, uint64_t account_id) {
+    auto symbol = prices_.symbols().find(ticker);
+    if (!symbol) return std::nullopt;
+    return sell(user_id, *symbol, quantity, account_id);
+}
 
 std::optional<BuyResult> StockService::buy(
-    uint64_t user_id, const std::string& ticker, int quantity, uint64_t account_id) {
+    uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id) {
+    return buy_at(user_id, symbol, quantity, account_id, 0.0);
+}
+
+std::optional<SellResult> StockService::sell(
+    uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id) {
+    return sell_at(user_id, symbol, quantity, account_id, 0.0);
+}
+
+std::optional<BuyResult> StockService::buy_at(
+    uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id, double usd_price) {
     if (quantity <= 0) return std::nullopt;
 
-    double price = prices_.get_quote(ticker);
-    if (price <= 0) return std::nullopt;
+    auto acc = bank_.get_account_summary(account_id);
+    if (!acc || acc->user_id != user_id) return std::nullopt;
+
+    const auto at = price_at_tick(prices_, symbol, acc->currency);
+    return buy_priced(user_id, symbol, quantity, account_id, usd_price > 0 ? usd_price : at.price, at);
+}
 
-    auto acc = bank_.get_account(account_id);
+std::optional<BuyResult> StockService::buy_on_tick(uint64_t user_id, SymbolId symbol, int quantity,
+                                                   uint64_t account_id, double usd_price, uint64_t tick,
+                                                   const std::vector<double>& usd_rates) {
+    if (quantity <= 0) return std::nullopt;
+
+    auto acc = bank_.get_account_summary(account_id);
     if (!acc || acc->user_id != user_id) return std::nullopt;
 
-    double rate = prices_.get_rate(Currency::USD, acc->currency);
-    double cost_local = price * quantity * rate;
+    const TickPrice at{usd_price, rate_from(usd_rates, acc->currency), tick};
+    return buy_priced(user_id, symbol, quantity, account_id, usd_price, at);
+}
 
-    auto new_balance = bank_.debit_for_stock(user_id, account_id, cost_local, ticker);
-    if (!new_balance) return std::nullopt;
+std::optional<BuyResult> StockService::buy_priced(uint64_t user_id, SymbolId symbol, int quantity,
+                                                  uint64_t account_id, double price, const TickPrice& at) {
+    if (price <= 0) return std::nullopt;
+    const auto [quote, rate, tick] = at;
+
+    double cost_local = price * quantity * rate;
 
     auto up = users_.get_or_create(user_id, [] { return std::make_shared<UserPortfolio>(); });
-    {
+    bool needs_index = false, opened = false;
+    auto apply = [&] {
         std::unique_lock lk(up->mu);
-        auto& pos = up->positions[ticker];
-        if (pos.ticker.empty()) pos.ticker = ticker;
-        double total = pos.avg_price * pos.quantity + price * quantity;
-        pos.quantity += quantity;
-        pos.avg_price = total / pos.quantity;
-        up->account_positions[account_id][ticker] += quantity;
-        up->trades.push_back({std::chrono::system_clock::now(), ticker, true, quantity, price});
-    }
+        opened = add_shares(*up, account_id, symbol, quantity, price, quote, tick);
+        needs_index = claim_index(*up, symbol);
+        return true;
+    };
+    // std::ref keeps std::function from allocating for the capture.
+    auto new_balance = bank_.settle_stock(user_id, account_id, true, cost_local, symbol, std::ref(apply));
+    if (!new_balance) return std::nullopt;
+    if (needs_index) index(symbol, up);
+    if (opened) holding_changed(user_id, symbol);
 
     return BuyResult{price, cost_local, *new_balance};
 }
 
-std::optional<SellResult> StockService::sell(
-    uint64_t user_id, const std::string& ticker, int quantity, uint64_t account_id) {
+std::optional<SellResult> StockService::sell_at(
+    uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id, double usd_price) {
     if (quantity <= 0) return std::nullopt;
 
-    double price = prices_.get_quote(ticker);
-    if (price <= 0) return std::nullopt;
+    auto acc = bank_.get_account_summary(account_id);
+    if (!acc || acc->user_id != user_id) return std::nullopt;
+
+    const auto at = price_at_tick(prices_, symbol, acc->currency);
+    return sell_priced(user_id, symbol, quantity, account_id, usd_price > 0 ? usd_price : at.price, at);
+}
 
-    auto acc = bank_.get_account(account_id);
+std::optional<SellResult> StockService::sell_on_tick(uint64_t user_id, SymbolId symbol, int quantity,
+                                                     uint64_t account_id, double usd_price, uint64_t tick,
+                                                     const std::vector<double>& usd_rates) {
+    if (quantity <= 0) return std::nullopt;
+
+    auto acc = bank_.get_account_summary(account_id);
     if (!acc || acc->user_id != user_id) return std::nullopt;
 
+    const TickPrice at{usd_price, rate_from(usd_rates, acc->currency), tick};
+    return sell_priced(user_id, symbol, quantity, account_id, usd_price, at);
+}
+
+std::optional<SellResult> StockService::sell_priced(uint64_t user_id, SymbolId symbol, int quantity,
+                                                    uint64_t account_id, double price, const TickPrice& at) {
+    if (price <= 0) return std::nullopt;
+    const auto [quote, rate, tick] = at;
+
     auto up_opt = users_.get(user_id);
     if (!up_opt) return std::nullopt;
     auto& up = *up_opt;
-    {
-        std::unique_lock lk(up->mu);
-        auto pit = up->positions.find(ticker);
-        if (pit == up->positions.end() || pit->second.quantity < quantity) {
-            return std::nullopt;
-        }
 
-        auto account_it = up->account_positions.find(account_id);
-        if (account_it == up->account_positions.end()) {
-            return std::nullopt;
-        }
+    double revenue_local = price * quantity * rate;
 
-        auto lot_it = account_it->second.find(ticker);
-        if (lot_it == account_it->second.end() || lot_it->second < quantity) {
-            return std::nullopt;
-        }
+    bool closed = false;
+    auto apply = [&] {
+        std::unique_lock lk(up->mu);
+        return remove_shares(*up, account_id, symbol, quantity, price, quote, tick, closed);
+    };
+    auto new_balance = bank_.settle_stock(user_id, account_id, false, revenue_local, symbol, std::ref(apply));
+    if (!new_balance) return std::nullopt;
+    if (closed) holding_changed(user_id, symbol);
 
-        pit->second.quantity -= quantity;
-        lot_it->second -= quantity;
-        if (lot_it->second == 0) {
-            account_it->second.erase(lot_it);
-        }
-        if (account_it->second.empty()) {
-            up->account_positions.erase(account_it);
-        }
-    }
+    return SellResult{price, revenue_local, *new_balance};
+}
 
-    double rate = prices_.get_rate(Currency::USD, acc->currency);
-    double revenue_local = price * quantity * rate;
+MatchResult StockService::settle_match(uint64_t buyer_id, uint64_t buyer_account, uint64_t seller_id,
+                                       uint64_t seller_account, SymbolId symbol, int quantity, double usd_price) {
+    auto buyer_acc = bank_.get_account_summary(buyer_account);
+    if (!buyer_acc || buyer_acc->user_id != buyer_id) return {SettleParty::Buyer};
+    auto seller_acc = bank_.get_account_summary(seller_account);
+    if (!seller_acc || seller_acc->user_id != seller_id) return {SettleParty::Seller};
+    auto seller_opt = users_.get(seller_id);
+    if (!seller_opt) return {SettleParty::Seller};
+    auto& seller = *seller_opt;
+    auto buyer = users_.get_or_create(buyer_id, [] { return std::make_shared<UserPortfolio>(); });
 
-    auto new_balance = bank_.credit_for_stock(user_id, account_id, revenue_local, ticker);
-    if (!new_balance) {
-        std::unique_lock lk(up->mu);
-        up->positions[ticker].quantity += quantity;
-        up->account_positions[account_id][ticker] += quantity;
-        return std::nullopt;
-    }
+    struct MatchPrice { double quote, buyer_rate, seller_rate; uint64_t tick; };
+    const auto at = prices_.read([&](const MarketSnapshot& s) {
+        return MatchPrice{s.quote(symbol), s.rate(Currency::USD, buyer_acc->currency),
+                          s.rate(Currency::USD, seller_acc->currency), s.tick};
+    });
+    const double cost = usd_price * quantity * at.buyer_rate;
+    const double revenue = usd_price * quantity * at.seller_rate;
 
-    {
-        std::unique_lock lk(up->mu);
-        auto& pos = up->positions[ticker];
-        if (pos.quantity == 0) {
-            up->positions.erase(ticker);
-        }
-        up->trades.push_back({std::chrono::system_clock::now(), ticker, false, quantity, price});
-    }
+    bool needs_index = false, opened = false, closed = false;
+    auto apply = [&] {
+        std::unique_lock slk(seller->mu, std::defer_lock);
+        std::unique_lock blk(buyer->mu, std::defer_lock);
+        if (seller == buyer) slk.lock();
+        else std::lock(slk, blk);
+        if (!remove_shares(*seller, seller_account, symbol, quantity, usd_price, at.quote, at.tick, closed))
+            return false;
+        opened = add_shares(*buyer, buyer_account, symbol, quantity, usd_price, at.quote, at.tick);
+        needs_index = claim_index(*buyer, symbol);
+        return true;
+    };
+    const auto settled = bank_.settle_stock_pair({buyer_id, buyer_account, cost}, {seller_id, seller_account, revenue},
+                                                 symbol, std::ref(apply));
+    if (!settled.ok()) return {settled.failed};
+    if (needs_index) index(symbol, buyer);
+    if (closed) holding_changed(seller_id, symbol);
+    if (opened) holding_changed(buyer_id, symbol);
 
-    return SellResult{price, revenue_local, *new_balance};
+    return {SettleParty::None, BuyResult{usd_price, cost, settled.buyer_balance},
+            SellResult{usd_price, revenue, settled.seller_balance}};
 }
 
 std::vector<Position> StockService::get_portfolio(uint64_t user_id) const {
@@ -102,18 +331,23 @@ std::vector<Position> StockService::get_portfolio(uint64_t user_id) const {
     if (!up_opt) return {};
     auto& up = *up_opt;
     std::shared_lock lk(up->mu);
-    std::vector<Position> result;
-    for (auto& [_, pos] : up->positions)
-        result.push_back(pos);
-    return result;
+    return up->positions;
 }
 
-std::vector<Trade> StockService::get_trades(uint64_t user_id) const {
+PortfolioSnapshot StockService::get_portfolio_snapshot(uint64_t user_id) const {
     auto up_opt = users_.get(user_id);
     if (!up_opt) return {};
     auto& up = *up_opt;
     std::shared_lock lk(up->mu);
-    return up->trades;
+    return PortfolioSnapshot{up->positions, up->totals, up->version, up->tick};
+}
+
+TradePage StockService::get_trades(uint64_t user_id, const TradeQuery& query) const {
+    auto up_opt = users_.get(user_id);
+    if (!up_opt) return {};
+    auto& up = *up_opt;
+    std::shared_lock lk(up->mu);
+    return up->trades.query(query);
 }
 
 bool StockService::has_open_positions_on_account(uint64_t user_id, uint64_t account_id) const {
@@ -122,15 +356,7 @@ bool StockService::has_open_positions_on_account(uint64_t user_id, uint64_t acco
 
     auto& up = *up_opt;
     std::shared_lock lk(up->mu);
-    auto account_it = up->account_positions.find(account_id);
-    if (account_it == up->account_positions.end()) {
-        return false;
-    }
-
-    for (const auto& [_, qty] : account_it->second) {
-        if (qty > 0) {
-            return true;
-        }
-    }
-    return false;
+    return std::any_of(up->lots.begin(), up->lots.end(), [&](const Lot& lot) {
+        return lot.account_id == account_id && lot.quantity > 0;
+    });
 }
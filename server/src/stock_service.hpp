@@ -3,49 +3,150 @@
 #include "bank_service.hpp"
 #include "price_engine.hpp"
 #include "concurrent_map.hpp"
+#include "trade_log.hpp"
 #include <vector>
+#include <functional>
 #include <shared_mutex>
 #include <optional>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <string_view>
 
 struct BuyResult  { double price; double total_cost; double new_balance; };
 struct SellResult { double price; double total_revenue; double new_balance; };
 
+// A fill between two users; both sides settled or, naming who could not, neither did.
+struct MatchResult {
+    SettleParty failed = SettleParty::None;
+    BuyResult bought{};
+    SellResult sold{};
+
+    bool ok() const { return failed == SettleParty::None; }
+};
+
+// A USD quote, its rate into the account currency and the tick both came from.
+struct TickPrice {
+    double price;  // USD
+    double rate;   // USD → account currency
+    uint64_t tick;
+};
+
 class IStockService {
 public:
     virtual ~IStockService() = default;
-    virtual std::optional<BuyResult>  buy(uint64_t user_id, const std::string& ticker,
+    virtual std::optional<BuyResult>  buy(uint64_t user_id, SymbolId symbol,
                                           int quantity, uint64_t account_id) = 0;
-    virtual std::optional<SellResult> sell(uint64_t user_id, const std::string& ticker,
+    virtual std::optional<SellResult> sell(uint64_t user_id, SymbolId symbol,
                                            int quantity, uint64_t account_id) = 0;
     virtual std::vector<Position> get_portfolio(uint64_t user_id) const = 0;
-    virtual std::vector<Trade>    get_trades(uint64_t user_id) const = 0;
+    virtual PortfolioSnapshot     get_portfolio_snapshot(uint64_t user_id) const = 0;
+    virtual TradePage             get_trades(uint64_t user_id, const TradeQuery& query) const = 0;
     virtual bool has_open_positions_on_account(uint64_t user_id, uint64_t account_id) const = 0;
 };
 
+// Quantity of one symbol held against one account.
+struct Lot {
+    uint64_t account_id;
+    SymbolId symbol;
+    int quantity;
+};
+
+// A user holds a handful of symbols, so flat vectors scanned by id beat any map.
 struct UserPortfolio {
     mutable std::shared_mutex mu;
-    std::unordered_map<std::string, Position> positions;
-    std::unordered_map<uint64_t, std::unordered_map<std::string, int>> account_positions;
-    std::vector<Trade> trades;
+    std::vector<Position> positions;
+    std::vector<Lot> lots;
+    TradeLog trades;
+    PortfolioTotals totals;
+    uint64_t version = 0;
+    uint64_t tick = 0;
+    std::vector<SymbolId> indexed;  // symbols whose holder list has this portfolio
 };
 
+// Positions are valued as trades happen and as ticks move held symbols: a
+// per-symbol holder index lets each tick revalue only the positions whose
+// quote changed, so reading a portfolio never touches the price engine.
+//
+// A trade moves cash and shares in one critical section: the position is
+// updated under the portfolio lock from inside BankService::settle_stock,
+// which holds the account owner's lock, so the two never disagree and a
+// failed trade has nothing to undo. A trade between two users holds both
+// owners' locks the same way.
+//
+// Registers a tick listener: construct before prices.start() and outlive
+// the engine's ticking.
 class StockService : public IStockService {
+    friend class LedgerAuditor;
+
 public:
     StockService(IBankService& bank, PriceEngine& prices);
 
-    std::optional<BuyResult>  buy(uint64_t user_id, const std::string& ticker,
+    // Called after a trade opens a user's position in a symbol or closes it,
+    // outside every lock; the handler reads the portfolio for the outcome.
+    // Register before trading starts.
+    void on_holding_change(std::function<void(uint64_t user_id, SymbolId symbol)> handler) {
+        holding_handlers_.push_back(std::move(handler));
+    }
+
+    std::optional<BuyResult>  buy(uint64_t user_id, SymbolId symbol,
                                   int quantity, uint64_t account_id) override;
-    std::optional<SellResult> sell(uint64_t user_id, const std::string& ticker,
+    std::optional<SellResult> sell(uint64_t user_id, SymbolId symbol,
                                    int quantity, uint64_t account_id) override;
 
+    // Resolve the ticker through the price engine's symbol table; unknown tickers fail.
+    std::optional<BuyResult>  buy(uint64_t user_id, std::string_view ticker, int quantity, uint64_t account_id);
+    std::optional<SellResult> sell(uint64_t user_id, std::string_view ticker, int quantity, uint64_t account_id);
+
+    // Trade at a fixed USD price instead of the current quote; the account
+    // currency still converts at the current rate. Order book fills against the
+    // simulated market settle here.
+    std::optional<BuyResult>  buy_at(uint64_t user_id, SymbolId symbol, int quantity,
+                                     uint64_t account_id, double usd_price);
+    std::optional<SellResult> sell_at(uint64_t user_id, SymbolId symbol, int quantity,
+                                      uint64_t account_id, double usd_price);
+
+    // Trade at `usd_price` as quoted on an earlier `tick`: the account
+    // currency converts at that tick's `usd_rates` (units of each Currency
+    // per USD, MarketSnapshot::rate(USD, c)) and the trade records `tick`.
+    // The TradeSequencer settles here with the tick queued ahead of a trade.
+    std::optional<BuyResult>  buy_on_tick(uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id,
+                                          double usd_price, uint64_t tick, const std::vector<double>& usd_rates);
+    std::optional<SellResult> sell_on_tick(uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id,
+                                           double usd_price, uint64_t tick, const std::vector<double>& usd_rates);
+
+    // A trade between two users at `usd_price`: the buyer's cash and the
+    // seller's shares move together through IBankService::settle_stock_pair,
+    // each side converting at the current rate into its account currency.
+    MatchResult settle_match(uint64_t buyer_id, uint64_t buyer_account, uint64_t seller_id,
+                             uint64_t seller_account, SymbolId symbol, int quantity, double usd_price);
+
     std::vector<Position> get_portfolio(uint64_t user_id) const override;
-    std::vector<Trade>    get_trades(uint64_t user_id) const override;
+    PortfolioSnapshot     get_portfolio_snapshot(uint64_t user_id) const override;
+    TradePage             get_trades(uint64_t user_id, const TradeQuery& query = {}) const override;
     bool has_open_positions_on_account(uint64_t user_id, uint64_t account_id) const override;
 
 private:
+    // Portfolios holding a symbol. Entries whose position has closed are
+    // dropped by the next tick that moves the symbol.
+    struct alignas(64) Holders {
+        std::mutex mu;
+        std::vector<std::shared_ptr<UserPortfolio>> portfolios;
+    };
+
+    void on_tick(const MarketSnapshot& snapshot);
+    // Settle at `price`; `at` supplies the mark, the rate and the tick.
+    std::optional<BuyResult>  buy_priced(uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id,
+                                         double price, const TickPrice& at);
+    std::optional<SellResult> sell_priced(uint64_t user_id, SymbolId symbol, int quantity, uint64_t account_id,
+                                          double price, const TickPrice& at);
+    void index(SymbolId symbol, const std::shared_ptr<UserPortfolio>& up);
+    void holding_changed(uint64_t user_id, SymbolId symbol) const;
+
     IBankService& bank_;
     PriceEngine& prices_;
     ConcurrentMap<uint64_t, std::shared_ptr<UserPortfolio>> users_;
+    const std::size_t symbols_;
+    std::unique_ptr<Holders[]> holders_;
+    std::vector<double> last_quotes_;  // engine thread only
+    std::vector<std::function<void(uint64_t, SymbolId)>> holding_handlers_;
 };
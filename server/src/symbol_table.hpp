@@ -0,0 +1,39 @@
+#pragma once
+#include "models.hpp"
+#include "concurrent_map.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ticker ⇄ dense SymbolId. Filled once when the universe is set up and
+// read-only afterwards, so lookups need no lock; everything past the
+// protocol boundary indexes arrays by id instead of hashing strings.
+class SymbolTable {
+public:
+    void reserve(std::size_t n) {
+        names_.reserve(n);
+        ids_.reserve(n);
+    }
+
+    SymbolId intern(std::string_view ticker) {
+        const auto hash = detail::hash_key<std::string>(ticker);
+        if (auto* id = ids_.find(ticker, hash)) return *id;
+        const auto id = static_cast<SymbolId>(names_.size());
+        names_.emplace_back(ticker);
+        *ids_.try_emplace(names_.back(), hash).first = id;
+        return id;
+    }
+
+    std::optional<SymbolId> find(std::string_view ticker) const {
+        auto* id = ids_.find(ticker, detail::hash_key<std::string>(ticker));
+        return id ? std::optional<SymbolId>(*id) : std::nullopt;
+    }
+
+    const std::string& name(SymbolId id) const { return names_[id]; }
+    std::size_t size() const { return names_.size(); }
+
+private:
+    std::vector<std::string> names_;
+    detail::FlatTable<std::string, SymbolId> ids_;
+};
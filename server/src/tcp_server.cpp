@@ -34,11 +34,13 @@ void TcpServer::run() {
             worker.join();
         }
     }
-}
 
-void TcpServer::stop() {
+    // Closed only once no handler can be re-arming it on another thread.
     boost::system::error_code ignored;
     acceptor_.close(ignored);
+}
+
+void TcpServer::stop() {
     io_context_.stop();
 }
 
@@ -29,7 +29,7 @@ void TcpSession::read_header() {
             if (length == 0 || length > kMaxFrameSize) {
                 auto response = nlohmann::json{{"status", "error"}, {"message", "Invalid frame size"}};
                 close_after_write_ = true;
-                enqueue_write(frame_json_payload(response.dump()));
+                enqueue_write(std::make_shared<const std::string>(frame_json_payload(response.dump())));
                 return;
             }
 
@@ -54,6 +54,7 @@ void TcpSession::read_body(std::uint32_t length) {
                 const std::string payload(body_.begin(), body_.end());
                 auto request = nlohmann::json::parse(payload);
                 response = dispatcher_.handle_message(request);
+                track_login(request, response);
             } catch (const std::exception& ex) {
                 response = {
                     {"status", "error"},
@@ -61,22 +62,76 @@ void TcpSession::read_body(std::uint32_t length) {
                 };
             }
 
-            enqueue_write(frame_json_payload(response.dump()));
+            enqueue_write(std::make_shared<const std::string>(frame_json_payload(response.dump())));
             read_header();
         }));
 }
 
-void TcpSession::enqueue_write(const std::string& framed_response) {
+void TcpSession::push(std::shared_ptr<const std::string> frame) {
     auto self = shared_from_this();
-    boost::asio::post(strand_, [this, self, framed_response] {
-        bool write_in_progress = !write_queue_.empty();
-        write_queue_.push_back(framed_response);
-        if (!write_in_progress) {
-            write_next();
+    boost::asio::post(strand_, [this, self, frame = std::move(frame)]() mutable {
+        if (write_queue_.size() >= kMaxQueuedFrames) {
+            return;
         }
+        append_write(std::move(frame));
     });
 }
 
+void TcpSession::track_login(const nlohmann::json& request, const nlohmann::json& response) {
+    auto type = request.find("type");
+    if (type == request.end() || !type->is_string()) {
+        return;
+    }
+    const auto& name = type->get_ref<const std::string&>();
+    if (response.value("status", "") != "ok") {
+        return;
+    }
+    if (name == "logout") {
+        // The dispatcher already dropped every session bound with the token
+        // from the registry; forget it here only if it was this session's.
+        auto token = request.find("token");
+        if (user_id_ && token != request.end() && token->is_string() && *token == token_) {
+            user_id_.reset();
+            token_.clear();
+        }
+        return;
+    }
+    if (name != "login") {
+        return;
+    }
+
+    auto token = response.at("token").get<std::string>();
+    auto user_id = dispatcher_.authenticate(token);
+    if (!user_id) {
+        return;
+    }
+    if (user_id_ && user_id_ != user_id) {
+        dispatcher_.sessions().unbind(*user_id_, this);
+    }
+    user_id_ = user_id;
+    token_ = token;
+    dispatcher_.sessions().bind(*user_id, std::move(token), shared_from_this());
+    // A logout elsewhere between the check above and the bind would miss us.
+    if (!dispatcher_.authenticate(token_)) {
+        dispatcher_.sessions().revoke(*user_id, token_);
+    }
+}
+
+void TcpSession::enqueue_write(std::shared_ptr<const std::string> frame) {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self, frame = std::move(frame)]() mutable {
+        append_write(std::move(frame));
+    });
+}
+
+void TcpSession::append_write(std::shared_ptr<const std::string> frame) {
+    bool write_in_progress = !write_queue_.empty();
+    write_queue_.push_back(std::move(frame));
+    if (!write_in_progress) {
+        write_next();
+    }
+}
+
 void TcpSession::write_next() {
     if (write_queue_.empty()) {
         return;
@@ -84,7 +139,7 @@ void TcpSession::write_next() {
 
     auto self = shared_from_this();
     boost::asio::async_write(
-        socket_, boost::asio::buffer(write_queue_.front()),
+        socket_, boost::asio::buffer(*write_queue_.front()),
         boost::asio::bind_executor(strand_, [this, self](const boost::system::error_code& ec, std::size_t) {
             if (ec) {
                 close();
@@ -104,6 +159,10 @@ void TcpSession::write_next() {
 }
 
 void TcpSession::close() {
+    if (user_id_) {
+        dispatcher_.sessions().unbind(*user_id_, this);
+        user_id_.reset();
+    }
     boost::system::error_code ignored;
     socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored);
     socket_.close(ignored);
@@ -5,9 +5,11 @@
 #include <boost/asio.hpp>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -17,13 +19,27 @@ public:
 
     void start();
 
+    // A session that stops reading holds at most this many frames; further
+    // notifications to it are dropped, responses never are.
+    static constexpr std::size_t kMaxQueuedFrames = 1024;
+
+    // Queues an already framed notification; safe from any thread and never
+    // blocks the caller. The buffer is shared, so one serialization can fan
+    // out to many sessions.
+    void push(std::shared_ptr<const std::string> frame);
+
 private:
     void read_header();
     void read_body(std::uint32_t length);
 
-    void enqueue_write(const std::string& framed_response);
+    void enqueue_write(std::shared_ptr<const std::string> frame);
+    void append_write(std::shared_ptr<const std::string> frame);  // on the strand
     void write_next();
 
+    // Binds this session to its user on a successful login; forgets the
+    // binding when its own token is logged out.
+    void track_login(const nlohmann::json& request, const nlohmann::json& response);
+
     void close();
 
     boost::asio::ip::tcp::socket socket_;
@@ -32,6 +48,8 @@ private:
 
     std::array<std::uint8_t, 4> header_{};
     std::vector<char> body_;
-    std::deque<std::string> write_queue_;
+    std::deque<std::shared_ptr<const std::string>> write_queue_;
     bool close_after_write_ = false;
+    std::optional<std::uint64_t> user_id_;  // bound in the session registry
+    std::string token_;                     // the token user_id_ was bound with
 };
@@ -0,0 +1,382 @@
+#include "tick_file.hpp"
+#include "universe.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[4] = {'Y', 'C', 'T', 'K'};
+constexpr uint32_t kVersion = 1;
+
+class BitWriter {
+public:
+    // Appends the low `bits` bits of value, most significant first.
+    void write(uint64_t value, unsigned bits) {
+        while (bits > 0) {
+            if (used_ == 0) bytes_.push_back(0);
+            const unsigned room = 8 - used_;
+            const unsigned take = std::min(room, bits);
+            const auto chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+            bytes_.back() |= static_cast<uint8_t>(chunk << (room - take));
+            used_ = (used_ + take) & 7;
+            bits -= take;
+        }
+    }
+
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+    void clear() {
+        bytes_.clear();
+        used_ = 0;
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+    unsigned used_ = 0;  // bits taken in the last byte
+};
+
+class BitReader {
+public:
+    void reset(const uint8_t* data, std::size_t size) {
+        data_ = data;
+        bits_ = size * 8;
+        pos_ = 0;
+        overrun_ = false;
+    }
+
+    uint64_t read(unsigned bits) {
+        uint64_t out = 0;
+        while (bits > 0) {
+            if (pos_ >= bits_) {
+                overrun_ = true;
+                return 0;
+            }
+            const unsigned room = 8 - static_cast<unsigned>(pos_ & 7);
+            const unsigned take = std::min(room, bits);
+            const uint8_t byte = data_[pos_ >> 3];
+            out = (out << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+            pos_ += take;
+            bits -= take;
+        }
+        return out;
+    }
+
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    std::size_t bits_ = 0;
+    std::size_t pos_ = 0;
+    bool overrun_ = false;
+};
+
+int64_t sign_extend(uint64_t value, unsigned bits) {
+    const uint64_t sign = uint64_t{1} << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+// Delta-of-delta buckets: '0' for an unchanged step, then widening
+// prefixed ranges, then a raw 64-bit escape.
+struct DodBucket {
+    uint64_t prefix;
+    unsigned prefix_bits;
+    unsigned value_bits;
+};
+constexpr DodBucket kDodBuckets[] = {{0b10, 2, 7}, {0b110, 3, 9}, {0b1110, 4, 12}, {0b1111, 4, 64}};
+
+struct DodCoder {
+    int64_t prev = 0;
+    int64_t prev_delta = 0;
+    bool started = false;
+
+    void encode(BitWriter& out, int64_t value) {
+        if (!started) {
+            out.write(static_cast<uint64_t>(value), 64);
+            started = true;
+        } else {
+            const int64_t delta = value - prev;
+            const int64_t dod = delta - prev_delta;
+            prev_delta = delta;
+            if (dod == 0) {
+                out.write(0, 1);
+            } else {
+                for (const auto& b : kDodBuckets) {
+                    const int64_t limit = b.value_bits == 64 ? INT64_MAX : (int64_t{1} << (b.value_bits - 1));
+                    if (b.value_bits == 64 || (dod >= -limit && dod < limit)) {
+                        out.write(b.prefix, b.prefix_bits);
+                        out.write(static_cast<uint64_t>(dod), b.value_bits);
+                        break;
+                    }
+                }
+            }
+        }
+        prev = value;
+    }
+
+    int64_t decode(BitReader& in) {
+        if (!started) {
+            started = true;
+            return prev = static_cast<int64_t>(in.read(64));
+        }
+        int64_t dod = 0;
+        if (in.read(1)) {
+            unsigned ones = 1;
+            while (ones < 4 && in.read(1)) ones++;
+            const unsigned bits = kDodBuckets[ones - 1].value_bits;
+            dod = bits == 64 ? static_cast<int64_t>(in.read(64)) : sign_extend(in.read(bits), bits);
+        }
+        prev_delta += dod;
+        return prev += prev_delta;
+    }
+};
+
+// Gorilla XOR coding: '0' if the value repeats; else '1' and either '0' plus
+// the bits inside the previous leading/trailing-zero window, or '1', a new
+// window (5-bit leading zeros, 6-bit length - 1) and the bits inside it.
+struct XorCoder {
+    uint64_t prev = 0;
+    unsigned lead = 0;
+    unsigned trail = 0;
+    bool started = false;
+    bool windowed = false;
+
+    static uint64_t bits_of(double v) {
+        uint64_t b;
+        std::memcpy(&b, &v, sizeof b);
+        return b;
+    }
+    static double value_of(uint64_t b) {
+        double v;
+        std::memcpy(&v, &b, sizeof v);
+        return v;
+    }
+
+    void encode(BitWriter& out, double value) {
+        const uint64_t bits = bits_of(value);
+        if (!started) {
+            out.write(bits, 64);
+            started = true;
+            prev = bits;
+            return;
+        }
+        const uint64_t x = bits ^ prev;
+        prev = bits;
+        if (x == 0) {
+            out.write(0, 1);
+            return;
+        }
+        out.write(1, 1);
+        const auto l = std::min(31u, static_cast<unsigned>(__builtin_clzll(x)));
+        const auto t = static_cast<unsigned>(__builtin_ctzll(x));
+        if (windowed && l >= lead && t >= trail) {
+            out.write(0, 1);
+            out.write(x >> trail, 64 - lead - trail);
+            return;
+        }
+        lead = l;
+        trail = t;
+        windowed = true;
+        const unsigned meaningful = 64 - lead - trail;
+        out.write(1, 1);
+        out.write(lead, 5);
+        out.write(meaningful - 1, 6);
+        out.write(x >> trail, meaningful);
+    }
+
+    double decode(BitReader& in) {
+        if (!started) {
+            started = true;
+            prev = in.read(64);
+            return value_of(prev);
+        }
+        if (in.read(1)) {
+            if (in.read(1)) {
+                lead = static_cast<unsigned>(in.read(5));
+                trail = 64 - lead - (static_cast<unsigned>(in.read(6)) + 1);
+                windowed = true;
+            }
+            prev ^= in.read(64 - lead - trail) << trail;
+        }
+        return value_of(prev);
+    }
+};
+
+void put_u32(std::ostream& out, uint32_t v) {
+    const char b[4] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+    out.write(b, 4);
+}
+
+bool get_u32(std::istream& in, uint32_t& v) {
+    unsigned char b[4];
+    if (!in.read(reinterpret_cast<char*>(b), 4)) return false;
+    v = b[0] | (uint32_t{b[1]} << 8) | (uint32_t{b[2]} << 16) | (uint32_t{b[3]} << 24);
+    return true;
+}
+
+void put_names(std::ostream& out, const std::vector<std::string>& names) {
+    put_u32(out, static_cast<uint32_t>(names.size()));
+    for (const auto& name : names) {
+        const auto len = static_cast<uint16_t>(name.size());
+        const char b[2] = {char(len), char(len >> 8)};
+        out.write(b, 2);
+        out.write(name.data(), len);
+    }
+}
+
+bool get_names(std::istream& in, std::vector<std::string>& names) {
+    uint32_t n;
+    if (!get_u32(in, n) || n > (1u << 24)) return false;
+    names.resize(n);
+    for (auto& name : names) {
+        unsigned char b[2];
+        if (!in.read(reinterpret_cast<char*>(b), 2)) return false;
+        name.resize(b[0] | (b[1] << 8));
+        if (!in.read(name.data(), static_cast<std::streamsize>(name.size()))) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+struct TickWriter::Encoder {
+    Encoder(std::size_t series) : values(series) {}
+
+    BitWriter bits;
+    DodCoder time;
+    DodCoder tick;
+    std::vector<XorCoder> values;
+    uint32_t frames = 0;
+};
+
+struct TickReader::Decoder {
+    Decoder(std::size_t series) : values(series) {}
+
+    std::vector<uint8_t> bytes;
+    BitReader bits;
+    DodCoder time;
+    DodCoder tick;
+    std::vector<XorCoder> values;
+    uint32_t frames_left = 0;
+};
+
+std::unique_ptr<TickWriter> TickWriter::create(const std::string& path,
+                                               std::vector<std::string> tickers,
+                                               std::vector<std::string> currencies,
+                                               std::string& error,
+                                               uint32_t frames_per_block) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot create " + path;
+        return nullptr;
+    }
+    out.write(kMagic, sizeof kMagic);
+    put_u32(out, kVersion);
+    put_names(out, tickers);
+    put_names(out, currencies);
+    return std::unique_ptr<TickWriter>(new TickWriter(std::move(out), std::move(tickers),
+                                                      std::move(currencies), std::max(1u, frames_per_block)));
+}
+
+TickWriter::TickWriter(std::ofstream out, std::vector<std::string> tickers,
+                       std::vector<std::string> currencies, uint32_t frames_per_block)
+    : out_(std::move(out)),
+      tickers_(std::move(tickers)),
+      currencies_(std::move(currencies)),
+      frames_per_block_(frames_per_block),
+      block_(std::make_unique<Encoder>(tickers_.size() + currencies_.size())) {}
+
+TickWriter::~TickWriter() { flush(); }
+
+void TickWriter::append(uint64_t tick, int64_t time_us, const double* quotes, const double* usd_rates) {
+    auto& b = *block_;
+    b.time.encode(b.bits, time_us);
+    b.tick.encode(b.bits, static_cast<int64_t>(tick));
+    const std::size_t n = tickers_.size();
+    for (std::size_t i = 0; i < n; ++i) b.values[i].encode(b.bits, quotes[i]);
+    for (std::size_t i = 0; i < currencies_.size(); ++i) b.values[n + i].encode(b.bits, usd_rates[i]);
+    if (++b.frames == frames_per_block_) flush();
+}
+
+void TickWriter::flush() {
+    if (block_->frames > 0) {
+        const auto& bytes = block_->bits.bytes();
+        put_u32(out_, block_->frames);
+        put_u32(out_, static_cast<uint32_t>(bytes.size()));
+        out_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        block_ = std::make_unique<Encoder>(tickers_.size() + currencies_.size());
+    }
+    out_.flush();
+}
+
+std::unique_ptr<TickReader> TickReader::open(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    char magic[sizeof kMagic];
+    uint32_t version = 0;
+    std::vector<std::string> tickers, currencies;
+    if (!in.read(magic, sizeof magic) || std::memcmp(magic, kMagic, sizeof magic) != 0 ||
+        !get_u32(in, version) || version != kVersion ||
+        !get_names(in, tickers) || !get_names(in, currencies)) {
+        error = path + ": not a tick file";
+        return nullptr;
+    }
+    return std::unique_ptr<TickReader>(new TickReader(std::move(in), std::move(tickers), std::move(currencies)));
+}
+
+TickReader::TickReader(std::ifstream in, std::vector<std::string> tickers, std::vector<std::string> currencies)
+    : in_(std::move(in)),
+      tickers_(std::move(tickers)),
+      currencies_(std::move(currencies)),
+      block_(std::make_unique<Decoder>(tickers_.size() + currencies_.size())) {}
+
+TickReader::~TickReader() = default;
+
+Universe TickReader::universe() const {
+    Universe u;
+    for (const auto& code : currencies_) u.currencies.push_back({code, 0.0, 0.0});
+    for (const auto& ticker : tickers_) u.instruments.push_back({ticker, 0.0, 0.0});
+    return u;
+}
+
+bool TickReader::load_block() {
+    uint32_t frames = 0, size = 0;
+    if (!get_u32(in_, frames)) {
+        truncated_ = in_.gcount() != 0;  // clean EOF only between blocks
+        return false;
+    }
+    auto fresh = std::make_unique<Decoder>(tickers_.size() + currencies_.size());
+    if (frames == 0 || !get_u32(in_, size)) {
+        truncated_ = true;
+        return false;
+    }
+    fresh->bytes.resize(size);
+    if (!in_.read(reinterpret_cast<char*>(fresh->bytes.data()), size)) {
+        truncated_ = true;
+        return false;
+    }
+    fresh->bits.reset(fresh->bytes.data(), fresh->bytes.size());
+    fresh->frames_left = frames;
+    block_ = std::move(fresh);
+    return true;
+}
+
+bool TickReader::next(TickFrame& frame) {
+    if (truncated_) return false;
+    if (block_->frames_left == 0 && !load_block()) return false;
+    auto& b = *block_;
+    frame.time_us = b.time.decode(b.bits);
+    frame.tick = static_cast<uint64_t>(b.tick.decode(b.bits));
+    const std::size_t n = tickers_.size();
+    frame.quotes.resize(n);
+    frame.usd_rates.resize(currencies_.size());
+    for (std::size_t i = 0; i < n; ++i) frame.quotes[i] = b.values[i].decode(b.bits);
+    for (std::size_t i = 0; i < currencies_.size(); ++i) frame.usd_rates[i] = b.values[n + i].decode(b.bits);
+    if (b.bits.overrun()) {
+        truncated_ = true;
+        return false;
+    }
+    b.frames_left--;
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Universe;
+
+// One recorded tick: every quote and every USD rate of a MarketSnapshot.
+struct TickFrame {
+    uint64_t tick = 0;
+    int64_t time_us = 0;             // system clock, microseconds since the epoch
+    std::vector<double> quotes;      // by SymbolId
+    std::vector<double> usd_rates;   // by column of TickReader::currencies()
+};
+
+// Compressed tick file, Gorilla style. A header names the series; then
+// come blocks of frames. Inside a block, the timestamp and tick number are
+// delta-of-delta coded. Each quote and rate is XOR-coded against its value
+// in the previous frame. Every block restarts the coders, so a file cut off
+// mid-write still decodes up to its last complete block.
+//
+//   header: "YCTK" u32 version, u32 n + n × (u16 len, bytes) tickers, same for currencies
+//   block:  u32 frames, u32 bytes, bit stream
+//
+// Integers are little-endian.
+class TickWriter {
+public:
+    static constexpr uint32_t kDefaultFramesPerBlock = 512;
+
+    // nullptr with `error` set if the file cannot be created.
+    static std::unique_ptr<TickWriter> create(const std::string& path,
+                                              std::vector<std::string> tickers,
+                                              std::vector<std::string> currencies,
+                                              std::string& error,
+                                              uint32_t frames_per_block = kDefaultFramesPerBlock);
+    ~TickWriter();
+
+    TickWriter(const TickWriter&) = delete;
+    TickWriter& operator=(const TickWriter&) = delete;
+
+    // `quotes` and `usd_rates` hold one value per ticker / currency column.
+    void append(uint64_t tick, int64_t time_us, const double* quotes, const double* usd_rates);
+    // Writes the open block, so everything appended so far is readable.
+    void flush();
+
+    std::size_t tickers() const { return tickers_.size(); }
+    std::size_t currencies() const { return currencies_.size(); }
+
+private:
+    struct Encoder;
+
+    TickWriter(std::ofstream out, std::vector<std::string> tickers,
+               std::vector<std::string> currencies, uint32_t frames_per_block);
+
+    std::ofstream out_;
+    std::vector<std::string> tickers_;
+    std::vector<std::string> currencies_;
+    const uint32_t frames_per_block_;
+    std::unique_ptr<Encoder> block_;
+};
+
+class TickReader {
+public:
+    // nullptr with `error` set if the file is missing or has a bad header.
+    static std::unique_ptr<TickReader> open(const std::string& path, std::string& error);
+    ~TickReader();
+
+    TickReader(const TickReader&) = delete;
+    TickReader& operator=(const TickReader&) = delete;
+
+    const std::vector<std::string>& tickers() const { return tickers_; }
+    const std::vector<std::string>& currencies() const { return currencies_; }
+
+    // The recorded series as a Universe. Prices and rates are zero until a
+    // frame is read; PriceEngine takes them from the first frame.
+    Universe universe() const;
+
+    // Decodes the next frame; false at the end of the file.
+    bool next(TickFrame& frame);
+    // True if next() stopped at an incomplete or corrupt block.
+    bool truncated() const { return truncated_; }
+
+private:
+    struct Decoder;
+
+    TickReader(std::ifstream in, std::vector<std::string> tickers, std::vector<std::string> currencies);
+    bool load_block();
+
+    std::ifstream in_;
+    std::vector<std::string> tickers_;
+    std::vector<std::string> currencies_;
+    std::unique_ptr<Decoder> block_;
+    bool truncated_ = false;
+};
@@ -0,0 +1,79 @@
+#include "trade_log.hpp"
+#include <algorithm>
+
+namespace {
+
+int64_t to_micros(TimePoint t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+}  // namespace
+
+void TradeLog::append(const Trade& trade) {
+    const int64_t t = to_micros(trade.timestamp);
+    const auto row = static_cast<uint32_t>(times_.size());
+    times_.push_back(times_.empty() ? t : std::max(t, times_.back()));
+    symbols_.push_back(trade.symbol);
+    buys_.push_back(trade.is_buy);
+    quantities_.push_back(trade.quantity);
+    prices_.push_back(trade.price);
+    ticks_.push_back(trade.tick);
+
+    auto it = std::find_if(by_symbol_.begin(), by_symbol_.end(),
+                           [&](const SymbolRows& entry) { return entry.symbol == trade.symbol; });
+    if (it == by_symbol_.end()) it = by_symbol_.insert(by_symbol_.end(), SymbolRows{trade.symbol, {}, {}});
+    it->rows.push_back(row);
+    it->side_rows[trade.is_buy].push_back(row);
+    side_rows_[trade.is_buy].push_back(row);
+}
+
+Trade TradeLog::at(std::size_t row) const {
+    return Trade{TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::microseconds(times_[row]))),
+                 symbols_[row], buys_[row] != 0, quantities_[row], prices_[row], ticks_[row]};
+}
+
+const TradeLog::SymbolRows* TradeLog::rows_of(SymbolId symbol) const {
+    for (const auto& entry : by_symbol_)
+        if (entry.symbol == symbol) return &entry;
+    return nullptr;
+}
+
+TradePage TradeLog::query(const TradeQuery& q) const {
+    TradePage page;
+    std::size_t lo = 0, hi = times_.size();
+    if (q.before) hi = std::min<std::size_t>(hi, *q.before);
+    if (q.from) lo = std::lower_bound(times_.begin(), times_.end(), to_micros(*q.from)) - times_.begin();
+    if (q.until) hi = std::min<std::size_t>(
+        hi, std::lower_bound(times_.begin(), times_.end(), to_micros(*q.until)) - times_.begin());
+    if (lo >= hi || q.limit == 0) return page;
+
+    auto take = [&](std::size_t row) {
+        page.trades.push_back(at(row));
+        page.next_cursor = row;
+    };
+
+    bool exhausted;
+    const std::vector<uint32_t>* rows = nullptr;
+    if (q.symbol) {
+        const auto* entry = rows_of(*q.symbol);
+        if (!entry) return page;
+        rows = q.is_buy ? &entry->side_rows[*q.is_buy] : &entry->rows;
+    } else if (q.is_buy) {
+        rows = &side_rows_[*q.is_buy];
+    }
+    if (rows) {
+        // Walk only the matching rows inside [lo, hi), newest first.
+        auto first = std::lower_bound(rows->begin(), rows->end(), static_cast<uint32_t>(lo));
+        auto it = std::lower_bound(first, rows->end(), static_cast<uint32_t>(hi));
+        while (it != first && page.trades.size() < q.limit) take(*--it);
+        exhausted = it == first;
+    } else {
+        std::size_t row = hi;
+        while (row > lo && page.trades.size() < q.limit) take(--row);
+        exhausted = row == lo;
+    }
+
+    if (exhausted) page.next_cursor.reset();
+    std::reverse(page.trades.begin(), page.trades.end());
+    return page;
+}
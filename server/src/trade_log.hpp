@@ -0,0 +1,62 @@
+#pragma once
+#include "models.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Which trades get_trades returns. Every filter is optional; `from` is
+// inclusive and `until` exclusive.
+struct TradeQuery {
+    std::optional<SymbolId> symbol;
+    std::optional<bool> is_buy;
+    std::optional<TimePoint> from;
+    std::optional<TimePoint> until;
+    std::optional<uint64_t> before;  // cursor: only trades older than this one
+    std::size_t limit = std::numeric_limits<std::size_t>::max();
+};
+
+struct TradePage {
+    std::vector<Trade> trades;  // oldest first
+    // Pass back as `before` for the next older page; unset once the range
+    // is exhausted. The last page may come back empty.
+    std::optional<uint64_t> next_cursor;
+};
+
+// One user's trades in time order, one column per field, so a query reads
+// only the columns it filters on. The date range is found by binary search
+// on the time column, and a ticker or side filter walks a row list holding
+// exactly the matching rows, so a page costs about its own size however long
+// the history is. A trade's cursor is its row number.
+class TradeLog {
+public:
+    // Timestamps are clamped to be non-decreasing.
+    void append(const Trade& trade);
+
+    std::size_t size() const { return times_.size(); }
+    Trade at(std::size_t row) const;
+
+    // The newest `limit` matches older than the cursor.
+    TradePage query(const TradeQuery& q) const;
+
+private:
+    // Rows matching one filter, ascending; sides index by is_buy.
+    struct SymbolRows {
+        SymbolId symbol;
+        std::vector<uint32_t> rows;
+        std::vector<uint32_t> side_rows[2];
+    };
+
+    const SymbolRows* rows_of(SymbolId symbol) const;
+
+    std::vector<int64_t> times_;  // µs since epoch
+    std::vector<SymbolId> symbols_;
+    std::vector<uint8_t> buys_;
+    std::vector<int32_t> quantities_;
+    std::vector<double> prices_;
+    std::vector<uint64_t> ticks_;
+    // A user trades a handful of symbols, so a flat vector beats a map.
+    std::vector<SymbolRows> by_symbol_;
+    std::vector<uint32_t> side_rows_[2];
+};
@@ -0,0 +1,181 @@
+#include "trade_sequencer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+namespace {
+
+constexpr std::size_t kDrainBatch = 64;  // entries per lane before moving on
+constexpr int kIdleSpins = 64;
+
+// What MarketSnapshot::rate(USD, c) gives for each currency on this tick.
+std::shared_ptr<const std::vector<double>> usd_rates_of(const MarketSnapshot& s) {
+    std::vector<double> rates(s.usd_rates.size());
+    for (std::size_t c = 0; c < rates.size(); ++c) rates[c] = s.rate(Currency::USD, static_cast<Currency>(c));
+    return std::make_shared<const std::vector<double>>(std::move(rates));
+}
+
+}  // namespace
+
+TradeSequencer::TradeSequencer(StockService& stock, PriceEngine& prices, std::size_t threads,
+                               std::size_t queue_capacity)
+    : stock_(stock),
+      prices_(prices),
+      symbols_(prices.symbols().size()),
+      threads_(std::max<std::size_t>(threads, 1)),
+      workers_(new Worker[std::max<std::size_t>(threads, 1)]) {
+    lanes_.reserve(symbols_);
+    for (SymbolId symbol = 0; symbol < symbols_; ++symbol) {
+        lanes_.push_back(std::make_unique<Lane>(queue_capacity));
+        worker_of(symbol).lanes.push_back(symbol);
+    }
+    prices.on_tick([this](const MarketSnapshot& snapshot) { post_tick(snapshot); });
+}
+
+TradeSequencer::~TradeSequencer() { stop(); }
+
+void TradeSequencer::start() {
+    if (running_.load()) return;
+    // Lanes start from the current tick; later ones arrive through the queues.
+    prices_.read([&](const MarketSnapshot& s) {
+        const auto rates = usd_rates_of(s);
+        for (SymbolId symbol = 0; symbol < symbols_; ++symbol) {
+            lanes_[symbol]->tick = s.tick;
+            lanes_[symbol]->quote = s.quote(symbol);
+            lanes_[symbol]->usd_rates = rates;
+        }
+    });
+    running_.store(true);
+    for (std::size_t i = 0; i < threads_; ++i)
+        workers_[i].thread = std::thread([this, i] { run(workers_[i]); });
+}
+
+void TradeSequencer::stop() {
+    if (!running_.exchange(false)) return;
+    // Producers that saw the sequencer running finish their push while the
+    // workers still drain (run() keeps going until producers_ reaches zero),
+    // so a full queue cannot wedge them.
+    while (producers_.load() > 0) std::this_thread::yield();
+    for (std::size_t i = 0; i < threads_; ++i) {
+        wake(workers_[i]);
+        if (workers_[i].thread.joinable()) workers_[i].thread.join();
+    }
+    // Nothing can be queued any more; run what is left on this thread.
+    for (SymbolId symbol = 0; symbol < symbols_; ++symbol) {
+        while (drain(symbol)) {
+        }
+    }
+}
+
+void TradeSequencer::wake(Worker& w) {
+    // Pairs with the fence in run(): either the worker sees the new entry
+    // before sleeping or this sees it asleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!w.sleeping.load(std::memory_order_relaxed)) return;
+    std::lock_guard lk(w.mu);
+    w.cv.notify_one();
+}
+
+bool TradeSequencer::submit(const TradeRequest& request, Completion done) {
+    if (request.symbol >= symbols_ || request.quantity <= 0) return false;
+    producers_.fetch_add(1);
+    bool queued = false;
+    if (running_.load()) {
+        Entry entry;
+        entry.request = request;
+        entry.done = std::move(done);
+        queued = lanes_[request.symbol]->queue.try_push(std::move(entry));
+    }
+    producers_.fetch_sub(1);
+    if (queued) wake(worker_of(request.symbol));
+    return queued;
+}
+
+std::optional<TradeOutcome> TradeSequencer::execute(const TradeRequest& request) {
+    std::promise<TradeOutcome> promise;
+    auto outcome = promise.get_future();
+    if (!submit(request, [&promise](const TradeOutcome& out) { promise.set_value(out); })) return std::nullopt;
+    return outcome.get();
+}
+
+void TradeSequencer::post_tick(const MarketSnapshot& snapshot) {
+    producers_.fetch_add(1);
+    if (!running_.load()) {
+        producers_.fetch_sub(1);
+        return;
+    }
+    const std::size_t n = std::min(symbols_, snapshot.quotes.size());
+    const auto rates = usd_rates_of(snapshot);
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        Entry entry;
+        entry.is_tick = true;
+        entry.tick = snapshot.tick;
+        entry.quote = snapshot.quotes[symbol];
+        entry.usd_rates = rates;
+        // Dropping a tick would let trades behind it execute at a stale
+        // quote, so a full queue holds the engine until the sequencer catches up.
+        auto& queue = lanes_[symbol]->queue;
+        while (!queue.try_push(std::move(entry))) {
+            wake(worker_of(symbol));
+            std::this_thread::yield();
+        }
+    }
+    producers_.fetch_sub(1);
+    for (std::size_t i = 0; i < threads_; ++i) wake(workers_[i]);
+}
+
+bool TradeSequencer::drain(SymbolId symbol) {
+    Lane& lane = *lanes_[symbol];
+    Entry entry;
+    std::size_t n = 0;
+    for (; n < kDrainBatch && lane.queue.try_pop(entry); ++n) {
+        if (entry.is_tick) {
+            lane.tick = entry.tick;
+            lane.quote = entry.quote;
+            lane.usd_rates = std::move(entry.usd_rates);
+            continue;
+        }
+        const auto& r = entry.request;
+        TradeOutcome out{++lane.sequence, lane.tick, std::nullopt, std::nullopt};
+        if (r.is_buy)
+            out.bought = stock_.buy_on_tick(r.user_id, symbol, r.quantity, r.account_id, lane.quote, lane.tick,
+                                            *lane.usd_rates);
+        else
+            out.sold = stock_.sell_on_tick(r.user_id, symbol, r.quantity, r.account_id, lane.quote, lane.tick,
+                                           *lane.usd_rates);
+        if (entry.done) entry.done(out);
+        entry.done = nullptr;
+    }
+    return n > 0;
+}
+
+bool TradeSequencer::drain_all(Worker& w) {
+    bool any = false;
+    for (SymbolId symbol : w.lanes) any = drain(symbol) || any;
+    return any;
+}
+
+void TradeSequencer::run(Worker& w) {
+    int idle = 0;
+    // A producer that saw the sequencer running may still be pushing into a
+    // full lane after stop(); keep draining until it is done.
+    while (running_.load(std::memory_order_relaxed) || producers_.load() > 0) {
+        if (drain_all(w)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock lk(w.mu);
+        w.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool pending = std::any_of(w.lanes.begin(), w.lanes.end(),
+                                         [&](SymbolId s) { return !lanes_[s]->queue.empty(); });
+        if (!pending && running_.load(std::memory_order_relaxed))
+            w.cv.wait_for(lk, std::chrono::milliseconds(10));
+        w.sleeping.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
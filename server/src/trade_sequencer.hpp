@@ -0,0 +1,114 @@
+#pragma once
+#include "mpsc_ring.hpp"
+#include "price_engine.hpp"
+#include "stock_service.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct TradeRequest {
+    uint64_t user_id;
+    uint64_t account_id;
+    SymbolId symbol;
+    int quantity;
+    bool is_buy;
+};
+
+struct TradeOutcome {
+    uint64_t sequence;  // position in the symbol's execution order, from 1
+    uint64_t tick;      // tick whose quote the trade executed at
+    std::optional<BuyResult> bought;
+    std::optional<SellResult> sold;
+
+    bool ok() const { return bought || sold; }
+};
+
+// Optional execution mode for market trades. Each symbol has a lock-free
+// queue that any thread submits to, drained by exactly one sequencer thread
+// (symbols are spread over `threads` of them), so trades in one symbol run
+// one at a time in arrival order. Ticks are queued too: the engine posts
+// each new quote into every symbol's queue, and a trade executes at the
+// quote of the last tick queued ahead of it, converts at that tick's rates
+// and is recorded as that tick. Trade order relative to ticks is therefore
+// fixed at submission, not by which thread wins a lock.
+//
+// Trades still settle through StockService, whose per-user locks guard cash
+// that spans symbols; within a symbol they are never contended.
+//
+// Must be constructed before prices.start() and outlive the engine's ticking.
+class TradeSequencer {
+public:
+    static constexpr std::size_t kDefaultQueueCapacity = 4096;
+
+    using Completion = std::function<void(const TradeOutcome&)>;
+
+    TradeSequencer(StockService& stock, PriceEngine& prices, std::size_t threads = 1,
+                   std::size_t queue_capacity = kDefaultQueueCapacity);
+    ~TradeSequencer();
+
+    TradeSequencer(const TradeSequencer&) = delete;
+    TradeSequencer& operator=(const TradeSequencer&) = delete;
+
+    void start();
+    // Executes everything already queued, then joins the threads.
+    void stop();
+
+    // Queues a trade; `done` runs on the sequencer thread once it executed.
+    // False for an unknown symbol, a non-positive quantity, a full queue or
+    // a stopped sequencer.
+    bool submit(const TradeRequest& request, Completion done);
+
+    // Submits and waits for the outcome; nullopt if it could not be queued.
+    std::optional<TradeOutcome> execute(const TradeRequest& request);
+
+private:
+    struct Entry {
+        bool is_tick = false;
+        TradeRequest request{};
+        uint64_t tick = 0;
+        double quote = 0.0;
+        std::shared_ptr<const std::vector<double>> usd_rates;  // one per tick, shared by every lane
+        Completion done;
+    };
+
+    // One symbol's queue and the state only its sequencer thread touches.
+    struct alignas(64) Lane {
+        explicit Lane(std::size_t capacity) : queue(capacity) {}
+        MpscRing<Entry> queue;
+        uint64_t sequence = 0;
+        uint64_t tick = 0;
+        double quote = 0.0;
+        std::shared_ptr<const std::vector<double>> usd_rates;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mu;
+        std::condition_variable cv;
+        std::atomic<bool> sleeping{false};
+        std::vector<SymbolId> lanes;
+    };
+
+    Worker& worker_of(SymbolId symbol) { return workers_[symbol % threads_]; }
+    void wake(Worker& w);
+    void post_tick(const MarketSnapshot& snapshot);  // engine thread
+    bool drain(SymbolId symbol);
+    bool drain_all(Worker& w);
+    void run(Worker& w);
+
+    StockService& stock_;
+    const PriceEngine& prices_;
+    const std::size_t symbols_;
+    const std::size_t threads_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::unique_ptr<Worker[]> workers_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> producers_{0};  // submit() and post_tick() calls in flight
+};
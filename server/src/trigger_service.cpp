@@ -0,0 +1,88 @@
+#include "trigger_service.hpp"
+#include <algorithm>
+
+namespace {
+
+// Stop-losses fire on a falling quote, like bids; take-profits on a rising one, like asks.
+Side side_of(TriggerKind kind) { return kind == TriggerKind::StopLoss ? Side::Buy : Side::Sell; }
+
+TriggerKind kind_of(Side side) { return side == Side::Buy ? TriggerKind::StopLoss : TriggerKind::TakeProfit; }
+
+}  // namespace
+
+void TriggerService::Book::publish_bounds() {
+    highest_stop.store(book.best_bid().value_or(INT64_MIN), std::memory_order_relaxed);
+    lowest_take.store(book.best_ask().value_or(INT64_MAX), std::memory_order_relaxed);
+}
+
+TriggerService::TriggerService(IBankService& bank, StockService& stock, PriceEngine& prices)
+    : bank_(bank),
+      stock_(stock),
+      symbols_(prices.symbols().size()),
+      books_(new Book[prices.symbols().size()]) {
+    prices.on_tick([this](const MarketSnapshot& snapshot) { on_tick(snapshot); });
+}
+
+std::optional<uint64_t> TriggerService::arm(uint64_t user_id, SymbolId symbol, TriggerKind kind,
+                                            double trigger_price, int quantity, uint64_t account_id) {
+    const auto ticks = to_ticks(trigger_price);
+    if (symbol >= symbols_ || !ticks || quantity <= 0) return std::nullopt;
+    auto acc = bank_.get_account_summary(account_id);
+    if (!acc || acc->user_id != user_id) return std::nullopt;
+
+    const uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    auto& b = books_[symbol];
+    std::lock_guard lk(b.mu);
+    const auto handle = b.book.queue(side_of(kind), *ticks, quantity, id);
+    if (handle == kNoOrder) return std::nullopt;
+    triggers_.put(id, {user_id, account_id, symbol, *ticks, handle});
+    armed_.fetch_add(1, std::memory_order_relaxed);
+    b.publish_bounds();
+    return id;
+}
+
+bool TriggerService::cancel(uint64_t user_id, uint64_t trigger_id) {
+    auto info = triggers_.get(trigger_id);
+    if (!info || info->user_id != user_id) return false;
+    auto& b = books_[info->symbol];
+    std::lock_guard lk(b.mu);
+    if (!b.book.cancel(info->handle)) return false;  // fired meanwhile
+    triggers_.erase(trigger_id);
+    armed_.fetch_sub(1, std::memory_order_relaxed);
+    b.publish_bounds();
+    return true;
+}
+
+void TriggerService::on_tick(const MarketSnapshot& snapshot) {
+    const std::size_t n = std::min(symbols_, snapshot.quotes.size());
+    for (SymbolId symbol = 0; symbol < n; ++symbol) {
+        const auto ticks = to_ticks(snapshot.quotes[symbol]);
+        if (!ticks) continue;
+        auto& b = books_[symbol];
+        if (b.highest_stop.load(std::memory_order_relaxed) < *ticks &&
+            b.lowest_take.load(std::memory_order_relaxed) > *ticks) continue;
+
+        fired_.clear();
+        fired_info_.clear();
+        {
+            std::lock_guard lk(b.mu);
+            b.book.sweep(*ticks, fired_);
+            b.publish_bounds();
+            for (const auto& fill : fired_) {
+                fired_info_.push_back(*triggers_.get(fill.maker_tag));
+                triggers_.erase(fill.maker_tag);
+            }
+        }
+        armed_.fetch_sub(fired_.size(), std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < fired_.size(); ++i) {
+            const auto& fill = fired_[i];
+            const auto& info = fired_info_[i];
+            const int quantity = static_cast<int>(fill.quantity);
+            TriggerEvent event{fill.maker_tag, info.user_id, symbol, kind_of(fill.maker_side),
+                               from_ticks(info.trigger), quantity,
+                               stock_.sell(info.user_id, symbol, quantity, info.account_id)};
+            for (const auto& handler : handlers_) handler(event);
+        }
+    }
+}
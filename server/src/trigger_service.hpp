@@ -0,0 +1,102 @@
+#pragma once
+#include "order_book.hpp"
+#include "stock_service.hpp"
+#include "price_engine.hpp"
+#include "concurrent_map.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stop-loss fires when the quote falls to the trigger price or below;
+// take-profit when it rises to it or above. Both sell at the market.
+enum class TriggerKind : uint8_t { StopLoss, TakeProfit };
+
+inline std::string to_string(TriggerKind kind) {
+    return kind == TriggerKind::StopLoss ? "stop_loss" : "take_profit";
+}
+
+inline std::optional<TriggerKind> trigger_kind_from_string(std::string_view s) {
+    if (s == "stop_loss") return TriggerKind::StopLoss;
+    if (s == "take_profit") return TriggerKind::TakeProfit;
+    return std::nullopt;
+}
+
+struct TriggerEvent {
+    uint64_t trigger_id;
+    uint64_t user_id;
+    SymbolId symbol;
+    TriggerKind kind;
+    double trigger_price;
+    int quantity;
+    std::optional<SellResult> sale;  // nullopt if the sell failed, e.g. the shares are gone
+};
+
+// Conditional market sells, one trigger book per instrument. Each book is an
+// OrderBook used as a sorted index: stop-losses rest as bids and
+// take-profits as asks, so a tick's sweep pops exactly the triggers the
+// quote crossed, nearest first, and a tick that crosses nothing costs two
+// relaxed loads per instrument however many triggers are armed.
+//
+// Fired triggers sell through StockService::sell after the book lock is
+// released. Arming reserves nothing; a sell that fails is still reported.
+//
+// Must be constructed before prices.start() and outlive the engine's ticking.
+class TriggerService {
+public:
+    TriggerService(IBankService& bank, StockService& stock, PriceEngine& prices);
+
+    TriggerService(const TriggerService&) = delete;
+    TriggerService& operator=(const TriggerService&) = delete;
+
+    // Called on the engine thread for every fired trigger. Register before
+    // trading starts.
+    void on_fire(std::function<void(const TriggerEvent&)> handler) {
+        handlers_.push_back(std::move(handler));
+    }
+
+    // The trigger price is rounded to kPriceTick. Returns the trigger id;
+    // nullopt for an unknown symbol, an account the user does not own, or a
+    // non-positive price or quantity.
+    std::optional<uint64_t> arm(uint64_t user_id, SymbolId symbol, TriggerKind kind,
+                                double trigger_price, int quantity, uint64_t account_id);
+    bool cancel(uint64_t user_id, uint64_t trigger_id);
+
+    std::size_t armed() const { return armed_.load(std::memory_order_relaxed); }
+
+private:
+    struct TriggerInfo {
+        uint64_t user_id;
+        uint64_t account_id;
+        SymbolId symbol;
+        int64_t trigger;  // ticks
+        OrderHandle handle;
+    };
+
+    struct alignas(64) Book {
+        std::mutex mu;
+        OrderBook book;
+        std::atomic<int64_t> highest_stop{INT64_MIN};
+        std::atomic<int64_t> lowest_take{INT64_MAX};
+
+        void publish_bounds();
+    };
+
+    void on_tick(const MarketSnapshot& snapshot);
+
+    IBankService& bank_;
+    StockService& stock_;
+    const std::size_t symbols_;
+    std::unique_ptr<Book[]> books_;
+    ConcurrentMap<uint64_t, TriggerInfo> triggers_;  // armed; changed only under their book's lock
+    std::atomic<uint64_t> next_id_{1};
+    std::atomic<std::size_t> armed_{0};
+    std::vector<std::function<void(const TriggerEvent&)>> handlers_;
+    std::vector<BookFill> fired_;  // engine thread only
+    std::vector<TriggerInfo> fired_info_;
+};
@@ -0,0 +1,105 @@
+#include "universe.hpp"
+#include "models.hpp"
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+constexpr double kDefaultStockVolatility = 0.03;
+constexpr double kDefaultFxVolatility = 0.005;
+
+bool valid_code(const std::string& code) {
+    if (code.size() != 3) return false;
+    for (char c : code)
+        if (!std::isupper(static_cast<unsigned char>(c))) return false;
+    return true;
+}
+
+bool valid_ticker(const std::string& ticker) {
+    if (ticker.empty() || ticker.size() > 16) return false;
+    for (char c : ticker)
+        if (!std::isupper(static_cast<unsigned char>(c)) && !std::isdigit(static_cast<unsigned char>(c)) && c != '.')
+            return false;
+    return true;
+}
+
+}  // namespace
+
+Universe Universe::defaults() {
+    Universe u;
+    u.currencies = {
+        {"RUB", 92.5, kDefaultFxVolatility},
+        {"USD", 1.0, 0.0},
+        {"EUR", 0.92, kDefaultFxVolatility},
+    };
+    u.instruments = {
+        {"AAPL", 178.50, kDefaultStockVolatility}, {"GOOGL", 140.20, kDefaultStockVolatility},
+        {"TSLA", 245.00, kDefaultStockVolatility}, {"AMZN", 185.60, kDefaultStockVolatility},
+        {"MSFT", 415.30, kDefaultStockVolatility}, {"NFLX", 620.00, kDefaultStockVolatility},
+        {"META", 510.40, kDefaultStockVolatility}, {"NVDA", 790.00, kDefaultStockVolatility},
+    };
+    return u;
+}
+
+std::optional<Universe> Universe::parse(std::istream& in, std::string& error) {
+    Universe u;
+    std::unordered_set<std::string> codes, tickers;
+    std::size_t extra_currencies = 0;  // beyond the built-in three
+    std::string line;
+    for (std::size_t line_no = 1; std::getline(in, line); ++line_no) {
+        auto fail = [&](const std::string& what) {
+            error = "line " + std::to_string(line_no) + ": " + what;
+            return std::nullopt;
+        };
+        if (auto hash = line.find('#'); hash != std::string::npos) line.resize(hash);
+        std::istringstream fields(line);
+        std::string kind, name;
+        if (!(fields >> kind)) continue;
+        double value = 0.0;
+        if (!(fields >> name >> value)) return fail("expected '" + kind + " <name> <value> [volatility]'");
+        double volatility = kind == "currency" ? kDefaultFxVolatility : kDefaultStockVolatility;
+        if (!(fields >> volatility)) {
+            if (!fields.eof()) return fail("bad volatility");
+            fields.clear();
+        }
+        if (std::string rest; fields >> rest) return fail("unexpected '" + rest + "'");
+        if (!(value > 0.0)) return fail("value must be positive");
+        if (!(volatility >= 0.0 && volatility < 1.0)) return fail("volatility must be in [0, 1)");
+
+        if (kind == "currency") {
+            if (!valid_code(name)) return fail("currency code must be three capital letters");
+            if (!codes.insert(name).second) return fail("duplicate currency " + name);
+            if (name == "USD") {
+                if (value != 1.0) return fail("USD is the base and must have rate 1");
+                volatility = 0.0;
+            }
+            if (name != "RUB" && name != "USD" && name != "EUR" && 3 + ++extra_currencies > kMaxCurrencies)
+                return fail("more than " + std::to_string(kMaxCurrencies) + " currencies");
+            u.currencies.push_back({name, value, volatility});
+        } else if (kind == "stock") {
+            if (!valid_ticker(name)) return fail("bad ticker " + name);
+            if (!tickers.insert(name).second) return fail("duplicate ticker " + name);
+            u.instruments.push_back({name, value, volatility});
+        } else {
+            return fail("unknown entry '" + kind + "'");
+        }
+    }
+    if (!codes.count("USD")) {
+        error = "USD is not listed";
+        return std::nullopt;
+    }
+    return u;
+}
+
+std::optional<Universe> Universe::load(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return std::nullopt;
+    }
+    auto u = parse(in, error);
+    if (!u) error = path + ": " + error;
+    return u;
+}
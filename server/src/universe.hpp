@@ -0,0 +1,36 @@
+#pragma once
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct InstrumentSpec {
+    std::string ticker;
+    double price = 0.0;       // initial quote, USD
+    double volatility = 0.0;  // max relative move per tick
+};
+
+struct CurrencySpec {
+    std::string code;
+    double usd_rate = 0.0;  // 1 USD = usd_rate units
+    double volatility = 0.0;
+};
+
+// Instruments and currencies the PriceEngine quotes. The file format is one
+// entry per line, '#' starts a comment:
+//
+//     currency <CODE> <usd_rate> [volatility]   default volatility 0.005
+//     stock    <TICKER> <price>  [volatility]   default volatility 0.03
+//
+// USD must be listed with rate 1; it is the base and never moves.
+struct Universe {
+    std::vector<CurrencySpec> currencies;
+    std::vector<InstrumentSpec> instruments;
+
+    // The built-in eight tickers and RUB/USD/EUR.
+    static Universe defaults();
+
+    // On failure returns nullopt and describes the first bad line in `error`.
+    static std::optional<Universe> parse(std::istream& in, std::string& error);
+    static std::optional<Universe> load(const std::string& path, std::string& error);
+};
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "auth_service.hpp"
+#include "bank_service.hpp"
+#include "command_dispatcher.hpp"
+#include "price_engine.hpp"
+#include "stock_service.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts heap allocations made by the calling thread. Lives in its own test
+// binary because it replaces the global operator new.
+namespace {
+thread_local std::size_t allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+template<typename F>
+std::size_t count_allocations(F&& f) {
+    const auto before = allocations;
+    f();
+    return allocations - before;
+}
+
+class AllocTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auth.register_user("alice", "pass");
+        token = *auth.login("alice", "pass");
+        user_id = *auth.validate(token);
+        account = bank.create_account(user_id, Currency::RUB);
+        // First use of a thread's epoch record and other one-time setup.
+        dispatcher.handle_message({{"type", "get_quotes"}, {"token", token}});
+    }
+
+    AuthService auth;
+    BankService bank;
+    PriceEngine prices;
+    StockService stock{bank, prices};
+    CommandDispatcher dispatcher{auth, bank, stock, prices};
+    std::string token;
+    uint64_t user_id = 0;
+    uint64_t account = 0;
+};
+
+}  // namespace
+
+TEST_F(AllocTest, LookupsDoNotAllocate) {
+    ASSERT_GT(token.size(), 15u);  // longer than the small-string buffer
+    const std::string_view view = token;
+    EXPECT_EQ(count_allocations([&] { EXPECT_TRUE(auth.validate(view)); }), 0u);
+    EXPECT_EQ(count_allocations([&] { EXPECT_GT(prices.get_quote(std::string_view("AAPL")), 0.0); }), 0u);
+    EXPECT_EQ(count_allocations([&] { EXPECT_GT(prices.get_rate(Currency::USD, Currency::RUB), 0.0); }), 0u);
+    EXPECT_EQ(count_allocations([&] { prices.read([](const MarketSnapshot& s) { return s.tick; }); }), 0u);
+}
+
+// The only allocations a request may make are the ones building its reply.
+TEST_F(AllocTest, GetQuotesAllocatesOnlyTheReply) {
+    const nlohmann::json request = {{"type", "get_quotes"}, {"token", token}};
+    const auto handled = count_allocations([&] { dispatcher.handle_message(request); });
+    const auto reply = count_allocations([&] {
+        nlohmann::json arr = nlohmann::json::array();
+        prices.for_each_quote([&](const std::string& ticker, double price) {
+            arr.push_back({{"ticker", ticker}, {"price", price}});
+        });
+        nlohmann::json response = {{"status", "ok"}, {"quotes", arr}};
+    });
+    EXPECT_EQ(handled, reply);
+}
+
+TEST_F(AllocTest, DepositAllocatesOnlyTheReply) {
+    const nlohmann::json request = {
+        {"type", "deposit"}, {"token", token}, {"account_id", account}, {"amount", 10.0}};
+    const auto reply = count_allocations([] {
+        nlohmann::json response = {{"status", "ok"}, {"new_balance", 10.0}};
+    });
+    // History growth allocates now and then; the cheapest run shows the steady state.
+    std::size_t best = SIZE_MAX;
+    for (int i = 0; i < 8; i++)
+        best = std::min(best, count_allocations([&] { dispatcher.handle_message(request); }));
+    EXPECT_EQ(best, reply);
+}
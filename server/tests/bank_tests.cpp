@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "bank_service.hpp"
+#include "ledger_auditor.hpp"
 
 class BankTest : public ::testing::Test {
 protected:
@@ -83,3 +84,227 @@ TEST_F(BankTest, History) {
     EXPECT_DOUBLE_EQ(h[0].balance_after, 500.0);
     EXPECT_DOUBLE_EQ(h[1].balance_after, 300.0);
 }
+
+TEST_F(BankTest, SummaryMatchesAccount) {
+    bank.deposit(uid, acc, 250);
+    auto s = bank.get_account_summary(acc);
+    ASSERT_TRUE(s);
+    EXPECT_EQ(s->user_id, uid);
+    EXPECT_EQ(s->currency, Currency::RUB);
+    EXPECT_DOUBLE_EQ(s->balance, 250.0);
+    auto all = bank.get_account_summaries(uid);
+    ASSERT_EQ(all.size(), 1);
+    EXPECT_EQ(all[0].id, acc);
+}
+
+TEST_F(BankTest, SummaryVersionAdvances) {
+    auto before = bank.get_account_summary(acc)->version;
+    bank.deposit(uid, acc, 1);
+    EXPECT_GT(bank.get_account_summary(acc)->version, before);
+}
+
+TEST_F(BankTest, SummaryHidesClosedAccount) {
+    ASSERT_TRUE(bank.close_account(uid, acc));
+    EXPECT_FALSE(bank.get_account_summary(acc));
+    EXPECT_TRUE(bank.get_account_summaries(uid).empty());
+}
+
+TEST_F(BankTest, BatchTransfer) {
+    auto b = bank.create_account(uid, Currency::RUB);
+    auto c = bank.create_account(42, Currency::RUB);
+    bank.deposit(uid, acc, 1000);
+    auto r = bank.transfer_batch(uid, {{acc, b, 300}, {acc, c, 200}, {b, c, 100}});
+    ASSERT_TRUE(r);
+    ASSERT_EQ(r->size(), 3);
+    EXPECT_DOUBLE_EQ((*r)[1].from_balance, 500.0);
+    EXPECT_DOUBLE_EQ(bank.get_account(acc)->balance, 500.0);
+    EXPECT_DOUBLE_EQ(bank.get_account(b)->balance, 200.0);
+    EXPECT_DOUBLE_EQ(bank.get_account(c)->balance, 300.0);
+}
+
+TEST_F(BankTest, BatchTransferAllOrNothing) {
+    auto b = bank.create_account(uid, Currency::RUB);
+    bank.deposit(uid, acc, 1000);
+    EXPECT_FALSE(bank.transfer_batch(uid, {{acc, b, 600}, {acc, b, 600}}));
+    EXPECT_DOUBLE_EQ(bank.get_account(acc)->balance, 1000.0);
+    EXPECT_DOUBLE_EQ(bank.get_account(b)->balance, 0.0);
+    EXPECT_TRUE(bank.get_history(b).empty());
+}
+
+TEST_F(BankTest, BatchTransferRejectsForeignSource) {
+    auto other = bank.create_account(42, Currency::RUB);
+    bank.deposit(42, other, 1000);
+    bank.deposit(uid, acc, 1000);
+    EXPECT_FALSE(bank.transfer_batch(uid, {{acc, other, 10}, {other, acc, 10}}));
+    EXPECT_DOUBLE_EQ(bank.get_account(other)->balance, 1000.0);
+}
+
+TEST_F(BankTest, BatchTransferConvertsPerLeg) {
+    auto usd = bank.create_account(uid, Currency::USD);
+    bank.deposit(uid, acc, 9250);
+    auto r = bank.transfer_batch(uid, {{acc, usd, 9250}}, [](Currency from, Currency to) {
+        return from == to ? 1.0 : 1.0 / 92.5;
+    });
+    ASSERT_TRUE(r);
+    EXPECT_NEAR((*r)[0].to_balance, 100.0, 0.01);
+}
+
+TEST_F(BankTest, HotAccountReadsCountBufferedCredits) {
+    auto payer = bank.create_account(42, Currency::RUB);
+    bank.deposit(42, payer, 100);
+    ASSERT_TRUE(bank.set_hot_account(acc, true));
+    ASSERT_TRUE(bank.transfer(42, payer, acc, 30));
+    auto r = bank.transfer(42, payer, acc, 20);
+    ASSERT_TRUE(r);
+    EXPECT_DOUBLE_EQ(r->to_balance, 50.0);  // both credits, still buffered
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(acc)->balance, 50.0);
+    EXPECT_DOUBLE_EQ(bank.get_account_summaries(uid)[0].balance, 50.0);
+    EXPECT_DOUBLE_EQ(bank.get_account(acc)->balance, 50.0);
+    auto h = bank.get_history(acc);
+    ASSERT_EQ(h.size(), 2);
+    EXPECT_EQ(h[1].type, OpType::TransferIn);
+    EXPECT_DOUBLE_EQ(h[1].balance_after, 50.0);
+    EXPECT_DOUBLE_EQ(bank.build_report(1).by_currency[Currency::RUB].balance, 100.0);
+}
+
+TEST_F(BankTest, HotAccountDebitUsesFoldedBalance) {
+    auto payer = bank.create_account(42, Currency::RUB);
+    bank.deposit(42, payer, 100);
+    bank.set_hot_account(acc, true);
+    bank.transfer(42, payer, acc, 100);
+    EXPECT_FALSE(bank.withdraw(uid, acc, 101));
+    EXPECT_DOUBLE_EQ(*bank.withdraw(uid, acc, 100), 0.0);
+}
+
+TEST_F(BankTest, HotAccountCloseSealsBuffer) {
+    auto payer = bank.create_account(42, Currency::RUB);
+    bank.deposit(42, payer, 100);
+    bank.set_hot_account(acc, true);
+    bank.transfer(42, payer, acc, 10);
+    EXPECT_FALSE(bank.close_account(uid, acc));
+    bank.withdraw(uid, acc, 10);
+    EXPECT_TRUE(bank.close_account(uid, acc));
+    EXPECT_FALSE(bank.transfer(42, payer, acc, 10));
+    EXPECT_DOUBLE_EQ(bank.get_account(payer)->balance, 90.0);
+}
+
+TEST_F(BankTest, UnknownAccountIds) {
+    EXPECT_FALSE(bank.get_account(0));
+    EXPECT_FALSE(bank.get_account(acc + 1000000));
+    EXPECT_FALSE(bank.deposit(uid, acc + 1, 10));
+    EXPECT_TRUE(bank.get_history(42).empty());
+}
+
+TEST_F(BankTest, ClosedAccountUnreachable) {
+    ASSERT_TRUE(bank.close_account(uid, acc));
+    EXPECT_FALSE(bank.get_account(acc));
+    EXPECT_FALSE(bank.deposit(uid, acc, 10));
+    EXPECT_FALSE(bank.close_account(uid, acc));
+}
+
+TEST_F(BankTest, ReportAggregatesAcrossUsers) {
+    auto usd = bank.create_account(42, Currency::USD);
+    bank.deposit(uid, acc, 500);
+    bank.withdraw(uid, acc, 200);
+    bank.deposit(42, usd, 70);
+    auto other_rub = bank.create_account(42, Currency::RUB);
+    bank.deposit(42, other_rub, 100);
+
+    auto report = bank.build_report(2);
+    EXPECT_EQ(report.accounts, 3u);
+    EXPECT_EQ(report.by_currency[Currency::RUB].accounts, 2u);
+    EXPECT_DOUBLE_EQ(report.by_currency[Currency::RUB].balance, 400.0);
+    EXPECT_DOUBLE_EQ(report.by_currency[Currency::USD].balance, 70.0);
+
+    OpTotals rub_deposits, rub_withdrawals;
+    for (const auto& [key, totals] : report.daily) {
+        if (std::get<1>(key) != Currency::RUB) continue;
+        if (std::get<2>(key) == OpType::Deposit) rub_deposits = totals;
+        if (std::get<2>(key) == OpType::Withdraw) rub_withdrawals = totals;
+    }
+    EXPECT_EQ(rub_deposits.count, 2u);
+    EXPECT_DOUBLE_EQ(rub_deposits.volume, 600.0);
+    EXPECT_DOUBLE_EQ(rub_withdrawals.volume, 200.0);
+}
+
+TEST_F(BankTest, AuditorPassesCleanLedger) {
+    auto usd = bank.create_account(uid, Currency::USD);
+    bank.deposit(uid, acc, 1000);
+    bank.transfer(uid, acc, usd, 300, 0.01);
+    bank.withdraw(uid, usd, 1);
+
+    LedgerAuditor auditor(bank);
+    std::vector<LedgerAlert> alerts;
+    auditor.on_alert([&](const LedgerAlert& alert) { alerts.push_back(alert); });
+    auditor.run_once();
+    bank.deposit(uid, acc, 5);
+    auditor.run_once();
+
+    auto metrics = auditor.metrics();
+    EXPECT_TRUE(alerts.empty());
+    EXPECT_EQ(metrics.passes, 2u);
+    EXPECT_EQ(metrics.entries_checked, 5u);  // second pass only replays the new deposit
+    EXPECT_EQ(metrics.owners_checked, 2u);
+    EXPECT_EQ(metrics.totals_checked, 2u);
+    EXPECT_EQ(metrics.drift_alerts, 0u);
+}
+
+TEST_F(BankTest, ClosingWithAResidualLeavesNoDrift) {
+    // Each account closes holding just under the 1e-9 the close check
+    // tolerates; together they would exceed the auditor's tolerance.
+    for (int i = 0; i < 10; ++i) {
+        auto tiny = bank.create_account(uid, Currency::USD);
+        bank.deposit(uid, tiny, 1.0);
+        bank.withdraw(uid, tiny, 1.0 - 9e-10);
+        ASSERT_GT(bank.get_account_summary(tiny)->balance, 0.0);
+        ASSERT_TRUE(bank.close_account(uid, tiny));
+    }
+
+    LedgerAuditor auditor(bank);
+    std::vector<LedgerAlert> alerts;
+    auditor.on_alert([&](const LedgerAlert& alert) { alerts.push_back(alert); });
+    auditor.run_once();
+    EXPECT_TRUE(alerts.empty());
+    EXPECT_EQ(auditor.metrics().totals_checked, 1u);
+
+    // The written-off residuals are no withdrawals of the user's.
+    auto report = bank.build_report();
+    for (const auto& [key, totals] : report.daily) {
+        if (std::get<1>(key) == Currency::USD && std::get<2>(key) == OpType::Withdraw) {
+            EXPECT_EQ(totals.count, 10u);
+            EXPECT_NEAR(totals.volume, 10 * (1.0 - 9e-10), 1e-12);
+        }
+    }
+}
+
+TEST_F(BankTest, ReportKeepsClosedAccountsVolumes) {
+    auto usd = bank.create_account(uid, Currency::USD);
+    bank.deposit(uid, usd, 70);
+    bank.withdraw(uid, usd, 70);
+    ASSERT_TRUE(bank.close_account(uid, usd));
+
+    auto report = bank.build_report();
+    EXPECT_EQ(report.accounts, 1u);
+    EXPECT_EQ(report.by_currency.count(Currency::USD), 0u);
+    OpTotals deposits, withdrawals;
+    for (const auto& [key, totals] : report.daily) {
+        if (std::get<1>(key) != Currency::USD) continue;
+        if (std::get<2>(key) == OpType::Deposit) deposits = totals;
+        if (std::get<2>(key) == OpType::Withdraw) withdrawals = totals;
+    }
+    EXPECT_EQ(deposits.count, 1u);
+    EXPECT_DOUBLE_EQ(deposits.volume, 70.0);
+    EXPECT_DOUBLE_EQ(withdrawals.volume, 70.0);
+}
+
+TEST_F(BankTest, ReplayDetectsTamperedHistory) {
+    bank.deposit(uid, acc, 100);
+    bank.withdraw(uid, acc, 40);
+    auto history = bank.get_history(acc);
+    ASSERT_EQ(history.size(), 2u);
+    EXPECT_EQ(replay_history(history, 0, 0.0), 60.0);
+    EXPECT_EQ(replay_history(history, 1, 100.0), 60.0);
+
+    history[1].amount = 45;
+    EXPECT_FALSE(replay_history(history, 0, 0.0));
+}
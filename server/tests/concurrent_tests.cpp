@@ -1,10 +1,19 @@
 #include <gtest/gtest.h>
 #include "auth_service.hpp"
 #include "bank_service.hpp"
+#include "ledger_auditor.hpp"
+#include "order_service.hpp"
 #include "stock_service.hpp"
+#include "trade_sequencer.hpp"
+#include "concurrent_map.hpp"
+#include "read_mostly_map.hpp"
 #include <thread>
 #include <vector>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
 
 TEST(Concurrent, ParallelDeposits) {
     BankService bank;
@@ -140,6 +149,235 @@ TEST(Concurrent, CrossUserTransfer) {
     EXPECT_DOUBLE_EQ(total, 10000.0);
 }
 
+TEST(Concurrent, OpposingBatchTransfers) {
+    BankService bank;
+    auto a = bank.create_account(1, Currency::RUB);
+    auto b = bank.create_account(2, Currency::RUB);
+    auto c = bank.create_account(3, Currency::RUB);
+    bank.deposit(1, a, 5000);
+    bank.deposit(2, b, 5000);
+    bank.deposit(3, c, 5000);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 50; i++) {
+        threads.emplace_back([&] { bank.transfer_batch(1, {{a, b, 10.0}, {a, c, 10.0}}); });
+        threads.emplace_back([&] { bank.transfer_batch(3, {{c, b, 10.0}, {c, a, 10.0}}); });
+        threads.emplace_back([&] { bank.transfer_batch(2, {{b, c, 10.0}, {b, a, 10.0}}); });
+    }
+    for (auto& t : threads) t.join();
+    double total = bank.get_account(a)->balance + bank.get_account(b)->balance +
+                   bank.get_account(c)->balance;
+    EXPECT_DOUBLE_EQ(total, 15000.0);
+}
+
+TEST(Concurrent, ParallelAccountCreation) {
+    BankService bank;
+    constexpr int kThreads = 8, kPerThread = 1000;  // spans several handle-table chunks
+    std::vector<std::vector<uint64_t>> ids(kThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; i++)
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < kPerThread; j++)
+                ids[i].push_back(bank.create_account(i + 1, Currency::USD));
+        });
+    for (auto& t : threads) t.join();
+    for (int i = 0; i < kThreads; i++) {
+        EXPECT_EQ(bank.get_account_summaries(i + 1).size(), static_cast<size_t>(kPerThread));
+        for (auto id : ids[i]) {
+            auto s = bank.get_account_summary(id);
+            ASSERT_TRUE(s);
+            EXPECT_EQ(s->user_id, static_cast<uint64_t>(i + 1));
+        }
+    }
+}
+
+TEST(Concurrent, ReportWhileTrading) {
+    BankService bank;
+    std::vector<uint64_t> accs;
+    for (int u = 1; u <= 200; u++) {
+        accs.push_back(bank.create_account(u, Currency::RUB));
+        bank.deposit(u, accs.back(), 100);
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread trader([&] {
+        for (int i = 0; !stop; i = (i + 1) % 199)
+            bank.transfer(i + 1, accs[i], accs[i + 1], 1.0);
+    });
+    auto net_of = [](const BankReport& report) {
+        double net = 0.0;
+        for (const auto& [key, totals] : report.daily) {
+            const OpType type = std::get<2>(key);
+            net += type == OpType::Deposit || type == OpType::TransferIn ? totals.volume : -totals.volume;
+        }
+        return net;
+    };
+    for (int i = 0; i < 5; i++) {
+        auto report = bank.build_report(4);
+        EXPECT_EQ(report.accounts, 200u);
+        OpTotals deposits;
+        for (const auto& [key, totals] : report.daily)
+            if (std::get<2>(key) == OpType::Deposit) deposits = totals;
+        EXPECT_EQ(deposits.count, 200u);
+        EXPECT_DOUBLE_EQ(deposits.volume, 20000.0);
+    }
+    stop = true;
+    trader.join();
+
+    // At rest the rolled-up volumes net out to the balances.
+    auto serial = bank.build_report(1);
+    auto parallel = bank.build_report(4);
+    EXPECT_DOUBLE_EQ(serial.by_currency[Currency::RUB].balance, 20000.0);
+    EXPECT_DOUBLE_EQ(parallel.by_currency[Currency::RUB].balance, 20000.0);
+    EXPECT_DOUBLE_EQ(net_of(serial), 20000.0);
+    EXPECT_EQ(serial.daily.size(), parallel.daily.size());
+}
+
+TEST(Concurrent, SnapshotReadsDuringTicks) {
+    PriceEngine prices;
+    BankService bank;
+    StockService stocks(bank, prices);
+    auto acc = bank.create_account(1, Currency::USD);
+    bank.deposit(1, acc, 1000000);
+    prices.start();
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> regressions{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (!stop) {
+                prices.read([&](const MarketSnapshot& s) {
+                    if (s.tick < last || s.quotes.size() != prices.symbols().size()) regressions++;
+                    last = s.tick;
+                });
+            }
+        });
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (prices.tick() < 3 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_TRUE(stocks.buy(1, "AAPL", 1, acc));
+    stop = true;
+    for (auto& t : readers) t.join();
+    prices.stop();
+
+    EXPECT_EQ(regressions.load(), 0);
+    EXPECT_GE(prices.tick(), 3u);
+    auto trade = stocks.get_trades(1).trades.at(0);
+    EXPECT_GE(trade.tick, 3u);
+    EXPECT_LE(trade.tick, prices.tick());
+}
+
+TEST(Concurrent, AuditWhileTrading) {
+    BankService bank;
+    std::vector<uint64_t> accs;
+    for (int u = 1; u <= 2000; u++) {
+        accs.push_back(bank.create_account(u, u % 2 ? Currency::RUB : Currency::USD));
+        bank.deposit(u, accs.back(), 100);
+    }
+    bank.set_hot_account(accs[0], true);
+
+    LedgerAuditor auditor(bank, std::chrono::milliseconds(1), 4);
+    std::atomic<uint64_t> alerts{0};
+    auditor.on_alert([&](const LedgerAlert&) { alerts++; });
+    auditor.start();
+
+    std::vector<std::thread> traders;
+    for (int t = 0; t < 4; t++) {
+        traders.emplace_back([&, t] {
+            for (int i = t; i < 20000; i += 4) {
+                const int from = 1 + i % 1999;
+                bank.transfer(from, accs[from - 1], accs[(i * 7) % 2000], 1.0, 2.0);
+            }
+        });
+    }
+    for (auto& t : traders) t.join();
+    auditor.stop();
+
+    const auto started = std::chrono::steady_clock::now();
+    auditor.run_once();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    auto metrics = auditor.metrics();
+    std::cout << "[bench] audit passes during trading: " << metrics.passes - 1
+              << ", bank-wide totals checked: " << metrics.totals_checked
+              << ", idle incremental pass over 2000 accounts: " << ms << " ms" << std::endl;
+
+    EXPECT_EQ(alerts.load(), 0u);
+    EXPECT_EQ(metrics.drift_alerts, 0u);
+    // Every pass checks every owner's totals, whether or not trading paused.
+    EXPECT_EQ(metrics.owners_checked, metrics.passes * 2000);
+    EXPECT_GE(metrics.totals_checked, 1u);
+}
+
+TEST(Concurrent, MapEraseKeepsProbeRuns) {
+    ConcurrentMap<uint64_t, uint64_t> map(1);
+    for (uint64_t k = 0; k < 5000; k++) map.put(k, k * 2);
+    for (uint64_t k = 0; k < 5000; k += 3) EXPECT_TRUE(map.erase(k));
+    for (uint64_t k = 0; k < 5000; k++) {
+        auto v = map.get(k);
+        if (k % 3 == 0) EXPECT_FALSE(v);
+        else ASSERT_EQ(v, k * 2);
+    }
+    EXPECT_FALSE(map.erase(0));
+    EXPECT_TRUE(map.try_insert(0, 7));
+    EXPECT_FALSE(map.try_insert(0, 8));
+    EXPECT_EQ(map.get(0), 7u);
+}
+
+TEST(Concurrent, MapShardCountAtRuntime) {
+    ConcurrentMap<std::string, int> map(5);
+    EXPECT_EQ(map.shard_count(), 8u);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 1000; i++) {
+                auto key = std::to_string(t) + ":" + std::to_string(i);
+                map.put(key, i);
+                if (i % 2) map.erase(key);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (int t = 0; t < 4; t++)
+        for (int i = 0; i < 1000; i++)
+            EXPECT_EQ(map.get(std::to_string(t) + ":" + std::to_string(i)).has_value(), i % 2 == 0);
+    std::size_t entries = 0;
+    map.for_each([&](const std::string&, int) { ++entries; });
+    EXPECT_EQ(entries, 4u * 500);
+}
+
+TEST(Concurrent, ReadMostlyMapReadersDuringChurn) {
+    ReadMostlyMap<std::string, uint64_t> map;
+    for (uint64_t i = 0; i < 100; i++) map.put("stable" + std::to_string(i), i);
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> misses{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&] {
+            for (uint64_t n = 0; !stop; n++) {
+                auto v = map.get("stable" + std::to_string(n % 100));
+                if (!v || *v != n % 100) misses++;
+                map.get("churn" + std::to_string(n % 500));
+            }
+        });
+    }
+    for (uint64_t i = 0; i < 5000; i++) {
+        map.put("churn" + std::to_string(i % 500), i);
+        if (i % 3 == 0) map.erase("churn" + std::to_string((i * 7) % 500));
+    }
+    stop = true;
+    for (auto& t : readers) t.join();
+
+    EXPECT_EQ(misses.load(), 0u);
+    map.erase("stable0");
+    EXPECT_FALSE(map.get("stable0"));
+    // With no reader left in an old epoch, the next reclaim batch frees everything.
+    for (int i = 0; i < 64 && map.pending_reclaim() > 0; i++) map.put("stable1", i);
+    EXPECT_EQ(map.pending_reclaim(), 0u);
+}
+
 TEST(Concurrent, ValidateWhileRegistering) {
     AuthService auth;
     auth.register_user("alice", "pass");
@@ -162,3 +400,295 @@ TEST(Concurrent, ValidateWhileRegistering) {
     for (auto& t : threads) t.join();
     EXPECT_EQ(validations.load(), 1000);
 }
+
+// --- Throughput benchmarks (report numbers, assert only correctness) ---
+
+namespace {
+
+template<typename Read>
+long reads_alongside_hot_writer(BankService& bank, uint64_t acc, Read read) {
+    using namespace std::chrono;
+    std::atomic<bool> stop{false};
+    std::atomic<long> reads{0};
+    std::thread writer([&] {
+        while (!stop) bank.deposit(1, acc, 1.0);
+    });
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++)
+        readers.emplace_back([&] {
+            long n = 0;
+            double last = 0.0;
+            while (!stop) {
+                double balance = read();
+                EXPECT_GE(balance, last);
+                last = balance;
+                n++;
+            }
+            reads += n;
+        });
+    std::this_thread::sleep_for(milliseconds(200));
+    stop = true;
+    writer.join();
+    for (auto& t : readers) t.join();
+    return reads.load();
+}
+
+}  // namespace
+
+TEST(Concurrent, SummaryReadsWithHotWriter) {
+    BankService bank;
+    auto acc = bank.create_account(1, Currency::RUB);
+
+    long locked = reads_alongside_hot_writer(bank, acc, [&] {
+        return bank.get_accounts(1).front().balance;
+    });
+    long optimistic = reads_alongside_hot_writer(bank, acc, [&] {
+        return bank.get_account_summaries(1).front().balance;
+    });
+
+    std::cout << "[bench] get_accounts reads/200ms: " << locked
+              << ", get_account_summaries reads/200ms: " << optimistic << std::endl;
+    EXPECT_GT(locked, 0);
+    EXPECT_GT(optimistic, 0);
+}
+
+TEST(Concurrent, BatchVersusSingleTransfers) {
+    using namespace std::chrono;
+    constexpr int kPayees = 2000;
+
+    auto run = [&](bool batched) {
+        BankService bank;
+        auto payer = bank.create_account(1, Currency::RUB);
+        bank.deposit(1, payer, kPayees * 10.0);
+        std::vector<TransferLeg> legs;
+        for (int i = 0; i < kPayees; i++)
+            legs.push_back({payer, bank.create_account(2 + i, Currency::RUB), 10.0});
+
+        auto start = steady_clock::now();
+        if (batched) {
+            EXPECT_TRUE(bank.transfer_batch(1, legs));
+        } else {
+            for (const auto& leg : legs)
+                EXPECT_TRUE(bank.transfer(1, leg.from_id, leg.to_id, leg.amount));
+        }
+        auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+        EXPECT_DOUBLE_EQ(bank.get_account(payer)->balance, 0.0);
+        return elapsed;
+    };
+
+    auto singles = run(false);
+    auto batch = run(true);
+    std::cout << "[bench] " << kPayees << " single transfers: " << singles
+              << "us, one batch_transfer: " << batch << "us" << std::endl;
+}
+
+TEST(Concurrent, HotAccountTransferScaling) {
+    using namespace std::chrono;
+    constexpr int kTransfersPerThread = 2000;
+
+    auto run = [&](int workers, bool hot) {
+        BankService bank;
+        auto merchant = bank.create_account(1, Currency::RUB);
+        if (hot) bank.set_hot_account(merchant, true);
+        std::vector<uint64_t> payers;
+        for (int i = 0; i < workers; i++) {
+            payers.push_back(bank.create_account(2 + i, Currency::RUB));
+            bank.deposit(2 + i, payers.back(), kTransfersPerThread);
+        }
+
+        auto start = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < workers; i++)
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < kTransfersPerThread; j++)
+                    EXPECT_TRUE(bank.transfer(2 + i, payers[i], merchant, 1.0));
+            });
+        for (auto& t : threads) t.join();
+        auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+        EXPECT_DOUBLE_EQ(bank.get_account(merchant)->balance, workers * kTransfersPerThread * 1.0);
+        EXPECT_EQ(bank.get_history(merchant).size(), static_cast<size_t>(workers * kTransfersPerThread));
+        return workers * kTransfersPerThread * 1e6 / std::max<long>(elapsed, 1);
+    };
+
+    for (int workers : {1, 2, 4, 8}) {
+        std::cout << "[bench] " << workers << " workers into one account: locked "
+                  << static_cast<long>(run(workers, false)) << " transfers/s, hot "
+                  << static_cast<long>(run(workers, true)) << " transfers/s" << std::endl;
+    }
+}
+
+TEST(Concurrent, OrdersWhileTicking) {
+    SimulationConfig config;
+    config.tick_interval = std::chrono::milliseconds(1);
+    BankService bank;
+    PriceEngine prices(Universe::defaults(), config);
+    StockService stocks(bank, prices);
+    OrderService orders(bank, stocks, prices);
+    const SymbolId aapl = *prices.symbols().find("AAPL");
+
+    constexpr int kUsers = 4;
+    std::mutex mu;
+    std::vector<int> net(kUsers + 1, 0);  // filled shares per user, signed by side
+    orders.on_event([&](const OrderEvent& e) {
+        if (e.kind != OrderEvent::Kind::Fill) return;
+        std::lock_guard lk(mu);
+        net[e.user_id] += e.side == Side::Buy ? e.quantity : -e.quantity;
+    });
+    std::vector<uint64_t> accounts(kUsers + 1);
+    for (uint64_t u = 1; u <= kUsers; ++u) {
+        accounts[u] = bank.create_account(u, Currency::USD);
+        bank.deposit(u, accounts[u], 1e6);
+        ASSERT_TRUE(stocks.buy(u, aapl, 100, accounts[u]));
+    }
+
+    prices.start();
+    std::vector<std::thread> threads;
+    for (uint64_t u = 1; u <= kUsers; ++u) {
+        threads.emplace_back([&, u] {
+            for (int i = 0; i < 300; ++i) {
+                const double mid = prices.get_quote("AAPL");
+                const Side side = (i + u) % 2 ? Side::Buy : Side::Sell;
+                const double price = mid * (side == Side::Buy ? 0.999 : 1.001) + (i % 7 - 3) * 0.05;
+                auto placed = orders.place(u, aapl, side, price, 1 + i % 3, accounts[u]);
+                if (placed && i % 4 == 0) orders.cancel(u, placed->order_id);
+                if (placed && i % 5 == 0) orders.amend(u, placed->order_id, mid, 1);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    prices.stop();
+
+    for (uint64_t u = 1; u <= kUsers; ++u) {
+        int held = 0;
+        for (const auto& pos : stocks.get_portfolio(u))
+            if (pos.symbol == aapl) held = pos.quantity;
+        EXPECT_EQ(held, 100 + net[u]) << "user " << u;
+    }
+}
+
+namespace {
+
+Universe jumpy_universe() {
+    Universe u;
+    u.currencies = {{"USD", 1.0, 0.0}, {"EUR", 0.92, 0.05}};
+    u.instruments = {{"A", 100.0, 0.05}, {"B", 100.0, 0.05}};
+    return u;
+}
+
+}  // namespace
+
+TEST(Concurrent, SequencerOrdersTradesAgainstTicks) {
+    BankService bank;
+    PriceEngine prices(jumpy_universe(), [] { SimulationConfig c; c.seed = 3; return c; }());
+    StockService stocks(bank, prices);
+    TradeSequencer sequencer(stocks, prices);
+    auto acc = bank.create_account(1, Currency::EUR);
+    bank.deposit(1, acc, 1e6);
+    sequencer.start();
+
+    // However late the sequencer thread runs each trade, it gets the quote
+    // and the EUR rate of the tick queued ahead of it, and records that tick.
+    std::vector<TradeOutcome> outcomes(3);
+    std::vector<double> quotes, rates;
+    for (int i = 0; i < 3; ++i) {
+        quotes.push_back(prices.get_quote(SymbolId{0}));
+        rates.push_back(prices.read([](const MarketSnapshot& s) { return s.rate(Currency::USD, Currency::EUR); }));
+        ASSERT_TRUE(sequencer.submit({1, acc, 0, 1, true},
+                                     [&outcomes, i](const TradeOutcome& out) { outcomes[i] = out; }));
+        prices.step();
+    }
+    sequencer.stop();
+
+    const auto trades = stocks.get_trades(1).trades;
+    ASSERT_EQ(trades.size(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(outcomes[i].sequence, static_cast<uint64_t>(i + 1));
+        EXPECT_EQ(outcomes[i].tick, static_cast<uint64_t>(i));
+        ASSERT_TRUE(outcomes[i].bought);
+        EXPECT_DOUBLE_EQ(outcomes[i].bought->price, quotes[i]);
+        EXPECT_DOUBLE_EQ(outcomes[i].bought->total_cost, quotes[i] * rates[i]);
+        EXPECT_EQ(trades[i].tick, outcomes[i].tick);
+    }
+    EXPECT_FALSE(sequencer.submit({1, acc, 0, 1, true}, nullptr));
+}
+
+TEST(Concurrent, SequencerUnderARushOnOneSymbol) {
+    constexpr int kUsers = 4, kTrades = 300;
+    BankService bank;
+    PriceEngine prices(jumpy_universe(), [] { SimulationConfig c; c.seed = 4; return c; }());
+    StockService stocks(bank, prices);
+    TradeSequencer sequencer(stocks, prices, 2);
+    std::vector<uint64_t> accounts;
+    for (uint64_t user = 1; user <= kUsers; ++user) {
+        accounts.push_back(bank.create_account(user, Currency::USD));
+        bank.deposit(user, accounts.back(), 1e9);
+    }
+    sequencer.start();
+
+    // Completions for one symbol all run on its sequencer thread.
+    std::vector<uint64_t> ticks(kUsers * kTrades + 1, 0);
+    std::atomic<int> done{0};
+    std::atomic<bool> stop{false};
+    std::thread ticker([&] { while (!stop) prices.step(); });
+    std::vector<std::thread> traders;
+    for (int u = 0; u < kUsers; ++u) {
+        traders.emplace_back([&, u] {
+            for (int i = 0; i < kTrades; ++i) {
+                const TradeRequest r{static_cast<uint64_t>(u + 1), accounts[u], 0, 1, true};
+                while (!sequencer.submit(r, [&](const TradeOutcome& out) {
+                    if (out.sequence < ticks.size()) ticks[out.sequence] = out.tick + 1;
+                    if (out.ok()) done++;
+                })) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : traders) t.join();
+    stop = true;
+    ticker.join();
+    sequencer.stop();
+
+    EXPECT_EQ(done.load(), kUsers * kTrades);
+    EXPECT_TRUE(std::all_of(ticks.begin() + 1, ticks.end(), [](uint64_t t) { return t > 0; }));
+    EXPECT_TRUE(std::is_sorted(ticks.begin() + 1, ticks.end()));
+    for (uint64_t user = 1; user <= kUsers; ++user) {
+        auto p = stocks.get_portfolio(user);
+        ASSERT_EQ(p.size(), 1u);
+        EXPECT_EQ(p[0].quantity, kTrades);
+    }
+}
+
+TEST(Concurrent, SequencerStopsWhileATickWaitsOnAFullLane) {
+    BankService bank;
+    PriceEngine prices(jumpy_universe(), [] { SimulationConfig c; c.seed = 6; return c; }());
+    StockService stocks(bank, prices);
+    TradeSequencer sequencer(stocks, prices, 1, 2);
+    auto acc = bank.create_account(1, Currency::USD);
+    bank.deposit(1, acc, 1e6);
+    sequencer.start();
+
+    // Hold the only sequencer thread inside a completion on symbol 1 while
+    // symbol 0's lane fills up, so the next tick spins on it.
+    std::atomic<bool> entered{false}, release{false};
+    std::atomic<int> done{0};
+    ASSERT_TRUE(sequencer.submit({1, acc, 1, 1, true}, [&](const TradeOutcome&) {
+        entered = true;
+        while (!release) std::this_thread::yield();
+        done++;
+    }));
+    while (!entered) std::this_thread::yield();
+    int queued = 0;
+    while (sequencer.submit({1, acc, 0, 1, true}, [&](const TradeOutcome&) { done++; })) ++queued;
+    ASSERT_GT(queued, 0);
+
+    std::thread ticker([&] { prices.step(); });
+    std::thread stopper([&] { sequencer.stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release = true;
+    ticker.join();
+    stopper.join();
+
+    EXPECT_EQ(done.load(), queued + 1);
+    EXPECT_EQ(prices.tick(), 1u);
+    EXPECT_FALSE(sequencer.submit({1, acc, 0, 1, true}, nullptr));
+}
@@ -3,6 +3,8 @@
 #include "auth_service.hpp"
 #include "bank_service.hpp"
 #include "command_dispatcher.hpp"
+#include "order_service.hpp"
+#include "price_alerts.hpp"
 #include "price_engine.hpp"
 #include "stock_service.hpp"
 #include "tcp_framing.hpp"
@@ -13,7 +15,9 @@
 
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -77,19 +81,43 @@ public:
 
     nlohmann::json request(const nlohmann::json& request_json) {
         write_frame(socket_, request_json.dump());
-        return read_frame_json(socket_);
+        return read_response();
     }
 
     nlohmann::json request_raw_payload(const std::string& payload) {
         write_frame(socket_, payload);
+        return read_response();
+    }
+
+    // The next push, whether it arrived between responses or is still on the wire.
+    nlohmann::json next_notification() {
+        if (!notifications_.empty()) {
+            auto next = std::move(notifications_.front());
+            notifications_.pop_front();
+            return next;
+        }
         return read_frame_json(socket_);
     }
 
     tcp::socket& socket() { return socket_; }
 
+    // Pushes that arrived ahead of a response and were not read yet.
+    std::size_t buffered_notifications() const { return notifications_.size(); }
+
 private:
+    nlohmann::json read_response() {
+        for (;;) {
+            auto frame = read_frame_json(socket_);
+            if (frame.value("type", "") != "notification") {
+                return frame;
+            }
+            notifications_.push_back(std::move(frame));
+        }
+    }
+
     boost::asio::io_context io_;
     tcp::socket socket_{io_};
+    std::deque<nlohmann::json> notifications_;
 };
 
 class NetworkFixture : public ::testing::Test {
@@ -125,7 +153,8 @@ private:
     BankService bank_;
     PriceEngine prices_;
     StockService stock_{bank_, prices_};
-    CommandDispatcher dispatcher_{auth_, bank_, stock_, prices_};
+    OrderService orders_{bank_, stock_, prices_};
+    CommandDispatcher dispatcher_{auth_, bank_, stock_, prices_, &orders_};
 
     std::unique_ptr<TcpServer> server_;
     std::thread server_thread_;
@@ -292,6 +321,29 @@ TEST_F(NetworkFixture, MoneyFlowHistoryRatesAndCloseAccount) {
     ASSERT_TRUE(rates.contains("rates"));
     ASSERT_TRUE(rates["rates"].contains("USD_RUB"));
 
+    auto candles = client.request({
+        {"type", "get_candles"},
+        {"token", token},
+        {"ticker", "AAPL"},
+        {"interval", "1m"},
+        {"limit", 5}
+    });
+    ASSERT_EQ(candles.value("status", ""), "ok");
+    ASSERT_TRUE(candles["candles"].is_array());
+    ASSERT_GE(candles["candles"].size(), 1u);
+    const auto& bar = candles["candles"].back();
+    EXPECT_EQ(bar.value("timestamp", int64_t{1}) % 60, 0);
+    EXPECT_LE(bar.value("low", 0.0), bar.value("close", 0.0));
+    EXPECT_GE(bar.value("high", 0.0), bar.value("close", 0.0));
+
+    auto bad_interval = client.request({
+        {"type", "get_candles"},
+        {"token", token},
+        {"ticker", "AAPL"},
+        {"interval", "2m"}
+    });
+    ASSERT_EQ(bad_interval.value("message", ""), "Invalid interval");
+
     auto close_fail = client.request({
         {"type", "close_account"},
         {"token", token},
@@ -466,6 +518,10 @@ TEST_F(NetworkFixture, StockTradeHappyPathOverTcp) {
     ASSERT_EQ(portfolio["positions"][0]["quantity"].get<int>(), 2);
     ASSERT_TRUE(portfolio["positions"][0].contains("current_price"));
     ASSERT_TRUE(portfolio["positions"][0].contains("pnl"));
+    ASSERT_TRUE(portfolio["positions"][0].contains("market_value"));
+    ASSERT_DOUBLE_EQ(portfolio["totals"]["market_value"].get<double>(),
+                     portfolio["positions"][0]["market_value"].get<double>());
+    ASSERT_GT(portfolio["version"].get<uint64_t>(), 0u);
 
     auto sell = client.request({
         {"type", "sell_stock"},
@@ -486,6 +542,52 @@ TEST_F(NetworkFixture, StockTradeHappyPathOverTcp) {
     ASSERT_EQ(trades["trades"].size(), 2u);
     ASSERT_EQ(trades["trades"][0]["side"].get<std::string>(), "buy");
     ASSERT_EQ(trades["trades"][1]["side"].get<std::string>(), "sell");
+    ASSERT_TRUE(trades["next_cursor"].is_null());
+
+    auto sells = client.request({
+        {"type", "get_trades"}, {"token", token}, {"ticker", "AAPL"}, {"side", "sell"}, {"limit", 1}
+    });
+    ASSERT_EQ(sells["trades"].size(), 1u);
+    ASSERT_EQ(sells["trades"][0]["side"].get<std::string>(), "sell");
+    ASSERT_EQ(client.request({{"type", "get_trades"}, {"token", token}, {"side", "short"}})
+                  .value("message", ""), "Invalid field: side");
+}
+
+TEST_F(NetworkFixture, GetTradesPagesByDefaultAndAllReturnsTheWholeHistory) {
+    TestClient client;
+    client.connect(port());
+    client.request({{"type", "register"}, {"username", "history_alice"}, {"password", "pass123"}});
+    auto login = client.request({{"type", "login"}, {"username", "history_alice"}, {"password", "pass123"}});
+    const std::string token = login["token"].get<std::string>();
+    auto create = client.request({{"type", "create_account"}, {"token", token}, {"currency", "USD"}});
+    const uint64_t account_id = create["account_id"].get<uint64_t>();
+    ASSERT_EQ(client.request({{"type", "deposit"}, {"token", token}, {"account_id", account_id}, {"amount", 1e6}})
+                  .value("status", ""), "ok");
+
+    constexpr std::size_t kTrades = 105;  // more than one default page
+    for (std::size_t i = 0; i < kTrades; ++i) {
+        ASSERT_EQ(client.request({{"type", "buy_stock"}, {"token", token}, {"ticker", "AAPL"}, {"quantity", 1},
+                                  {"account_id", account_id}}).value("status", ""), "ok");
+    }
+
+    auto first = client.request({{"type", "get_trades"}, {"token", token}});
+    ASSERT_EQ(first["trades"].size(), 100u);
+    ASSERT_FALSE(first["next_cursor"].is_null());
+
+    auto all = client.request({{"type", "get_trades"}, {"token", token}, {"all", true}});
+    ASSERT_EQ(all["trades"].size(), kTrades);
+    ASSERT_TRUE(all["next_cursor"].is_null());
+    EXPECT_EQ(client.request({{"type", "get_trades"}, {"token", token}, {"all", true}, {"limit", 5}})
+                  .value("status", ""), "error");
+
+    // Dates past the clock's range clamp instead of overflowing.
+    auto wide = client.request({{"type", "get_trades"}, {"token", token}, {"all", true},
+                                {"from_date", INT64_MIN}, {"to_date", INT64_MAX}});
+    ASSERT_EQ(wide.value("status", ""), "ok");
+    EXPECT_EQ(wide["trades"].size(), kTrades);
+    auto late = client.request({{"type", "get_trades"}, {"token", token}, {"from_date", INT64_MAX - 1}});
+    ASSERT_EQ(late.value("status", ""), "ok");
+    EXPECT_TRUE(late["trades"].empty());
 }
 
 TEST_F(NetworkFixture, CloseAccountBlockedByOpenStockPositions) {
@@ -625,6 +727,265 @@ TEST_F(NetworkFixture, PriceEngineChangesQuotesOverTime) {
     ASSERT_TRUE(changed);
 }
 
+TEST_F(NetworkFixture, BatchTransferOverTcp) {
+    TestClient client;
+    client.connect(port());
+
+    ASSERT_EQ(client.request({{"type", "register"}, {"username", "batch_alice"}, {"password", "pass123"}})
+                  .value("status", ""), "ok");
+    auto login = client.request({{"type", "login"}, {"username", "batch_alice"}, {"password", "pass123"}});
+    ASSERT_EQ(login.value("status", ""), "ok");
+    std::string token = login["token"].get<std::string>();
+
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 3; ++i) {
+        auto create = client.request({{"type", "create_account"}, {"token", token}, {"currency", "RUB"}});
+        ASSERT_EQ(create.value("status", ""), "ok");
+        ids.push_back(create["account_id"].get<uint64_t>());
+    }
+    ASSERT_EQ(client.request({{"type", "deposit"}, {"token", token}, {"account_id", ids[0]}, {"amount", 100.0}})
+                  .value("status", ""), "ok");
+
+    auto too_much = client.request({
+        {"type", "batch_transfer"},
+        {"token", token},
+        {"legs", {
+            {{"from_account", ids[0]}, {"to_account", ids[1]}, {"amount", 60.0}},
+            {{"from_account", ids[0]}, {"to_account", ids[2]}, {"amount", 60.0}}
+        }}
+    });
+    ASSERT_EQ(too_much.value("status", ""), "error");
+
+    auto batch = client.request({
+        {"type", "batch_transfer"},
+        {"token", token},
+        {"legs", {
+            {{"from_account", ids[0]}, {"to_account", ids[1]}, {"amount", 60.0}},
+            {{"from_account", ids[0]}, {"to_account", ids[2]}, {"amount", 40.0}}
+        }}
+    });
+    ASSERT_EQ(batch.value("status", ""), "ok");
+    ASSERT_EQ(batch["results"].size(), 2u);
+    ASSERT_DOUBLE_EQ(batch["results"][1]["from_balance"].get<double>(), 0.0);
+    ASSERT_DOUBLE_EQ(batch["results"][1]["to_balance"].get<double>(), 40.0);
+}
+
+TEST_F(NetworkFixture, IncomingTransferIsPushedToEveryRecipientSession) {
+    auto sign_in = [&](TestClient& client, const std::string& name) {
+        client.connect(port());
+        client.request({{"type", "register"}, {"username", name}, {"password", "pass123"}});
+        auto login = client.request({{"type", "login"}, {"username", name}, {"password", "pass123"}});
+        return login.value("token", "");
+    };
+    TestClient alice, bob, bob_phone;
+    const auto alice_token = sign_in(alice, "push_alice");
+    const auto bob_token = sign_in(bob, "push_bob");
+    sign_in(bob_phone, "push_bob");
+
+    auto from = alice.request({{"type", "create_account"}, {"token", alice_token}, {"currency", "RUB"}});
+    auto to = bob.request({{"type", "create_account"}, {"token", bob_token}, {"currency", "RUB"}});
+    const auto from_id = from["account_id"].get<uint64_t>();
+    const auto to_id = to["account_id"].get<uint64_t>();
+    ASSERT_EQ(alice.request({{"type", "deposit"}, {"token", alice_token}, {"account_id", from_id}, {"amount", 1000.0}})
+                  .value("status", ""), "ok");
+
+    ASSERT_EQ(alice.request({{"type", "transfer"}, {"token", alice_token}, {"from_account", from_id},
+                             {"to_account", to_id}, {"amount", 500.0}}).value("status", ""), "ok");
+    for (auto* client : {&bob, &bob_phone}) {
+        auto push = client->next_notification();
+        ASSERT_EQ(push.value("event", ""), "incoming_transfer");
+        ASSERT_EQ(push["from_user"].get<std::string>(), "push_alice");
+        ASSERT_DOUBLE_EQ(push["amount"].get<double>(), 500.0);
+        ASSERT_EQ(push["currency"].get<std::string>(), "RUB");
+        ASSERT_EQ(push["account_id"].get<uint64_t>(), to_id);
+    }
+
+    auto batch = alice.request({
+        {"type", "batch_transfer"}, {"token", alice_token},
+        {"legs", {{{"from_account", from_id}, {"to_account", to_id}, {"amount", 200.0}}}}
+    });
+    ASSERT_EQ(batch.value("status", ""), "ok");
+    ASSERT_DOUBLE_EQ(bob.next_notification()["amount"].get<double>(), 200.0);
+
+    // The sender is told nothing.
+    ASSERT_EQ(alice.request({{"type", "get_accounts"}, {"token", alice_token}}).value("status", ""), "ok");
+    ASSERT_EQ(alice.buffered_notifications(), 0u);
+}
+
+TEST_F(NetworkFixture, LogoutUnbindsOnlyTheSessionsOfThatToken) {
+    auto sign_in = [&](TestClient& client, const std::string& name) {
+        client.connect(port());
+        client.request({{"type", "register"}, {"username", name}, {"password", "pass123"}});
+        auto login = client.request({{"type", "login"}, {"username", name}, {"password", "pass123"}});
+        return login.value("token", "");
+    };
+    TestClient alice, bob, bob_phone;
+    const auto alice_token = sign_in(alice, "unbind_alice");
+    const auto bob_token = sign_in(bob, "unbind_bob");
+    const auto phone_token = sign_in(bob_phone, "unbind_bob");
+
+    // A failed logout leaves the session bound; logging the phone's token out
+    // from the desk unbinds the phone, not the desk.
+    ASSERT_EQ(bob.request({{"type", "logout"}, {"token", "not-a-token"}}).value("status", ""), "error");
+    ASSERT_EQ(bob.request({{"type", "logout"}, {"token", phone_token}}).value("status", ""), "ok");
+
+    auto from = alice.request({{"type", "create_account"}, {"token", alice_token}, {"currency", "RUB"}});
+    auto to = bob.request({{"type", "create_account"}, {"token", bob_token}, {"currency", "RUB"}});
+    const auto from_id = from["account_id"].get<uint64_t>();
+    const auto to_id = to["account_id"].get<uint64_t>();
+    ASSERT_EQ(alice.request({{"type", "deposit"}, {"token", alice_token}, {"account_id", from_id}, {"amount", 100.0}})
+                  .value("status", ""), "ok");
+    ASSERT_EQ(alice.request({{"type", "transfer"}, {"token", alice_token}, {"from_account", from_id},
+                             {"to_account", to_id}, {"amount", 50.0}}).value("status", ""), "ok");
+
+    ASSERT_EQ(bob.next_notification().value("event", ""), "incoming_transfer");
+    // The response comes after any push queued before it.
+    ASSERT_EQ(bob_phone.request({{"type", "logout"}, {"token", phone_token}}).value("status", ""), "error");
+    ASSERT_EQ(bob_phone.buffered_notifications(), 0u);
+}
+
+TEST_F(NetworkFixture, LimitOrderFillIsPushedToTheOwner) {
+    TestClient client;
+    client.connect(port());
+
+    ASSERT_EQ(client.request({{"type", "register"}, {"username", "order_alice"}, {"password", "pass123"}})
+                  .value("status", ""), "ok");
+    auto login = client.request({{"type", "login"}, {"username", "order_alice"}, {"password", "pass123"}});
+    ASSERT_EQ(login.value("status", ""), "ok");
+    std::string token = login["token"].get<std::string>();
+    auto create = client.request({{"type", "create_account"}, {"token", token}, {"currency", "USD"}});
+    uint64_t account_id = create["account_id"].get<uint64_t>();
+    ASSERT_EQ(client.request({{"type", "deposit"}, {"token", token}, {"account_id", account_id}, {"amount", 10000.0}})
+                  .value("status", ""), "ok");
+
+    auto resting = client.request({
+        {"type", "place_order"}, {"token", token}, {"ticker", "AAPL"}, {"side", "buy"},
+        {"price", 1.0}, {"quantity", 1}, {"account_id", account_id}
+    });
+    ASSERT_EQ(resting.value("status", ""), "ok");
+    ASSERT_EQ(resting["remaining"].get<int>(), 1);
+    auto amended = client.request({
+        {"type", "amend_order"}, {"token", token}, {"order_id", resting["order_id"]}, {"price", 2.0}
+    });
+    ASSERT_EQ(amended.value("status", ""), "ok");
+    ASSERT_EQ(client.request({{"type", "cancel_order"}, {"token", token}, {"order_id", resting["order_id"]}})
+                  .value("status", ""), "ok");
+    ASSERT_EQ(client.request({{"type", "cancel_order"}, {"token", token}, {"order_id", resting["order_id"]}})
+                  .value("message", ""), "Order not found");
+
+    // A bid far through the market fills at the quote on the next tick.
+    auto placed = client.request({
+        {"type", "place_order"}, {"token", token}, {"ticker", "AAPL"}, {"side", "buy"},
+        {"price", 5000.0}, {"quantity", 2}, {"account_id", account_id}
+    });
+    ASSERT_EQ(placed.value("status", ""), "ok");
+
+    auto fill = client.next_notification();
+    ASSERT_EQ(fill.value("event", ""), "order_fill");
+    ASSERT_EQ(fill["order_id"], placed["order_id"]);
+    ASSERT_EQ(fill["ticker"].get<std::string>(), "AAPL");
+    ASSERT_EQ(fill["side"].get<std::string>(), "buy");
+    ASSERT_EQ(fill["quantity"].get<int>(), 2);
+    ASSERT_EQ(fill["remaining"].get<int>(), 0);
+    ASSERT_LT(fill["price"].get<double>(), 5000.0);
+
+    auto portfolio = client.request({{"type", "get_portfolio"}, {"token", token}});
+    ASSERT_EQ(portfolio["positions"][0]["quantity"].get<int>(), 2);
+}
+
+// A server whose engine is stepped by the test: JUMP swings up to 30% a
+// tick, CALM never moves.
+class AlertFixture : public ::testing::Test {
+protected:
+    static Universe universe() {
+        Universe u;
+        u.currencies = {{"USD", 1.0, 0.0}};
+        u.instruments = {{"JUMP", 100.0, 0.3}, {"CALM", 100.0, 0.0}};
+        return u;
+    }
+
+    void SetUp() override {
+        server_ = std::make_unique<TcpServer>(boost::asio::ip::make_address("127.0.0.1"), 0, 2, dispatcher_);
+        server_thread_ = std::thread([this] { server_->run(); });
+        ASSERT_TRUE(wait_for_server(server_->port(), std::chrono::seconds(2)));
+    }
+
+    void TearDown() override {
+        if (server_) server_->stop();
+        if (server_thread_.joinable()) server_thread_.join();
+    }
+
+    // Registers and logs in `name`, opens a funded USD account; returns the token.
+    std::string sign_in(TestClient& client, const std::string& name, uint64_t& account_id) {
+        client.connect(server_->port());
+        client.request({{"type", "register"}, {"username", name}, {"password", "pass123"}});
+        auto login = client.request({{"type", "login"}, {"username", name}, {"password", "pass123"}});
+        std::string token = login.value("token", "");
+        account_id = client.request({{"type", "create_account"}, {"token", token}, {"currency", "USD"}})
+                         .value("account_id", uint64_t{0});
+        client.request({{"type", "deposit"}, {"token", token}, {"account_id", account_id}, {"amount", 100000.0}});
+        return token;
+    }
+
+    AuthService auth_;
+    BankService bank_;
+    PriceEngine prices_{universe(), [] { SimulationConfig c; c.seed = 5; return c; }()};
+    StockService stock_{bank_, prices_};
+    CommandDispatcher dispatcher_{auth_, bank_, stock_, prices_};
+    PriceAlerts alerts_{stock_, prices_, dispatcher_.sessions()};
+    std::unique_ptr<TcpServer> server_;
+    std::thread server_thread_;
+};
+
+TEST_F(AlertFixture, BigMovesArePushedToConnectedHoldersOnly) {
+    const SymbolId jump = *prices_.symbols().find("JUMP");
+    const SymbolId calm = *prices_.symbols().find("CALM");
+    TestClient alice, bob;
+    uint64_t alice_acc = 0, bob_acc = 0;
+    const auto alice_token = sign_in(alice, "alert_alice", alice_acc);
+    const auto bob_token = sign_in(bob, "alert_bob", bob_acc);
+
+    for (const char* ticker : {"JUMP", "CALM"}) {
+        ASSERT_EQ(alice.request({{"type", "buy_stock"}, {"token", alice_token}, {"ticker", ticker},
+                                 {"quantity", 1}, {"account_id", alice_acc}}).value("status", ""), "ok");
+    }
+    EXPECT_EQ(alerts_.watchers(jump), 1u);
+    EXPECT_EQ(alerts_.watchers(calm), 1u);
+
+    double old_price = 0, new_price = 0;
+    for (int i = 0; i < 100 && old_price == 0; ++i) {
+        const double before = prices_.get_quote(jump);
+        prices_.step();
+        const double after = prices_.get_quote(jump);
+        if (std::abs(after - before) >= 0.05 * before) old_price = before, new_price = after;
+    }
+    ASSERT_GT(old_price, 0.0);
+
+    auto alert = alice.next_notification();
+    ASSERT_EQ(alert.value("event", ""), "price_alert");
+    ASSERT_EQ(alert["ticker"].get<std::string>(), "JUMP");
+    ASSERT_DOUBLE_EQ(alert["old_price"].get<double>(), old_price);
+    ASSERT_DOUBLE_EQ(alert["new_price"].get<double>(), new_price);
+    ASSERT_NEAR(alert["change_pct"].get<double>(), (new_price - old_price) / old_price * 100.0, 1e-9);
+
+    // Bob holds nothing: the pushes queued before this response would be buffered.
+    ASSERT_EQ(bob.request({{"type", "get_portfolio"}, {"token", bob_token}}).value("status", ""), "ok");
+    EXPECT_EQ(bob.buffered_notifications(), 0u);
+
+    // Closing a position and logging out both leave the index.
+    ASSERT_EQ(alice.request({{"type", "sell_stock"}, {"token", alice_token}, {"ticker", "JUMP"},
+                             {"quantity", 1}, {"account_id", alice_acc}}).value("status", ""), "ok");
+    EXPECT_EQ(alerts_.watchers(jump), 0u);
+    ASSERT_EQ(alice.request({{"type", "logout"}, {"token", alice_token}}).value("status", ""), "ok");
+    EXPECT_EQ(alerts_.watchers(calm), 0u);
+
+    // Logging back in restores the holdings still open.
+    auto login = alice.request({{"type", "login"}, {"username", "alert_alice"}, {"password", "pass123"}});
+    ASSERT_EQ(login.value("status", ""), "ok");
+    EXPECT_EQ(alerts_.watchers(calm), 1u);
+    EXPECT_EQ(alerts_.watchers(jump), 0u);
+}
+
 TEST_F(NetworkFixture, UnknownCommandReturnsError) {
     TestClient client;
     client.connect(port());
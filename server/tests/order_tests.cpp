@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include "order_book.hpp"
+#include "order_service.hpp"
+#include "trigger_service.hpp"
+#include "universe.hpp"
+
+TEST(OrderBook, MatchesByPriceThenTime) {
+    OrderBook book;
+    std::vector<BookFill> fills;
+    book.add(Side::Sell, 101, 5, 1, fills);
+    book.add(Side::Sell, 100, 5, 2, fills);
+    book.add(Side::Sell, 100, 5, 3, fills);
+    EXPECT_EQ(book.best_ask(), 100);
+    EXPECT_FALSE(book.best_bid());
+
+    EXPECT_EQ(book.add(Side::Buy, 101, 12, 9, fills), kNoOrder);
+    ASSERT_EQ(fills.size(), 3u);
+    EXPECT_EQ(fills[0].maker_tag, 2u);
+    EXPECT_EQ(fills[0].price, 100);
+    EXPECT_EQ(fills[1].maker_tag, 3u);
+    EXPECT_EQ(fills[2].maker_tag, 1u);
+    EXPECT_EQ(fills[2].price, 101);
+    EXPECT_EQ(fills[2].quantity, 2);
+    EXPECT_EQ(fills[2].maker_left, 3);
+    EXPECT_EQ(fills[2].taker_tag, 9u);
+    EXPECT_EQ(book.size(), 1u);
+
+    // A bid below the best ask rests.
+    fills.clear();
+    auto bid = book.add(Side::Buy, 99, 4, 10, fills);
+    EXPECT_NE(bid, kNoOrder);
+    EXPECT_TRUE(fills.empty());
+    EXPECT_EQ(book.best_bid(), 99);
+}
+
+TEST(OrderBook, CancelAndReduce) {
+    OrderBook book;
+    std::vector<BookFill> fills;
+    auto a = book.add(Side::Buy, 50, 10, 1, fills);
+    auto b = book.add(Side::Buy, 50, 10, 2, fills);
+    auto c = book.add(Side::Buy, 49, 10, 3, fills);
+
+    EXPECT_TRUE(book.reduce(a, 4));
+    EXPECT_FALSE(book.reduce(a, 8));  // only down
+    EXPECT_TRUE(book.cancel(c));
+    EXPECT_FALSE(book.cancel(c));
+    EXPECT_FALSE(book.find(c));
+
+    // The freed slot is reused; the old handle must not reach the new order.
+    auto d = book.add(Side::Buy, 48, 1, 4, fills);
+    EXPECT_FALSE(book.cancel(c));
+    EXPECT_TRUE(book.find(d));
+
+    // Reducing kept `a` first in the queue.
+    book.add(Side::Sell, 50, 5, 5, fills);
+    ASSERT_EQ(fills.size(), 2u);
+    EXPECT_EQ(fills[0].maker_tag, 1u);
+    EXPECT_EQ(fills[0].quantity, 4);
+    EXPECT_EQ(fills[1].maker_tag, 2u);
+    EXPECT_EQ(book.find(b)->remaining, 9);
+}
+
+TEST(OrderBook, SweepFillsEverythingThatCrossesAtTheMarket) {
+    OrderBook book;
+    std::vector<BookFill> fills;
+    book.add(Side::Buy, 105, 3, 1, fills);
+    book.add(Side::Buy, 100, 3, 2, fills);
+    book.add(Side::Buy, 99, 3, 3, fills);
+    book.add(Side::Sell, 110, 3, 4, fills);
+
+    book.sweep(100, fills);
+    ASSERT_EQ(fills.size(), 2u);
+    EXPECT_EQ(fills[0].maker_tag, 1u);
+    EXPECT_EQ(fills[0].price, 100);
+    EXPECT_EQ(fills[0].taker_tag, 0u);
+    EXPECT_EQ(fills[1].maker_tag, 2u);
+    EXPECT_EQ(book.best_bid(), 99);
+
+    fills.clear();
+    book.sweep(111, fills);
+    ASSERT_EQ(fills.size(), 1u);
+    EXPECT_EQ(fills[0].maker_tag, 4u);
+    EXPECT_EQ(fills[0].maker_side, Side::Sell);
+    EXPECT_FALSE(book.best_ask());
+    EXPECT_EQ(book.size(), 1u);
+}
+
+TEST(OrderBook, DeepCancelsLeaveTheBookConsistent) {
+    OrderBook book;
+    std::vector<BookFill> fills;
+    std::vector<OrderHandle> handles;
+    for (int i = 0; i < 1000; ++i) handles.push_back(book.add(Side::Sell, 1000 + i, 1, i, fills));
+    // Cancel every level but the best and the worst, deepest first and not at the back.
+    for (int i = 998; i >= 1; --i) EXPECT_TRUE(book.cancel(handles[i]));
+    EXPECT_EQ(book.best_ask(), 1000);
+    EXPECT_EQ(book.size(), 2u);
+
+    // Levels come back at their old prices and are matched in order.
+    book.add(Side::Sell, 1500, 1, 5000, fills);
+    book.add(Side::Buy, 2000, 3, 1, fills);
+    ASSERT_EQ(fills.size(), 3u);
+    EXPECT_EQ(fills[0].price, 1000);
+    EXPECT_EQ(fills[1].price, 1500);
+    EXPECT_EQ(fills[2].price, 1999);
+    EXPECT_EQ(book.size(), 0u);
+    EXPECT_FALSE(book.best_ask());
+}
+
+TEST(OrderBook, RestoreUndoesFillsInQueueOrder) {
+    OrderBook book;
+    std::vector<BookFill> fills;
+    auto a = book.add(Side::Sell, 100, 2, 1, fills);
+    book.add(Side::Sell, 100, 2, 2, fills);
+    auto c = book.add(Side::Sell, 100, 5, 3, fills);
+    book.add(Side::Sell, 100, 1, 4, fills);
+
+    // Takes all of 1 and 2 and part of 3, then is undone last fill first.
+    book.add(Side::Buy, 100, 6, 9, fills);
+    ASSERT_EQ(fills.size(), 3u);
+    EXPECT_EQ(book.find(c)->remaining, 3);
+    for (auto it = fills.rbegin(); it != fills.rend(); ++it) {
+        const auto handle = it->maker_tag == 3 ? c : a;
+        EXPECT_NE(book.restore(handle, it->maker_side, it->price, it->quantity, it->maker_tag), kNoOrder);
+    }
+    EXPECT_EQ(book.find(c)->remaining, 5);
+    EXPECT_EQ(book.size(), 4u);
+
+    fills.clear();
+    book.add(Side::Buy, 100, 10, 10, fills);
+    ASSERT_EQ(fills.size(), 4u);
+    for (std::size_t i = 0; i < fills.size(); ++i) EXPECT_EQ(fills[i].maker_tag, i + 1);
+    EXPECT_EQ(fills[2].quantity, 5);
+}
+
+class OrderServiceTest : public ::testing::Test {
+protected:
+    static Universe flat() {
+        Universe u;
+        u.currencies = {{"USD", 1.0, 0.0}};
+        u.instruments = {{"FLAT", 100.0, 0.0}};
+        return u;
+    }
+
+    BankService bank;
+    PriceEngine prices{flat()};
+    StockService stocks{bank, prices};
+    OrderService orders{bank, stocks, prices};
+    std::vector<OrderEvent> events;
+    const SymbolId flat_id = 0;
+    uint64_t alice = 1, bob = 2, alice_acc = 0, bob_acc = 0;
+
+    void SetUp() override {
+        orders.on_event([this](const OrderEvent& e) { events.push_back(e); });
+        alice_acc = bank.create_account(alice, Currency::USD);
+        bob_acc = bank.create_account(bob, Currency::USD);
+        bank.deposit(alice, alice_acc, 10000);
+        bank.deposit(bob, bob_acc, 10000);
+    }
+};
+
+TEST_F(OrderServiceTest, CrossingOrdersSettleAtTheRestingPrice) {
+    ASSERT_TRUE(stocks.buy(alice, flat_id, 10, alice_acc));
+    auto ask = orders.place(alice, flat_id, Side::Sell, 102.0, 5, alice_acc);
+    ASSERT_TRUE(ask);
+    EXPECT_EQ(ask->remaining, 5);
+
+    auto bid = orders.place(bob, flat_id, Side::Buy, 103.0, 3, bob_acc);
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(bid->filled, 3);
+    EXPECT_EQ(bid->remaining, 0);
+    EXPECT_FALSE(orders.find(bob, bid->order_id));
+    EXPECT_EQ(orders.find(alice, ask->order_id)->remaining, 2);
+
+    ASSERT_EQ(stocks.get_portfolio(bob).size(), 1u);
+    EXPECT_EQ(stocks.get_portfolio(bob)[0].quantity, 3);
+    EXPECT_DOUBLE_EQ(stocks.get_trades(bob).trades[0].price, 102.0);
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(bob_acc)->balance, 10000 - 3 * 102.0);
+    EXPECT_EQ(stocks.get_portfolio(alice)[0].quantity, 7);
+
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].order_id, ask->order_id);
+    EXPECT_EQ(events[0].remaining, 2);
+    EXPECT_EQ(events[1].order_id, bid->order_id);
+    EXPECT_EQ(events[1].kind, OrderEvent::Kind::Fill);
+}
+
+TEST_F(OrderServiceTest, TicksFillOrdersThatCrossTheQuote) {
+    auto through = orders.place(bob, flat_id, Side::Buy, 101.0, 2, bob_acc);
+    auto below = orders.place(bob, flat_id, Side::Buy, 99.0, 2, bob_acc);
+    ASSERT_TRUE(through && below);
+    EXPECT_TRUE(events.empty());
+
+    prices.step();
+    EXPECT_FALSE(orders.find(bob, through->order_id));
+    EXPECT_TRUE(orders.find(bob, below->order_id));
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_DOUBLE_EQ(events[0].price, 100.0);
+    EXPECT_EQ(events[0].remaining, 0);
+    EXPECT_EQ(stocks.get_portfolio(bob)[0].quantity, 2);
+}
+
+TEST_F(OrderServiceTest, CancelAndAmendOwnOrdersOnly) {
+    auto bid = orders.place(bob, flat_id, Side::Buy, 90.0, 10, bob_acc);
+    ASSERT_TRUE(bid);
+    EXPECT_FALSE(orders.cancel(alice, bid->order_id));
+    EXPECT_FALSE(orders.amend(alice, bid->order_id, 90.0, 5));
+
+    auto reduced = orders.amend(bob, bid->order_id, 90.0, 4);
+    ASSERT_TRUE(reduced);
+    EXPECT_EQ(reduced->remaining, 4);
+
+    // Repricing through the market fills on the next tick.
+    auto moved = orders.amend(bob, bid->order_id, 100.5, 4);
+    ASSERT_TRUE(moved);
+    EXPECT_DOUBLE_EQ(orders.find(bob, bid->order_id)->price, 100.5);
+    prices.step();
+    EXPECT_FALSE(orders.find(bob, bid->order_id));
+    EXPECT_FALSE(orders.cancel(bob, bid->order_id));
+
+    auto other = orders.place(bob, flat_id, Side::Buy, 90.0, 1, bob_acc);
+    EXPECT_TRUE(orders.cancel(bob, other->order_id));
+    EXPECT_FALSE(orders.find(bob, other->order_id));
+}
+
+TEST_F(OrderServiceTest, FailedSettlementRejectsTheRemainder) {
+    // Alice has no shares, so her ask cannot settle when it is hit.
+    auto ask = orders.place(alice, flat_id, Side::Sell, 99.0, 5, alice_acc);
+    ASSERT_TRUE(ask);
+    prices.step();
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].kind, OrderEvent::Kind::Rejected);
+    EXPECT_FALSE(orders.find(alice, ask->order_id));
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(alice_acc)->balance, 10000.0);
+
+    EXPECT_FALSE(orders.place(alice, flat_id, Side::Buy, 100.0, 1, bob_acc));  // not her account
+    EXPECT_FALSE(orders.place(alice, flat_id, Side::Buy, 0.0, 1, alice_acc));
+    EXPECT_FALSE(orders.place(alice, flat_id, Side::Buy, 100.0, 0, alice_acc));
+}
+
+TEST_F(OrderServiceTest, UnfundedTakerLeavesTheMakersResting) {
+    ASSERT_TRUE(stocks.buy(alice, flat_id, 10, alice_acc));
+    const double alice_cash = bank.get_account_summary(alice_acc)->balance;
+    auto first = orders.place(alice, flat_id, Side::Sell, 102.0, 3, alice_acc);
+    auto second = orders.place(alice, flat_id, Side::Sell, 103.0, 2, alice_acc);
+    ASSERT_TRUE(first && second);
+
+    const uint64_t carol = 3;
+    const uint64_t carol_acc = bank.create_account(carol, Currency::USD);
+    bank.deposit(carol, carol_acc, 100);
+    auto bid = orders.place(carol, flat_id, Side::Buy, 103.0, 5, carol_acc);
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(bid->filled, 0);
+    EXPECT_EQ(bid->remaining, 0);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].kind, OrderEvent::Kind::Rejected);
+    EXPECT_EQ(events[0].order_id, bid->order_id);
+
+    // Nobody's cash or shares moved and both asks still rest in full.
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(carol_acc)->balance, 100.0);
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(alice_acc)->balance, alice_cash);
+    EXPECT_TRUE(stocks.get_portfolio(carol).empty());
+    EXPECT_EQ(stocks.get_portfolio(alice)[0].quantity, 10);
+    EXPECT_EQ(stocks.get_trades(alice).trades.size(), 1u);
+    EXPECT_EQ(orders.find(alice, first->order_id)->remaining, 3);
+    EXPECT_EQ(orders.find(alice, second->order_id)->remaining, 2);
+
+    // And keep their priority: the cheaper ask fills first.
+    auto funded = orders.place(bob, flat_id, Side::Buy, 103.0, 4, bob_acc);
+    ASSERT_TRUE(funded);
+    EXPECT_EQ(funded->filled, 4);
+    EXPECT_FALSE(orders.find(alice, first->order_id));
+    EXPECT_EQ(orders.find(alice, second->order_id)->remaining, 1);
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(bob_acc)->balance, 10000 - 3 * 102.0 - 103.0);
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(alice_acc)->balance, alice_cash + 3 * 102.0 + 103.0);
+}
+
+TEST_F(OrderServiceTest, TakerSkipsAMakerThatCannotDeliver) {
+    // Alice's ask is ahead but she holds nothing; bob's is behind it.
+    ASSERT_TRUE(stocks.buy(bob, flat_id, 5, bob_acc));
+    auto empty = orders.place(alice, flat_id, Side::Sell, 101.0, 5, alice_acc);
+    auto held = orders.place(bob, flat_id, Side::Sell, 102.0, 5, bob_acc);
+    ASSERT_TRUE(empty && held);
+
+    const uint64_t carol = 3;
+    const uint64_t carol_acc = bank.create_account(carol, Currency::USD);
+    bank.deposit(carol, carol_acc, 1000);
+    auto bid = orders.place(carol, flat_id, Side::Buy, 102.0, 5, carol_acc);
+    ASSERT_TRUE(bid);
+    EXPECT_EQ(bid->filled, 5);
+    EXPECT_EQ(bid->remaining, 0);
+    EXPECT_FALSE(orders.find(alice, empty->order_id));
+    EXPECT_FALSE(orders.find(bob, held->order_id));
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(carol_acc)->balance, 1000 - 5 * 102.0);
+    EXPECT_EQ(stocks.get_portfolio(carol)[0].quantity, 5);
+    EXPECT_TRUE(stocks.get_portfolio(bob).empty());
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(alice_acc)->balance, 10000.0);
+    ASSERT_FALSE(events.empty());
+    EXPECT_EQ(events[0].kind, OrderEvent::Kind::Rejected);
+    EXPECT_EQ(events[0].order_id, empty->order_id);
+}
+
+TEST_F(OrderServiceTest, TriggersFireOnlyWhenCrossed) {
+    TriggerService triggers(bank, stocks, prices);
+    std::vector<TriggerEvent> fired;
+    triggers.on_fire([&](const TriggerEvent& e) { fired.push_back(e); });
+    ASSERT_TRUE(stocks.buy(alice, flat_id, 10, alice_acc));
+
+    auto stop = triggers.arm(alice, flat_id, TriggerKind::StopLoss, 100.5, 3, alice_acc);
+    auto take = triggers.arm(alice, flat_id, TriggerKind::TakeProfit, 99.0, 2, alice_acc);
+    auto far_stop = triggers.arm(alice, flat_id, TriggerKind::StopLoss, 90.0, 1, alice_acc);
+    auto far_take = triggers.arm(alice, flat_id, TriggerKind::TakeProfit, 110.0, 1, alice_acc);
+    ASSERT_TRUE(stop && take && far_stop && far_take);
+    EXPECT_FALSE(triggers.arm(alice, flat_id, TriggerKind::StopLoss, 95.0, 1, bob_acc));
+    EXPECT_FALSE(triggers.arm(alice, flat_id, TriggerKind::StopLoss, -1.0, 1, alice_acc));
+    EXPECT_EQ(triggers.armed(), 4u);
+
+    prices.step();
+    ASSERT_EQ(fired.size(), 2u);
+    EXPECT_EQ(fired[0].trigger_id, *stop);
+    EXPECT_EQ(fired[0].kind, TriggerKind::StopLoss);
+    EXPECT_DOUBLE_EQ(fired[0].trigger_price, 100.5);
+    ASSERT_TRUE(fired[0].sale);
+    EXPECT_DOUBLE_EQ(fired[0].sale->price, 100.0);
+    EXPECT_EQ(fired[1].trigger_id, *take);
+    EXPECT_EQ(stocks.get_portfolio(alice)[0].quantity, 5);
+    EXPECT_EQ(triggers.armed(), 2u);
+
+    EXPECT_FALSE(triggers.cancel(alice, *stop));  // already fired
+    EXPECT_FALSE(triggers.cancel(bob, *far_stop));
+    EXPECT_TRUE(triggers.cancel(alice, *far_stop));
+    EXPECT_EQ(triggers.armed(), 1u);
+
+    // A trigger for more shares than are left still fires and reports the failed sell.
+    auto oversized = triggers.arm(alice, flat_id, TriggerKind::StopLoss, 101.0, 50, alice_acc);
+    ASSERT_TRUE(oversized);
+    prices.step();
+    ASSERT_EQ(fired.size(), 3u);
+    EXPECT_FALSE(fired[2].sale);
+    EXPECT_EQ(stocks.get_portfolio(alice)[0].quantity, 5);
+}
@@ -0,0 +1,464 @@
+#include <gtest/gtest.h>
+#include "market_recorder.hpp"
+#include "price_engine.hpp"
+#include "price_kernel.hpp"
+#include "universe.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+std::vector<double> flat(std::size_t n, double value) { return std::vector<double>(n, value); }
+
+}  // namespace
+
+TEST(PriceKernel, AvxMatchesScalarBitForBit) {
+    for (std::size_t n : {1u, 3u, 4u, 7u, 1000u, 1003u}) {
+        auto scalar = flat(n, 100.0), vector = flat(n, 100.0);
+        auto amplitude = flat(n, 0.03);
+        WalkRng a(42), b(42);
+        for (int tick = 0; tick < 50; tick++) {
+            detail::random_walk_step_scalar(scalar.data(), amplitude.data(), n, a);
+            if (!detail::random_walk_step_avx2(vector.data(), amplitude.data(), n, b))
+                GTEST_SKIP() << "no AVX2 on this CPU";
+        }
+        EXPECT_EQ(std::memcmp(scalar.data(), vector.data(), n * sizeof(double)), 0) << "n=" << n;
+    }
+}
+
+TEST(PriceKernel, MovesStayWithinAmplitude) {
+    const std::size_t n = 4096;
+    auto prices = flat(n, 100.0);
+    std::vector<double> amplitude(n);
+    for (std::size_t i = 0; i < n; i++) amplitude[i] = i % 2 ? 0.03 : 0.0;
+    WalkRng rng(7);
+    random_walk_step(prices.data(), amplitude.data(), n, rng);
+
+    double up = 0, down = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(prices[i], 100.0);
+            continue;
+        }
+        EXPECT_GE(prices[i], 97.0);
+        EXPECT_LT(prices[i], 103.0);
+        (prices[i] > 100.0 ? up : down)++;
+    }
+    EXPECT_GT(up, n / 4 - n / 16);  // roughly symmetric
+    EXPECT_GT(down, n / 4 - n / 16);
+}
+
+TEST(PriceKernel, SameSeedSamePath) {
+    auto a = flat(100, 50.0), b = flat(100, 50.0);
+    auto amplitude = flat(100, 0.01);
+    WalkRng ra(9), rb(9);
+    for (int tick = 0; tick < 10; tick++) {
+        random_walk_step(a.data(), amplitude.data(), a.size(), ra);
+        random_walk_step(b.data(), amplitude.data(), b.size(), rb);
+    }
+    EXPECT_EQ(a, b);
+}
+
+TEST(PriceKernel, EngineKeepsUsdAsBase) {
+    PriceEngine prices;
+    prices.start();
+    while (prices.tick() < 2) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    prices.stop();
+    EXPECT_EQ(prices.get_rate(Currency::USD, Currency::USD), 1.0);
+    prices.read([](const MarketSnapshot& s) {
+        EXPECT_EQ(s.usd_rates[static_cast<std::size_t>(Currency::USD)], 1.0);
+    });
+}
+
+TEST(PriceEngine, ReadNeverHandsOutAReferenceIntoTheSnapshot) {
+    PriceEngine prices;
+    auto quotes = prices.read([](const MarketSnapshot& s) -> const std::vector<double>& { return s.quotes; });
+    static_assert(std::is_same_v<decltype(quotes), std::vector<double>>);
+    prices.step();  // retires the snapshot the lambda saw
+    EXPECT_EQ(quotes.size(), prices.symbols().size());
+}
+
+TEST(Universe, ParsesEntriesAndDefaults) {
+    std::istringstream in(
+        "# comment\n"
+        "currency USD 1\n"
+        "currency GBP 0.79 0.004  # trailing comment\n"
+        "\n"
+        "stock AAPL 178.5\n"
+        "stock BRK.B 410 0.01\n");
+    std::string error;
+    auto u = Universe::parse(in, error);
+    ASSERT_TRUE(u) << error;
+    ASSERT_EQ(u->currencies.size(), 2u);
+    EXPECT_EQ(u->currencies[1].code, "GBP");
+    EXPECT_DOUBLE_EQ(u->currencies[1].volatility, 0.004);
+    EXPECT_DOUBLE_EQ(u->currencies[0].volatility, 0.0);
+    ASSERT_EQ(u->instruments.size(), 2u);
+    EXPECT_DOUBLE_EQ(u->instruments[0].volatility, 0.03);
+    EXPECT_EQ(u->instruments[1].ticker, "BRK.B");
+}
+
+TEST(Universe, RejectsBadLines) {
+    for (const char* text : {
+             "stock AAPL 100\n",                      // no USD
+             "currency USD 2\n",                      // base must be 1
+             "currency USD 1\nstock AAPL -5\n",
+             "currency USD 1\nstock AAPL 1\nstock AAPL 2\n",
+             "currency USD 1\ncurrency usd 1\n",
+             "currency USD 1\nbond X 1\n",
+             "currency USD 1\nstock AAPL 10 0.1 extra\n",
+             "currency USD 1\nstock AAPL 10 abc\n",
+         }) {
+        std::istringstream in(text);
+        std::string error;
+        EXPECT_FALSE(Universe::parse(in, error)) << text;
+        EXPECT_FALSE(error.empty()) << text;
+    }
+}
+
+TEST(Universe, EngineQuotesLoadedUniverse) {
+    Universe u;
+    u.currencies = {{"USD", 1.0, 0.0}, {"GBP", 0.8, 0.005}, {"JPY", 150.0, 0.005}};
+    for (int i = 0; i < 5000; ++i) u.instruments.push_back({"S" + std::to_string(i), 10.0 + i, 0.02});
+
+    PriceEngine prices(u);
+    ASSERT_EQ(prices.symbols().size(), 5000u);
+    EXPECT_EQ(prices.get_quote("S4999"), 5009.0);
+    const auto gbp = currency_from_string("GBP"), jpy = currency_from_string("JPY");
+    ASSERT_TRUE(gbp && jpy);
+    EXPECT_EQ(to_string(*gbp), "GBP");
+    EXPECT_DOUBLE_EQ(prices.get_rate(*gbp, *jpy), 150.0 / 0.8);
+    EXPECT_TRUE(prices.quotes_currency(*gbp));
+    EXPECT_FALSE(prices.quotes_currency(Currency::RUB));  // built-in, but not in this universe
+    EXPECT_EQ(prices.get_rate(Currency::RUB, Currency::USD), 0.0);
+
+    prices.start();
+    while (prices.tick() < 2) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    prices.stop();
+    EXPECT_EQ(prices.get_rate(Currency::USD, Currency::USD), 1.0);
+    EXPECT_NE(prices.get_quote("S0"), 10.0);
+}
+
+TEST(Universe, CrossRatesMatchUsdRates) {
+    PriceEngine prices;
+    prices.start();
+    while (prices.tick() < 3) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    prices.stop();
+    prices.read([](const MarketSnapshot& s) {
+        const std::size_t n = s.usd_rates.size();
+        ASSERT_EQ(s.cross.size(), n * n);
+        for (std::size_t f = 0; f < n; ++f) {
+            for (std::size_t t = 0; t < n; ++t) {
+                const auto from = static_cast<Currency>(f), to = static_cast<Currency>(t);
+                if (f == t) EXPECT_EQ(s.rate(from, to), 1.0);
+                else if (s.usd_rates[f] > 0 && s.usd_rates[t] > 0) EXPECT_EQ(s.rate(from, to), s.usd_rates[t] / s.usd_rates[f]);
+                else EXPECT_EQ(s.rate(from, to), 0.0);
+            }
+        }
+        EXPECT_EQ(s.rate(static_cast<Currency>(n), Currency::USD), 0.0);
+    });
+}
+
+TEST(Replay, SameSeedSamePricePath) {
+    SimulationConfig config;
+    config.seed = 1234;
+    PriceEngine a(Universe::defaults(), config), b(Universe::defaults(), config);
+    EXPECT_EQ(a.seed(), 1234u);
+    for (int i = 0; i < 100; ++i) {
+        a.step();
+        b.step();
+    }
+    a.read([&](const MarketSnapshot& sa) {
+        b.read([&](const MarketSnapshot& sb) {
+            EXPECT_EQ(sa.tick, 100u);
+            EXPECT_EQ(sa.quotes, sb.quotes);
+            EXPECT_EQ(sa.usd_rates, sb.usd_rates);
+        });
+    });
+
+    config.seed = 1235;
+    PriceEngine c(Universe::defaults(), config);
+    for (int i = 0; i < 100; ++i) c.step();
+    EXPECT_NE(c.get_quote("AAPL"), a.get_quote("AAPL"));
+}
+
+TEST(Replay, FastRunMatchesManualSteps) {
+    SimulationConfig config;
+    config.seed = 99;
+    config.tick_interval = std::chrono::milliseconds(0);
+    config.max_ticks = 5000;
+    PriceEngine fast(Universe::defaults(), config);
+    const auto started = std::chrono::steady_clock::now();
+    fast.start();
+    while (fast.tick() < config.max_ticks) std::this_thread::yield();
+    fast.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(10));
+    EXPECT_EQ(fast.tick(), config.max_ticks);
+
+    PriceEngine stepped(Universe::defaults(), config);
+    while (stepped.step() < config.max_ticks) {}
+    for (const auto& [ticker, price] : fast.get_all_quotes()) EXPECT_EQ(stepped.get_quote(ticker), price) << ticker;
+    EXPECT_EQ(fast.get_rate(Currency::USD, Currency::RUB), stepped.get_rate(Currency::USD, Currency::RUB));
+}
+
+namespace {
+
+std::string temp_path(const char* name) {
+    return (std::filesystem::temp_directory_path() / (std::string("yellowcore_") + name)).string();
+}
+
+}  // namespace
+
+TEST(TickFile, RoundTripsBitExact) {
+    const auto path = temp_path("roundtrip.ytk");
+    std::string error;
+    std::vector<TickFrame> written;
+    {
+        auto writer = TickWriter::create(path, {"A", "B", "C"}, {"RUB", "USD"}, error, 64);
+        ASSERT_TRUE(writer) << error;
+        std::vector<double> quotes{100.0, 0.5, 1e-300}, rates{92.5, 1.0};
+        std::vector<double> amplitude{0.03, 0.03, 0.0};
+        WalkRng rng(3);
+        int64_t time = 1'700'000'000'000'000;
+        for (uint64_t tick = 1; tick <= 1000; ++tick) {
+            random_walk_step(quotes.data(), amplitude.data(), quotes.size(), rng);
+            time += tick % 7 ? 100'000 : 100'000 + static_cast<int64_t>(tick * 37);  // jitter
+            if (tick == 500) quotes[1] = -0.0;
+            writer->append(tick + tick / 100, time, quotes.data(), rates.data());
+            written.push_back({tick + tick / 100, time, quotes, rates});
+        }
+    }
+
+    auto reader = TickReader::open(path, error);
+    ASSERT_TRUE(reader) << error;
+    EXPECT_EQ(reader->tickers(), (std::vector<std::string>{"A", "B", "C"}));
+    EXPECT_EQ(reader->currencies(), (std::vector<std::string>{"RUB", "USD"}));
+    TickFrame frame;
+    for (const auto& expected : written) {
+        ASSERT_TRUE(reader->next(frame));
+        EXPECT_EQ(frame.tick, expected.tick);
+        EXPECT_EQ(frame.time_us, expected.time_us);
+        EXPECT_EQ(std::memcmp(frame.quotes.data(), expected.quotes.data(), 3 * sizeof(double)), 0);
+        EXPECT_EQ(frame.usd_rates, expected.usd_rates);
+    }
+    EXPECT_FALSE(reader->next(frame));
+    EXPECT_FALSE(reader->truncated());
+    // Constant series and a steady clock cost about a bit per frame each.
+    EXPECT_LT(std::filesystem::file_size(path), written.size() * (16 + 5 * 8) / 2);
+    std::filesystem::remove(path);
+}
+
+TEST(TickFile, TruncatedFileKeepsCompleteBlocks) {
+    const auto path = temp_path("truncated.ytk");
+    std::string error;
+    {
+        auto writer = TickWriter::create(path, {"A"}, {"USD"}, error, 10);
+        ASSERT_TRUE(writer) << error;
+        for (uint64_t tick = 1; tick <= 25; ++tick) {
+            const double quote = 100.0 + static_cast<double>(tick), rate = 1.0;
+            writer->append(tick, static_cast<int64_t>(tick) * 1000, &quote, &rate);
+        }
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+    auto reader = TickReader::open(path, error);
+    ASSERT_TRUE(reader) << error;
+    TickFrame frame;
+    uint64_t frames = 0;
+    while (reader->next(frame)) EXPECT_EQ(frame.tick, ++frames);
+    EXPECT_EQ(frames, 20u);
+    EXPECT_TRUE(reader->truncated());
+    std::filesystem::remove(path);
+
+    EXPECT_FALSE(TickReader::open(path, error));
+}
+
+TEST(TickFile, RecorderCapturesAndReplaysEngine) {
+    const auto path = temp_path("recorder.ytk");
+    SimulationConfig config;
+    config.seed = 77;
+    config.tick_interval = std::chrono::milliseconds(0);
+    config.max_ticks = 300;
+    {
+        PriceEngine prices(Universe::defaults(), config);
+        std::string error;
+        auto writer = create_tick_writer(prices, path, error);
+        ASSERT_TRUE(writer) << error;
+        MarketRecorder recorder(prices, std::move(writer), 512);
+        recorder.start();
+        prices.start();
+        while (prices.tick() < config.max_ticks) std::this_thread::yield();
+        prices.stop();
+        recorder.stop();
+        EXPECT_EQ(recorder.recorded(), config.max_ticks);
+        EXPECT_EQ(recorder.dropped(), 0u);
+    }
+
+    std::string error;
+    SimulationConfig replay;
+    replay.replay = TickReader::open(path, error);
+    ASSERT_TRUE(replay.replay) << error;
+    PriceEngine original(Universe::defaults(), config);
+    PriceEngine replayed(replay.replay->universe(), replay);
+    // The first recorded frame is tick 1; the replay opens on it.
+    original.step();
+    for (;;) {
+        for (const auto& [ticker, price] : original.get_all_quotes())
+            ASSERT_EQ(replayed.get_quote(ticker), price) << ticker << " at tick " << original.tick();
+        ASSERT_EQ(replayed.tick(), original.tick());
+        ASSERT_EQ(replayed.get_rate(Currency::USD, Currency::RUB), original.get_rate(Currency::USD, Currency::RUB));
+        if (replayed.step() == 0) break;
+        original.step();
+    }
+    EXPECT_EQ(original.tick(), config.max_ticks);
+    std::filesystem::remove(path);
+}
+
+TEST(TickFile, ReplayKeepsRecordedTickNumbers) {
+    const auto path = temp_path("gaps.ytk");
+    std::string error;
+    {
+        auto writer = TickWriter::create(path, {"A", "B"}, {"USD"}, error);
+        ASSERT_TRUE(writer) << error;
+        const double quotes[] = {100.0, 50.0}, rate = 1.0;
+        // A recorder that fell behind dropped ticks 4-6 and 8.
+        for (uint64_t tick : {3, 7, 9}) writer->append(tick, static_cast<int64_t>(tick) * 1000, quotes, &rate);
+    }
+
+    SimulationConfig config;
+    config.replay = TickReader::open(path, error);
+    ASSERT_TRUE(config.replay) << error;
+    PriceEngine replayed(config.replay->universe(), config);
+    EXPECT_EQ(replayed.tick(), 3u);
+    EXPECT_EQ(replayed.step(), 7u);
+    EXPECT_EQ(replayed.tick(), 7u);
+    EXPECT_EQ(replayed.step(), 9u);
+    EXPECT_EQ(replayed.step(), 0u);
+    EXPECT_EQ(replayed.tick(), 9u);
+    std::filesystem::remove(path);
+}
+
+namespace {
+
+TimePoint at_second(int64_t s, int ms = 0) {
+    return TimePoint(std::chrono::seconds(s) + std::chrono::milliseconds(ms));
+}
+
+}  // namespace
+
+TEST(Candles, AggregatesTicksIntoBars) {
+    CandleStore store(2, 8);
+    const int64_t t0 = 1'700'000'000 - 1'700'000'000 % 3600;  // hour boundary
+    store.update({10.0, 1.0}, at_second(t0));
+    store.update({12.0, 1.0}, at_second(t0, 400));
+    store.update({9.0, 1.0}, at_second(t0, 800));
+    store.update({11.0, 1.0}, at_second(t0 + 1));
+    store.update({10.5, 1.0}, at_second(t0 + 61));
+
+    auto s1 = store.range(0, CandleInterval::S1, INT64_MIN, INT64_MAX, 100);
+    ASSERT_EQ(s1.size(), 3u);
+    EXPECT_EQ(s1[0].start, t0);
+    EXPECT_EQ(s1[0].open, 10.0);
+    EXPECT_EQ(s1[0].high, 12.0);
+    EXPECT_EQ(s1[0].low, 9.0);
+    EXPECT_EQ(s1[0].close, 9.0);
+    EXPECT_EQ(s1[1].start, t0 + 1);
+    EXPECT_EQ(s1[2].start, t0 + 61);  // no bars for the idle seconds
+
+    auto m1 = store.range(0, CandleInterval::M1, INT64_MIN, INT64_MAX, 100);
+    ASSERT_EQ(m1.size(), 2u);
+    EXPECT_EQ(m1[0].close, 11.0);
+    EXPECT_EQ(m1[1].start, t0 + 60);
+
+    auto h1 = store.range(0, CandleInterval::H1, INT64_MIN, INT64_MAX, 100);
+    ASSERT_EQ(h1.size(), 1u);
+    EXPECT_EQ(h1[0].open, 10.0);
+    EXPECT_EQ(h1[0].high, 12.0);
+    EXPECT_EQ(h1[0].low, 9.0);
+    EXPECT_EQ(h1[0].close, 10.5);
+
+    EXPECT_EQ(store.range(1, CandleInterval::M5, INT64_MIN, INT64_MAX, 100).size(), 1u);
+    EXPECT_TRUE(store.range(2, CandleInterval::M5, INT64_MIN, INT64_MAX, 100).empty());
+}
+
+TEST(Candles, RingKeepsNewestAndRangesAreBounded) {
+    CandleStore store(1, 8);
+    const int64_t t0 = 1'700'000'000;
+    for (int64_t i = 0; i < 20; ++i) store.update({static_cast<double>(i)}, at_second(t0 + 2 * i));
+
+    auto all = store.range(0, CandleInterval::S1, INT64_MIN, INT64_MAX, 100);
+    ASSERT_EQ(all.size(), 8u);
+    EXPECT_EQ(all.front().start, t0 + 24);
+    EXPECT_EQ(all.back().start, t0 + 38);
+
+    auto window = store.range(0, CandleInterval::S1, t0 + 27, t0 + 34, 100);
+    ASSERT_EQ(window.size(), 4u);
+    EXPECT_EQ(window.front().start, t0 + 28);
+    EXPECT_EQ(window.back().start, t0 + 34);
+
+    auto latest = store.range(0, CandleInterval::S1, t0 + 27, t0 + 34, 2);
+    ASSERT_EQ(latest.size(), 2u);
+    EXPECT_EQ(latest.front().start, t0 + 32);
+    EXPECT_TRUE(store.range(0, CandleInterval::S1, t0 + 100, t0 + 200, 10).empty());
+}
+
+TEST(Candles, RingsGrowAsBarsOpen) {
+    CandleStore store(1000, 256);
+    EXPECT_EQ(store.allocated_bars(), 0u);
+    const int64_t t0 = 1'700'000'000 - 1'700'000'000 % 3600;
+    const std::vector<double> quotes(1000, 1.0);
+    store.update(quotes, at_second(t0));
+    EXPECT_EQ(store.allocated_bars(), 1000 * kCandleIntervals * CandleStore::kFirstRing);
+
+    // Ten minutes grow the 1s ring up to the capacity and the 1m ring once;
+    // the bars kept across each growth read back in order.
+    CandleStore one(1, 256);
+    for (int64_t i = 0; i < 600; ++i) one.update({static_cast<double>(i)}, at_second(t0 + i));
+    EXPECT_EQ(one.allocated_bars(), (8u + 16 + 32 + 64 + 128 + 256) + (8 + 16) + 8 + 8);
+    auto s1 = one.range(0, CandleInterval::S1, INT64_MIN, INT64_MAX, 1000);
+    ASSERT_EQ(s1.size(), 256u);
+    for (std::size_t i = 0; i < s1.size(); ++i) EXPECT_EQ(s1[i].start, t0 + 344 + static_cast<int64_t>(i));
+    EXPECT_EQ(one.range(0, CandleInterval::M1, INT64_MIN, INT64_MAX, 100).size(), 10u);
+}
+
+TEST(Candles, ReadersSeeConsistentBarsWhileTicking) {
+    CandleStore store(1, 64);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int64_t i = 0; i < 200000; ++i) {
+            const double p = static_cast<double>(i % 1000);
+            store.update({p}, at_second(1'700'000'000 + i / 50, static_cast<int>(i % 50) * 20));
+        }
+        done = true;
+    });
+    uint64_t reads = 0;
+    while (!done) {
+        for (const auto& bar : store.range(0, CandleInterval::S1, INT64_MIN, INT64_MAX, 64)) {
+            ASSERT_LE(bar.low, bar.open);
+            ASSERT_LE(bar.low, bar.close);
+            ASSERT_GE(bar.high, bar.open);
+            ASSERT_GE(bar.high, bar.close);
+        }
+        reads++;
+    }
+    writer.join();
+    EXPECT_GT(reads, 0u);
+}
+
+TEST(Candles, EngineFoldsEveryTick) {
+    SimulationConfig config;
+    config.seed = 5;
+    PriceEngine prices(Universe::defaults(), config);
+    for (int i = 0; i < 10; ++i) prices.step();
+    const auto symbol = prices.symbols().find("AAPL");
+    ASSERT_TRUE(symbol);
+    auto bars = prices.candles().range(*symbol, CandleInterval::H1, INT64_MIN, INT64_MAX, 10);
+    ASSERT_FALSE(bars.empty());
+    EXPECT_EQ(bars.back().close, prices.get_quote(*symbol));
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "stock_service.hpp"
+#include "ledger_auditor.hpp"
+#include <algorithm>
 
 class StockTest : public ::testing::Test {
 protected:
@@ -55,10 +57,29 @@ TEST_F(StockTest, SellWithoutOwning) { EXPECT_FALSE(stocks->sell(uid, "AAPL", 1,
 TEST_F(StockTest, ZeroQuantity)      { EXPECT_FALSE(stocks->buy(uid, "AAPL", 0, acc)); }
 TEST_F(StockTest, NegativeQuantity)  { EXPECT_FALSE(stocks->buy(uid, "AAPL", -1, acc)); }
 
+TEST_F(StockTest, RejectedTradeMovesNeitherCashNorShares) {
+    ASSERT_TRUE(stocks->buy(uid, "AAPL", 2, acc));
+    const double balance = bank.get_account_summary(acc)->balance;
+    const auto history = bank.get_history(acc).size();
+
+    EXPECT_FALSE(stocks->sell(uid, "AAPL", 3, acc));       // more than held
+    EXPECT_FALSE(stocks->buy(uid, "AAPL", 1'000'000, acc));  // more than the balance covers
+    auto other = bank.create_account(uid, Currency::USD);
+    EXPECT_FALSE(stocks->sell(uid, "AAPL", 1, other));     // held on another account
+
+    EXPECT_DOUBLE_EQ(bank.get_account_summary(acc)->balance, balance);
+    EXPECT_EQ(bank.get_history(acc).size(), history);
+    EXPECT_TRUE(bank.get_history(other).empty());
+    auto p = stocks->get_portfolio(uid);
+    ASSERT_EQ(p.size(), 1u);
+    EXPECT_EQ(p[0].quantity, 2);
+    EXPECT_EQ(stocks->get_trades(uid).trades.size(), 1u);
+}
+
 TEST_F(StockTest, TradeHistory) {
     stocks->buy(uid, "AAPL", 2, acc);
     stocks->sell(uid, "AAPL", 1, acc);
-    auto t = stocks->get_trades(uid);
+    auto t = stocks->get_trades(uid).trades;
     ASSERT_EQ(t.size(), 2);
     EXPECT_TRUE(t[0].is_buy);
     EXPECT_FALSE(t[1].is_buy);
@@ -84,3 +105,146 @@ TEST_F(StockTest, AvgPriceCalculation) {
 TEST_F(StockTest, WrongUser) {
     EXPECT_FALSE(stocks->buy(999, "AAPL", 1, acc));
 }
+
+TEST_F(StockTest, TradesRecordSymbolIds) {
+    auto aapl = prices.symbols().find("AAPL");
+    ASSERT_TRUE(aapl);
+    EXPECT_EQ(prices.symbols().name(*aapl), "AAPL");
+    EXPECT_FALSE(prices.symbols().find("FAKE"));
+
+    ASSERT_TRUE(stocks->buy(uid, *aapl, 3, acc));
+    auto portfolio = stocks->get_portfolio(uid);
+    ASSERT_EQ(portfolio.size(), 1u);
+    EXPECT_EQ(portfolio[0].symbol, *aapl);
+    EXPECT_EQ(stocks->get_trades(uid).trades[0].symbol, *aapl);
+    EXPECT_EQ(bank.get_history(acc).back().symbol, *aapl);
+    EXPECT_DOUBLE_EQ(prices.get_quote(*aapl), prices.get_quote("AAPL"));
+}
+
+TEST_F(StockTest, ValuationFollowsTicksAndTrades) {
+    ASSERT_TRUE(stocks->buy(uid, "AAPL", 4, acc));
+    ASSERT_TRUE(stocks->buy(uid, "MSFT", 2, acc));
+    auto before = stocks->get_portfolio_snapshot(uid);
+    ASSERT_EQ(before.positions.size(), 2u);
+    EXPECT_DOUBLE_EQ(before.positions[0].market_value, 4 * prices.get_quote("AAPL"));
+    EXPECT_DOUBLE_EQ(before.positions[0].unrealized_pnl, 0.0);
+
+    for (int i = 0; i < 3; ++i) prices.step();
+    auto after = stocks->get_portfolio_snapshot(uid);
+    EXPECT_GT(after.version, before.version);
+    EXPECT_EQ(after.tick, prices.tick());
+    double value = 0, pnl = 0;
+    for (const auto& pos : after.positions) {
+        const double quote = prices.get_quote(prices.symbols().name(pos.symbol));
+        EXPECT_DOUBLE_EQ(pos.mark, quote);
+        EXPECT_DOUBLE_EQ(pos.market_value, quote * pos.quantity);
+        EXPECT_DOUBLE_EQ(pos.unrealized_pnl, (quote - pos.avg_price) * pos.quantity);
+        value += pos.market_value;
+        pnl += pos.unrealized_pnl;
+    }
+    EXPECT_NEAR(after.totals.market_value, value, 1e-9);
+    EXPECT_NEAR(after.totals.unrealized_pnl, pnl, 1e-9);
+
+    // Closing a position drops it from the totals; later ticks leave them alone.
+    ASSERT_TRUE(stocks->sell(uid, "AAPL", 4, acc));
+    prices.step();
+    auto closed = stocks->get_portfolio_snapshot(uid);
+    ASSERT_EQ(closed.positions.size(), 1u);
+    EXPECT_DOUBLE_EQ(closed.totals.market_value, closed.positions[0].market_value);
+    EXPECT_DOUBLE_EQ(closed.totals.cost_basis, 2 * closed.positions[0].avg_price);
+    EXPECT_EQ(stocks->get_portfolio_snapshot(999).version, 0u);
+}
+
+TEST_F(StockTest, AuditorMatchesStockEntriesToTrades) {
+    LedgerAuditor auditor(bank);
+    auditor.check_stocks(*stocks);
+    std::vector<LedgerAlert> alerts;
+    auditor.on_alert([&](const LedgerAlert& alert) { alerts.push_back(alert); });
+
+    const auto aapl = *prices.symbols().find("AAPL");
+    ASSERT_TRUE(stocks->buy(uid, aapl, 5, acc));
+    ASSERT_TRUE(stocks->sell(uid, aapl, 2, acc));
+    // A closed account's trades still count.
+    auto rub = bank.create_account(uid, Currency::RUB);
+    bank.deposit(uid, rub, 100000);
+    ASSERT_TRUE(stocks->buy(uid, "MSFT", 1, rub));
+    ASSERT_TRUE(stocks->sell(uid, "MSFT", 1, rub));
+    bank.withdraw(uid, rub, bank.get_account_summary(rub)->balance);
+    ASSERT_TRUE(bank.close_account(uid, rub));
+    auditor.run_once();
+
+    const uint64_t other = 2;
+    auto other_acc = bank.create_account(other, Currency::USD);
+    bank.deposit(other, other_acc, 10000);
+    ASSERT_TRUE(stocks->settle_match(other, other_acc, uid, acc, aapl, 3, 100.0).ok());
+    auditor.run_once();
+
+    EXPECT_TRUE(alerts.empty());
+    EXPECT_EQ(auditor.metrics().owners_checked, 3u);
+    EXPECT_TRUE(stocks->get_portfolio(uid).empty());
+    EXPECT_EQ(stocks->get_portfolio(other)[0].quantity, 3);
+}
+
+TEST(TradeLog, PagesNewestFirstWithFilters) {
+    // 100 trades one second apart, alternating buy/sell across three symbols.
+    TradeLog log;
+    const TimePoint t0{std::chrono::seconds(1'000'000)};
+    for (int i = 0; i < 100; ++i) {
+        log.append({t0 + std::chrono::seconds(i), static_cast<SymbolId>(i % 3), i % 2 == 0, i + 1, 10.0 + i,
+                    static_cast<uint64_t>(i)});
+    }
+
+    TradeQuery q;
+    q.limit = 30;
+    std::vector<int> seen;
+    for (;;) {
+        auto page = log.query(q);
+        ASSERT_LE(page.trades.size(), 30u);
+        for (auto it = page.trades.rbegin(); it != page.trades.rend(); ++it) seen.push_back(it->quantity);
+        EXPECT_TRUE(std::is_sorted(page.trades.begin(), page.trades.end(),
+                                   [](const Trade& a, const Trade& b) { return a.tick < b.tick; }));
+        if (!page.next_cursor) break;
+        q.before = page.next_cursor;
+    }
+    ASSERT_EQ(seen.size(), 100u);
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(seen[i], 100 - i);
+
+    TradeQuery sells;
+    sells.symbol = 1;
+    sells.is_buy = false;
+    sells.from = t0 + std::chrono::seconds(10);
+    sells.until = t0 + std::chrono::seconds(50);
+    sells.limit = 3;
+    auto page = log.query(sells);
+    ASSERT_EQ(page.trades.size(), 3u);
+    // Symbol 1 sells are i = 1, 7, 13, ...; in [10, 50) that is 13 to 49.
+    EXPECT_EQ(page.trades[0].tick, 37u);
+    EXPECT_EQ(page.trades[2].tick, 49u);
+    EXPECT_EQ(page.trades[2].timestamp, t0 + std::chrono::seconds(49));
+    ASSERT_TRUE(page.next_cursor);
+    sells.before = page.next_cursor;
+    page = log.query(sells);
+    ASSERT_EQ(page.trades.size(), 3u);
+    EXPECT_EQ(page.trades[0].tick, 19u);
+    sells.before = page.next_cursor;
+    page = log.query(sells);
+    ASSERT_EQ(page.trades.size(), 1u);
+    EXPECT_EQ(page.trades[0].tick, 13u);
+    EXPECT_FALSE(page.next_cursor);
+
+    // A side filter alone: buys are the even i, newest first.
+    TradeQuery buys;
+    buys.is_buy = true;
+    buys.limit = 4;
+    page = log.query(buys);
+    ASSERT_EQ(page.trades.size(), 4u);
+    EXPECT_EQ(page.trades[0].tick, 92u);
+    EXPECT_EQ(page.trades[3].tick, 98u);
+    EXPECT_TRUE(std::all_of(page.trades.begin(), page.trades.end(), [](const Trade& t) { return t.is_buy; }));
+    buys.before = page.next_cursor;
+    EXPECT_EQ(log.query(buys).trades.back().tick, 90u);
+
+    TradeQuery unknown;
+    unknown.symbol = 7;
+    EXPECT_TRUE(log.query(unknown).trades.empty());
+}
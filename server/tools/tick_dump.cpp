@@ -0,0 +1,71 @@
+#include "tick_file.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// Decodes a tick file written by MarketRecorder into CSV on stdout:
+//   tick,time_us,<ticker>...,<currency>...
+// With --summary, prints only frame count and compression to stderr.
+
+int main(int argc, char** argv) {
+    std::string path;
+    bool summary = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--summary") summary = true;
+        else path = arg;
+    }
+    if (path.empty()) {
+        std::cerr << "usage: yellowcore_tick_dump [--summary] <file>" << std::endl;
+        return 2;
+    }
+
+    std::string error;
+    auto reader = TickReader::open(path, error);
+    if (!reader) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    if (!summary) {
+        std::cout << "tick,time_us";
+        for (const auto& ticker : reader->tickers()) std::cout << ',' << ticker;
+        for (const auto& code : reader->currencies()) std::cout << ',' << code;
+        std::cout << '\n';
+    }
+
+    TickFrame frame;
+    uint64_t frames = 0;
+    char number[32];
+    while (reader->next(frame)) {
+        frames++;
+        if (summary) continue;
+        std::cout << frame.tick << ',' << frame.time_us;
+        for (double v : frame.quotes) {
+            std::snprintf(number, sizeof number, "%.17g", v);
+            std::cout << ',' << number;
+        }
+        for (double v : frame.usd_rates) {
+            std::snprintf(number, sizeof number, "%.17g", v);
+            std::cout << ',' << number;
+        }
+        std::cout << '\n';
+    }
+
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    long bytes = 0;
+    if (f) {
+        std::fseek(f, 0, SEEK_END);
+        bytes = std::ftell(f);
+        std::fclose(f);
+    }
+    const double raw = static_cast<double>(frames) *
+        (16.0 + 8.0 * static_cast<double>(reader->tickers().size() + reader->currencies().size()));
+    std::cerr << frames << " frames, " << bytes << " bytes";
+    if (frames) std::cerr << ", " << static_cast<double>(bytes) / static_cast<double>(frames)
+                          << " bytes/frame, " << raw / static_cast<double>(bytes) << "x vs raw";
+    if (reader->truncated()) std::cerr << ", truncated after the last complete block";
+    std::cerr << std::endl;
+    return reader->truncated() ? 1 : 0;
+}
@@ -43,6 +43,10 @@
 // << {"status": "ok", "from_balance": 5300.0, "to_balance": 200.0}
 // (при разных валютах — конвертация по текущему курсу, ответ содержит "converted_amount")
 //
+// >> {"type": "batch_transfer", "token": "abc123", "legs": [{"from_account": 100001, "to_account": 100002, "amount": 200.0}, ...]}
+// << {"status": "ok", "results": [{"from_balance": 5300.0, "to_balance": 200.0, "converted_amount": 200.0}, ...]}
+// (все переводы применяются атомарно: либо все, либо ни одного)
+//
 // ------- ИСТОРИЯ -------
 //
 // >> {"type": "get_history", "token": "abc123", "account_id": 100001, "filter_type": "all", "from_date": "...", "to_date": "..."}
@@ -52,12 +56,19 @@
 //
 // >> {"type": "get_exchange_rates", "token": "abc123"}
 // << {"status": "ok", "rates": {"USD_RUB": 92.5, "EUR_RUB": 100.3, "USD_EUR": 0.92, ...}}
+// По одной записи на каждую упорядоченную пару валют из конфигурации сервера.
 //
 // ------- ТОРГОВЛЯ АКЦИЯМИ -------
 //
 // >> {"type": "get_quotes", "token": "abc123"}
 // << {"status": "ok", "quotes": [{"ticker": "AAPL", "price": 178.50}, {"ticker": "GOOGL", "price": 140.20}, ...]}
 //
+// >> {"type": "get_candles", "token": "abc123", "ticker": "AAPL", "interval": "1m", "from": 1700000000, "to": 1700003600, "limit": 100}
+// << {"status": "ok", "candles": [{"timestamp": 1700000040, "open": 178.5, "high": 179.1, "low": 178.2, "close": 178.9}, ...]}
+// interval: "1s", "1m", "5m" или "1h"; from/to (секунды эпохи) и limit необязательны.
+// Возвращаются не более limit последних свечей из диапазона, от старых к новым.
+// Интервалы без тиков свечей не имеют.
+//
 // >> {"type": "buy_stock", "token": "abc123", "ticker": "AAPL", "quantity": 10, "account_id": 100001}
 // << {"status": "ok", "price": 178.50, "total_cost": 1785.0, "new_balance": 3515.0}
 //
@@ -65,15 +76,59 @@
 // << {"status": "ok", "price": 180.00, "total_revenue": 900.0, "new_balance": 4415.0}
 //
 // >> {"type": "get_portfolio", "token": "abc123"}
-// << {"status": "ok", "positions": [{"ticker": "AAPL", "quantity": 5, "avg_price": 178.50, "current_price": 180.00, "pnl": 7.50}, ...]}
+// << {"status": "ok", "positions": [{"ticker": "AAPL", "quantity": 5, "avg_price": 178.50, "current_price": 180.00, "market_value": 900.00, "pnl": 7.50}, ...],
+//     "totals": {"market_value": 900.00, "cost_basis": 892.50, "pnl": 7.50}, "version": 12, "tick": 42}
+// Оценка пересчитывается сервером на каждом тике и сделке; current_price — котировка тика "tick".
+// "version" растёт при каждом изменении оценки, одинаковая версия — одинаковые данные.
+//
+// >> {"type": "get_trades", "token": "abc123", "ticker": "AAPL", "side": "buy", "from_date": "...", "to_date": "...", "limit": 100, "cursor": 57}
+// << {"status": "ok", "trades": [{"timestamp": "...", "ticker": "AAPL", "side": "buy", "quantity": 10, "price": 178.50, "tick": 42}, ...], "next_cursor": 12}
+// Все фильтры необязательны. Страница — последние "limit" (по умолчанию 100, максимум 1000)
+// сделок старше "cursor", по возрастанию времени. Для более старых сделок передайте
+// "next_cursor" как "cursor"; null — сделок больше нет (последняя страница может оказаться
+// пустой). "all": true вместо "limit" возвращает все подходящие сделки одной страницей.
+//
+// ------- ЛИМИТНЫЕ ЗАЯВКИ -------
+//
+// >> {"type": "place_order", "token": "abc123", "ticker": "AAPL", "side": "buy", "price": 178.00, "quantity": 10, "account_id": 100001}
+// << {"status": "ok", "order_id": 7, "filled": 0, "remaining": 10}
+// side: "buy" или "sell"; цена округляется до 0.01. Заявка сразу исполняется против встречных
+// заявок по их цене, остаток встаёт в книгу (приоритет: цена, затем время). На каждом тике рынок
+// исполняет заявки, пересекающие котировку, по цене котировки.
+//
+// >> {"type": "cancel_order", "token": "abc123", "order_id": 7}
+// << {"status": "ok"} | {"status": "error", "message": "Order not found"}
+//
+// >> {"type": "amend_order", "token": "abc123", "order_id": 7, "price": 177.50, "quantity": 5}
+// << {"status": "ok", "order_id": 7, "filled": 0, "remaining": 5}
+// price и quantity необязательны; quantity — новый остаток. Уменьшение остатка по той же цене
+// сохраняет место в очереди, любое другое изменение ставит заявку в конец очереди.
+//
+// ------- СТОП-ЛОСС И ТЕЙК-ПРОФИТ -------
+//
+// >> {"type": "set_trigger", "token": "abc123", "ticker": "AAPL", "kind": "stop_loss", "trigger_price": 170.00, "quantity": 5, "account_id": 100001}
+// << {"status": "ok", "trigger_id": 3}
+// kind: "stop_loss" — продажа по рынку, когда котировка опустится до trigger_price или ниже;
+// "take_profit" — когда поднимется до trigger_price или выше. Срабатывает один раз.
 //
-// >> {"type": "get_trades", "token": "abc123"}
-// << {"status": "ok", "trades": [{"timestamp": "...", "ticker": "AAPL", "side": "buy", "quantity": 10, "price": 178.50}, ...]}
+// >> {"type": "cancel_trigger", "token": "abc123", "trigger_id": 3}
+// << {"status": "ok"} | {"status": "error", "message": "Trigger not found"}
 //
 // ------- PUSH-УВЕДОМЛЕНИЯ (сервер → клиент) -------
 //
 // << {"type": "notification", "event": "price_alert", "ticker": "TSLA", "old_price": 200.0, "new_price": 212.0, "change_pct": 6.0}
 // << {"type": "notification", "event": "incoming_transfer", "from_user": "alice", "amount": 500.0, "currency": "RUB", "account_id": 100001}
+// << {"type": "notification", "event": "order_fill", "order_id": 7, "ticker": "AAPL", "side": "buy", "price": 177.95, "quantity": 10, "remaining": 0}
+// << {"type": "notification", "event": "order_rejected", "order_id": 7, "ticker": "AAPL", "side": "sell", "cancelled": 5}
+// << {"type": "notification", "event": "trigger_fired", "trigger_id": 3, "ticker": "AAPL", "kind": "stop_loss", "trigger_price": 170.0, "quantity": 5, "status": "ok", "price": 169.8, "total_revenue": 849.0, "new_balance": 4264.0}
+// incoming_transfer: зачисление перевода от другого пользователя, во все его сессии; amount — в
+// валюте счёта-получателя. Уведомления медленному клиенту сверх очереди отбрасываются.
+// price_alert: котировка сдвинулась на 5% и больше за один тик; приходит только подключённым
+// владельцам этой бумаги. old_price — котировка предыдущего тика.
+// trigger_fired со "status": "error" — продажа не прошла (например, акций уже нет).
+// order_rejected: расчёт исполнения не прошёл (не хватило средств или акций), остаток заявки снят.
+// Уведомления приходят во все соединения, в которых пользователь выполнил login, пока
+// токен этого login не отозван через logout (из любого соединения).
 //
 // ------- ОБЩИЕ ОШИБКИ -------
 //